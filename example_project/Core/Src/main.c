@@ -50,36 +50,48 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
-//uint8_t spi_buffer_tx[32] = {"TEST DATA SENT FROM MASTER"};
-uint16_t kszRegVal = 0, MAC_low = 0, MAC_mid = 0, MAC_high = 0;
-uint8_t spi_buffer_tx[32] = {0};
-uint8_t spi_buffer_rx[32] = {0};
-uint8_t	uart_buffer_tx[32] = {0};
-uint8_t spi_return = 0;
 KSZ8851_t ksz8851;
-uint8_t mac[KSZ_MAC_ADDRR_LEN] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB};
-uint8_t spi_status1, spi_status2, spi_status3;
-uint8_t counter = 0;
-//void *test;
+uint8_t rx_frame[KSZ_RX_BUFFER_SIZE(KSZ_ETH_MAX_FRAME_SIZE)];
+uint8_t tx_frame[KSZ_ETH_MIN_FRAME_SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,		// broadcast destination
+											0x01, 0x23, 0x45, 0x67, 0x89, 0xAB,		// source, same as KSZ8851_Config_t.MAC_address
+											0x88, 0xB5};								// local experimental ethertype
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-//void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi);
-uint32_t callback_ksz8851_GetTick(void);
-uint8_t callback_ksz8851_SPI_Transmit(uint8_t *pTxBuffer, uint16_t dataLenght);
-uint8_t callback_ksz8851_SPI_TransmitReceive(uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLenght);
-void 	callback_ksz8851_GPIO_Control(uint32_t port, uint16_t pin, uint8_t pinStatus);
+uint32_t callback_ksz8851_GetTick(void *user);
+KSZ8851_Status_t callback_ksz8851_SPI_Transmit(void *user, uint8_t *pTxBuffer, uint16_t dataLength);
+KSZ8851_Status_t callback_ksz8851_SPI_Receive(void *user, uint8_t *pRxBuffer, uint16_t dataLength);
+KSZ8851_Status_t callback_ksz8851_SPI_TransmitReceive(void *user, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);
+void callback_ksz8851_GPIO_Control(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
-KSZ8851_Callbacks_t callbacks = {callback_ksz8851_GetTick,
-								 callback_ksz8851_SPI_Transmit,
-								 callback_ksz8851_SPI_TransmitReceive,
-								 callback_ksz8851_GPIO_Control};
+/* Configuration isn't copied by ksz8851_init, it stays in flash */
+const KSZ8851_Config_t ksz8851_config =
+{
+	.functions =
+	{
+		.TIME_GetTick = callback_ksz8851_GetTick,
+		.SPI_TransmitData = callback_ksz8851_SPI_Transmit,
+		.SPI_ReceiveData = callback_ksz8851_SPI_Receive,
+		.SPI_TransmitReceiveData = callback_ksz8851_SPI_TransmitReceive,
+		.GPIO_Control = callback_ksz8851_GPIO_Control,
+		.user = &hspi1,
+	},
+	.interface =
+	{
+		.cs_port = (uint32_t)SPI1_CS_GPIO_Port,
+		.rst_port = (uint32_t)ETH_NRST_GPIO_Port,
+		.cs_pin = SPI1_CS_Pin,
+		.rst_pin = ETH_NRST_Pin,
+	},
+	.MAC_address = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB},
+	KSZ_CONFIG_PROFILE_DEFAULT,
+};
 
 /* USER CODE END 0 */
 
@@ -114,18 +126,10 @@ int main(void)
   MX_SPI1_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
-//  printf("\e[94m\r\n");
-
-  HAL_GPIO_WritePin(ETH_NRST_GPIO_Port, ETH_NRST_Pin, GPIO_PIN_RESET);
-  HAL_Delay(500);
-  HAL_GPIO_WritePin(ETH_NRST_GPIO_Port, ETH_NRST_Pin, GPIO_PIN_SET);
-
-//  HAL_SetTickFreq(HAL_TICK_FREQ_10HZ);
-
-  ksz8851_init(&ksz8851, (uint32_t)SPI1_CS_GPIO_Port, SPI1_CS_Pin, (uint32_t)ETH_NRST_GPIO_Port, ETH_NRST_Pin, mac, callbacks);
-//  printf("MAC Addrr: %x %x %x %x %x %x \r\n", ksz8851.MAC_address[0], ksz8851.MAC_address[1],
-//		  	  	  	  	  	  	  	  	  	  ksz8851.MAC_address[2], ksz8851.MAC_address[3],
-//											  ksz8851.MAC_address[4], ksz8851.MAC_address[5]);
+  if(ksz8851_init(&ksz8851, &ksz8851_config) != KSZ_OK)
+  {
+	  printf("KSZ8851 INIT ERROR\r\n");
+  }
 
   /* USER CODE END 2 */
 
@@ -133,59 +137,30 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
+	  /* Button sends a broadcast frame */
 	  if(HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin) == false)
 	  {
-		  if(ksz8851_read_register(&ksz8851, KSZ_REG_ADDR_CIDER0, &kszRegVal) == 0)
+		  if(ksz8851_send_frame(&ksz8851, tx_frame, sizeof(tx_frame)) == KSZ_OK)
 		  {
-
-				  ksz8851_read_register(&ksz8851, KSZ_REG_ADDR_CIDER0, &kszRegVal);
-				  printf("\r\nKSZ8851 CHIP ID: %x\r\n", kszRegVal);
-
-				  printf("WRITE NEW MAC ADDRESSES: LOW: %x MIDDLE: %x HIGH: %x\r\n", ksz8851.MAC_Address.Group.low, ksz8851.MAC_Address.Group.middle, ksz8851.MAC_Address.Group.high);
-				  spi_status1 = ksz8851_write_register(&ksz8851, KSZ_REG_ADDR_MARL0, ksz8851.MAC_Address.Group.low);
-				  spi_status1 = ksz8851_write_register(&ksz8851, KSZ_REG_ADDR_MARL0, ksz8851.MAC_Address.Group.low);
-				  spi_status2 = ksz8851_write_register(&ksz8851, KSZ_REG_ADDR_MARM0, ksz8851.MAC_Address.Group.middle);
-				  spi_status3 = ksz8851_write_register(&ksz8851, KSZ_REG_ADDR_MARH0, ksz8851.MAC_Address.Group.high);
-
-				  ksz8851_read_register(&ksz8851, KSZ_REG_ADDR_MARL0, &MAC_low);
-				  printf("NEW MAC ADDR LOW: %x, SPI STATUS: %d\r\n", MAC_low, spi_status1);
-				  ksz8851_read_register(&ksz8851, KSZ_REG_ADDR_MARM0, &MAC_mid);
-				  printf("NEW MAC ADDR MIDDLE: %x, SPI STATUS: %d\r\n", MAC_mid, spi_status2);
-				  ksz8851_read_register(&ksz8851, KSZ_REG_ADDR_MARH0, &MAC_high);
-				  printf("NEW MAC ADDR HIGH: %x, SPI STATUS: %d\r\n", MAC_high, spi_status3);
-
-				  if(ksz8851.MAC_Address.Group.low != MAC_low)
-				  {
-					  printf("WRITING ERROR MAC ADDR LOW! Current: %x, Desired: %x , SPI Comm Status: %d\r\n", MAC_low, ksz8851.MAC_Address.Group.low, spi_status1);
-				  }
-
-				  if(ksz8851.MAC_Address.Group.middle != MAC_mid)
-				  {
-					  printf("WRITING ERROR MAC ADDR MIDDLE! Current: %x, Desired: %x , SPI Comm Status: %d\r\n", MAC_mid, ksz8851.MAC_Address.Group.middle, spi_status2);
-				  }
-
-				  if(ksz8851.MAC_Address.Group.high != MAC_high)
-				  {
-					  printf("WRITING ERROR MAC ADDR HIGH! Current: %x, Desired: %x , SPI Comm Status: %d\r\n", MAC_high, ksz8851.MAC_Address.Group.high, spi_status3);
-				  }
-
-				  ksz8851.MAC_Address.Group.low += 1;
-				  ksz8851.MAC_Address.Group.middle += 1;
-				  ksz8851.MAC_Address.Group.high += 1;
-
-				  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-
-				  HAL_Delay(500);
+			  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
 		  }
 		  else
 		  {
-			  printf("SPI MASTER TX COMM ERROR\r\n");
+			  printf("KSZ8851 TX ERROR\r\n");
 		  }
 
-		  HAL_GPIO_WritePin(SPI1_CS_GPIO_Port, SPI1_CS_Pin, GPIO_PIN_SET);
-
 		  while(HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin) == false);
-		  memset(spi_buffer_rx, 0, sizeof(spi_buffer_rx));
+	  }
+
+	  /* INTRN isn't wired on this board, RXQ is polled */
+	  while(ksz8851_get_rx_frame_count(&ksz8851) != 0)
+	  {
+		  uint16_t frameLength = 0;
+
+		  if(ksz8851_receive_frame(&ksz8851, rx_frame, &frameLength) == KSZ_OK && frameLength != 0)
+		  {
+			  printf("KSZ8851 RX FRAME: %u bytes\r\n", frameLength);
+		  }
 	  }
 
 	  HAL_Delay(200);
@@ -257,37 +232,31 @@ int _write(int file, char *data, int len)
 	return (status == HAL_OK ? len : 0);
 }
 
-//void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
-//{
-//	HAL_GPIO_WritePin(SPI1_CS_GPIO_Port, SPI1_CS_Pin, GPIO_PIN_SET);
-//	HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-//	printf("RECEIVED SPI DATA [MASTER]: %x %x %x %x\r\n", spi_buffer_rx[3], spi_buffer_rx[2], spi_buffer_rx[1], spi_buffer_rx[0]);
-//}
-
-uint32_t callback_ksz8851_GetTick(void)
+uint32_t callback_ksz8851_GetTick(void *user)
 {
+	UNUSED(user);
 	return HAL_GetTick();
 }
 
-uint8_t callback_ksz8851_SPI_Transmit(uint8_t *pTxBuffer, uint16_t dataLenght)
+KSZ8851_Status_t callback_ksz8851_SPI_Transmit(void *user, uint8_t *pTxBuffer, uint16_t dataLength)
+{
+	return (HAL_SPI_Transmit((SPI_HandleTypeDef *)user, pTxBuffer, dataLength, 4000) == HAL_OK) ? KSZ_OK : KSZ_ERROR;
+}
+
+KSZ8851_Status_t callback_ksz8851_SPI_Receive(void *user, uint8_t *pRxBuffer, uint16_t dataLength)
 {
-	uint8_t retStatus = HAL_SPI_Transmit(&hspi1, pTxBuffer, dataLenght, 4000);
-//	HAL_Delay(1);
-	printf("callback_ksz8851_transmit(txBuff: %x %x %x %x, length: %d)\r\n", *(pTxBuffer), *(pTxBuffer+1), *(pTxBuffer+2), *(pTxBuffer+3), dataLenght);
-	return retStatus;
+	return (HAL_SPI_Receive((SPI_HandleTypeDef *)user, pRxBuffer, dataLength, 4000) == HAL_OK) ? KSZ_OK : KSZ_ERROR;
 }
 
-uint8_t callback_ksz8851_SPI_TransmitReceive(uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLenght)
+KSZ8851_Status_t callback_ksz8851_SPI_TransmitReceive(void *user, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
 {
-	uint8_t retStatus = HAL_SPI_TransmitReceive(&hspi1, pTxBuffer, pRxBuffer, dataLenght, 4000);
-	printf("callback_ksz8851_transmitReceive(rxBuff: %x %x %x %x, length: %d)\r\n", *(pRxBuffer), *(pRxBuffer+1), *(pRxBuffer+2), *(pRxBuffer+3), dataLenght);
-//	HAL_Delay(1);
-	return retStatus;
+	return (HAL_SPI_TransmitReceive((SPI_HandleTypeDef *)user, pTxBuffer, pRxBuffer, dataLength, 4000) == HAL_OK) ? KSZ_OK : KSZ_ERROR;
 }
 
-void callback_ksz8851_GPIO_Control(uint32_t port, uint16_t pin, uint8_t pinStatus)
+void callback_ksz8851_GPIO_Control(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus)
 {
-	HAL_GPIO_WritePin((GPIO_TypeDef *)port, pin, pinStatus);
+	UNUSED(user);
+	HAL_GPIO_WritePin((GPIO_TypeDef *)port, pin, (pinStatus == KSZ_GPIO_PIN_SET) ? GPIO_PIN_SET : GPIO_PIN_RESET);
 }
 
 /* USER CODE END 4 */
@@ -21,283 +21,2443 @@ You should have received a copy of the GNU General Public License along with thi
 #include <stdio.h>
 #include <string.h>
 #include "ksz8851.h"
-
+#include "ksz8851_config.h"
+#include "ksz8851_bus.h"
+#include "ksz8851_transport.h"
 /* Variables -----------------------------------------------------------------*/
 
+#define KSZ_REG_DESC(reg_addr, reset, reserved, reg_flags)		[KSZ_REG_DESCRIPTOR_INDEX(reg_addr)] = {(reset), (reserved), (reg_flags)}
+#define KSZ_REG_DESC_WAKEUP_FRAME(n)																		\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##CRC0_0, 0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED),						\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##CRC1_0, 0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED),						\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##BM0_0,  0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED),						\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##BM1_0,  0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED),						\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##BM2_0,  0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED),						\
+	KSZ_REG_DESC(KSZ_REG_ADDR_WF##n##BM3_0,  0x0000, 0x0000, KSZ_REG_FLAG_HOST_OWNED)
+
+/* Register descriptors (ref: KSZ datasheet section 4.2 Register Map). Unlisted addresses are not implemented by the chip */
+static const KSZ8851_Reg_Descriptor_t ksz8851_reg_descriptors[KSZ_REG_DESCRIPTOR_COUNT] =
+{
+	KSZ_REG_DESC(KSZ_REG_ADDR_CCR0,     0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MARL0,    0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MARM0,    0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MARH0,    0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_OBCR0,    0x0000, KSZ_REG_RESERVED_OBCR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_EEPCR0,   0x0000, KSZ_REG_RESERVED_EEPCR,  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MBIR0,    0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_GRR0,     0x0000, KSZ_REG_RESERVED_GRR,    KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_WFCR0,    0x0000, KSZ_REG_RESERVED_WFCR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC_WAKEUP_FRAME(0),
+	KSZ_REG_DESC_WAKEUP_FRAME(1),
+	KSZ_REG_DESC_WAKEUP_FRAME(2),
+	KSZ_REG_DESC_WAKEUP_FRAME(3),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXCR0,    0x0000, KSZ_REG_RESERVED_TXCR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXSR0,    0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXCR1_0,  0x0800, KSZ_REG_RESERVED_RXCR1,  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXCR2_0,  0x0004, KSZ_REG_RESERVED_RXCR2,  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXMIR0,   0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXFHSR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXFHBCR0, 0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXQCR0,   0x0000, KSZ_REG_RESERVED_TXQCR,  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXQCR0,   0x0000, KSZ_REG_RESERVED_RXQCR,  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXFDPR0,  0x0000, KSZ_REG_RESERVED_FDPR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXFDPR0,  0x0000, KSZ_REG_RESERVED_FDPR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXDTTR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXDBCTR0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_IER0,     0x0000, KSZ_REG_RESERVED_IER,    KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_ISR0,     0x0000, KSZ_REG_RESERVED_ISR,    KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_RXFCTR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_TXNTFSR0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MAHTR0_0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MAHTR1_0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MAHTR2_0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_MAHTR3_0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_FCLWR0,   0x0500, KSZ_REG_RESERVED_FCWR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_FCHWR0,   0x0300, KSZ_REG_RESERVED_FCWR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_FCOWR0,   0x0040, KSZ_REG_RESERVED_FCWR,   KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_CIDER0,   KSZ_CHIP_ID, 0x0000,             KSZ_REG_FLAG_READ_ONLY),
+	KSZ_REG_DESC(KSZ_REG_ADDR_CGCR0,    0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_IACR0,    0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_IADLR0,   0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_IADHR0,   0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_PMECR0,   0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_GSWUTR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_PHYRR0,   0x0000, KSZ_REG_RESERVED_PHYRR,  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1MBCR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1MBSR0,  0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_PHY1ILR0, 0x1430, 0x0000,                  KSZ_REG_FLAG_READ_ONLY),
+	KSZ_REG_DESC(KSZ_REG_ADDR_PHY1IHR0, 0x0022, 0x0000,                  KSZ_REG_FLAG_READ_ONLY),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1ANAR0,  0x05E1, KSZ_REG_RESERVED_P1ANAR, KSZ_REG_FLAG_HOST_OWNED),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1ANLPR0, 0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1SCLMD0, 0x0000, 0x0000,                  KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1CR0,    0x00FF, KSZ_REG_RESERVED_P1CR,   KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE),
+	KSZ_REG_DESC(KSZ_REG_ADDR_P1SR0,    0x0000, 0x0000,                  KSZ_REG_FLAG_READ_ONLY | KSZ_REG_FLAG_VOLATILE),
+};
+
+/* Driver configuration values must not touch reserved bits of their registers */
+KSZ_STATIC_ASSERT((KSZ_CONFIG_TX_FR_DPOINTER_AUTO_INC & KSZ_REG_RESERVED_FDPR) == 0, tx_fdpr_config);
+KSZ_STATIC_ASSERT((KSZ_CONFIG_RX_FR_DPOINTER_AUTO_INC & KSZ_REG_RESERVED_FDPR) == 0, rx_fdpr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_TX_CTRL_TX_ENABLE | KSZ_CONFIG_TX_CTRL_CRC_ENABLE | KSZ_CONFIG_TX_CTRL_PAD_ENABLE | KSZ_CONFIG_TX_CTRL_FLOW_ENABLE |
+		KSZ_CONFIG_TX_CTRL_FLUSH_QUEUE | KSZ_CONFIG_TX_CTRL_IP_CHECKSUM | KSZ_CONFIG_TX_CTRL_TCP_CHECKSUM | KSZ_CONFIG_TX_CTRL_UDP_CHECKSUM |
+		KSZ_CONFIG_TX_CTRL_ICMP_CHECKSUM) & KSZ_REG_RESERVED_TXCR) == 0, txcr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_RX_CTRL1_RX_ENABLE | KSZ_CONFIG_RX_CTRL1_INVERSE_FILTER | KSZ_CONFIG_RX_CTRL1_RECEIVE_ALL | KSZ_CONFIG_RX_CTRL1_RECEIVE_UNICAST |
+		KSZ_CONFIG_RX_CTRL1_RECEIVE_ALL_MULTICAST | KSZ_CONFIG_RX_CTRL1_RECEIVE_BROADCAST | KSZ_CONFIG_RX_CTRL1_RECEIVE_MULTICAST |
+		KSZ_CONFIG_RX_CTRL1_ERROR_FR_ENABLE | KSZ_CONFIG_RX_CTRL1_FLOW_ENABLE | KSZ_CONFIG_RX_CTRL1_MAC_FILTER | KSZ_CONFIG_RX_CTRL1_IP_CHECKSUM |
+		KSZ_CONFIG_RX_CTRL1_TCP_CHECKSUM | KSZ_CONFIG_RX_CTRL1_UDP_CHECKSUM | KSZ_CONFIG_RX_CTRL1_FLUSH_QUEUE) & KSZ_REG_RESERVED_RXCR1) == 0, rxcr1_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_RX_CTRL2_BLOCK_SAME_MAC | KSZ_CONFIG_RX_CTRL2_ICMP_CHECKSUM | KSZ_CONFIG_RX_CTRL2_UDP_LITE_CHECKSUM |
+		KSZ_CONFIG_RX_CTRL2_IPV6_UDP_CHECKSUM | KSZ_CONFIG_RX_CTRL2_IPV6_UDP_NOCHECKSUM | KSZ_CONFIG_RX_CTRL2_DATA_BURST_32BYTES |
+		KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN) & KSZ_REG_RESERVED_RXCR2) == 0, rxcr2_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR | KSZ_CONFIG_RX_CMD_START_DMA_ACCESS | KSZ_CONFIG_RX_CMD_AUTO_DEQUEUE_RXQ |
+		KSZ_CONFIG_RX_CMD_FR_COUNT_THR_INT_ENABLE | KSZ_CONFIG_RX_CMD_BYTE_COUNT_THR_INT_ENABLE | KSZ_CONFIG_RX_CMD_DURATION_TIM_THR_ENABLE |
+		KSZ_CONFIG_RX_CMD_IP_TWOBYTE_OFFSET_ENABLE) & KSZ_REG_RESERVED_RXQCR) == 0, rxqcr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_ONCHIP_BUS_CLK_DIVIDEBY_3 | KSZ_CONFIG_ONCHIP_BUS_PIN_STRENG_16MA) & KSZ_REG_RESERVED_OBCR) == 0, obcr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_WATERMARK_4KB | KSZ_CONFIG_WATERMARK_6KB) & KSZ_REG_RESERVED_FCWR) == 0, watermark_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_GLOBAL_SOFT_RESET | KSZ_CONFIG_QMU_MODULE_SOFT_RESET) & KSZ_REG_RESERVED_GRR) == 0, grr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_PORT_AD_10BT_HALF_DUPLEX | KSZ_CONFIG_PORT_AD_10BT_FULL_DUPLEX | KSZ_CONFIG_PORT_AD_100BT_HALF_DUPLEX |
+		KSZ_CONFIG_PORT_AD_100BT_FULL_DUPLEX | KSZ_CONFIG_PORT_AD_FLOW_CONTROL_PAUSE | KSZ_CONFIG_PORT_FORCE_FULL_DUPLEX | KSZ_CONFIG_PORT_FORCE_100_MBIT |
+		KSZ_CONFIG_PORT_AUTO_NEG_ENABLE | KSZ_CONFIG_PORT_FORCE_MDIX | KSZ_CONFIG_PORT_AUTO_MDIX_DISABLE | KSZ_CONFIG_PORT_AUTO_NEG_RESTART |
+		KSZ_CONFIG_PORT_TX_DISABLE | KSZ_CONFIG_PORT_LED_OFF) & KSZ_REG_RESERVED_P1CR) == 0, p1cr_config);
+KSZ_STATIC_ASSERT((KSZ_FLAGS_INTERRUPTS_ALL_CLEAR & KSZ_REG_RESERVED_ISR) == 0, isr_config);
+KSZ_STATIC_ASSERT(((KSZ_CONFIG_WAKEUP_FRAME_ALL | KSZ_CONFIG_WAKEUP_MAGIC_PACKET_ENABLE) & KSZ_REG_RESERVED_WFCR) == 0, wfcr_config);
+KSZ_STATIC_ASSERT(KSZ_REG_ADDR_WF3CRC0_0 == KSZ_REG_ADDR_WF0CRC0_0 + 3 * KSZ_WAKEUP_FRAME_REG_SPACING, wakeup_frame_spacing);
+KSZ_STATIC_ASSERT(KSZ_TX_CONFIG_QUEUE_DEPTH <= 0xFF && KSZ_TX_CONFIG_PRIORITIES <= 0xFF, tx_queue_size);
+
+/* Fast path recognizes requests from the peeked bytes (up to IPv4 protocol) and answers at least ARP requests */
+KSZ_STATIC_ASSERT(KSZ_RX_CONFIG_PEEK_SIZE > KSZ_IPV4_PROTOCOL_OFFSET && KSZ_FASTPATH_CONFIG_MAX_FRAME >= KSZ_ARP_FRAME_SIZE &&
+				  KSZ_FASTPATH_CONFIG_MAX_FRAME <= KSZ_ETH_MAX_FRAME_SIZE, fastpath_config);
+
+/* Frame IDs of tracked frames must be unique, frame ID has 6 bits */
+KSZ_STATIC_ASSERT(KSZ_TX_CONFIG_TRACK_DEPTH > 0 && KSZ_TX_CONFIG_TRACK_DEPTH < KSZ_TX_CTRL_FRAME_ID_MASK + 1, tx_track_depth);
+
+/* Driver RAM: callbacks, pins and MAC address live in KSZ8851_Config_t, which can be const in flash. Runtime state is status register
+ * copies, statistics, flow control marks, TX queues, TX frame ID tracking, UDP flow templates, optional latency histograms, two
+ * pointers, three 32 bit stamps and ten byte flags. With default config it is 672 bytes on 32 bit targets (360 of them TX queues)
+ * and 856 bytes on 64 bit targets, latency histograms add 316 / 408 bytes. Runs of byte flags in front of word aligned members
+ * are padded, 16 bytes on 32 bit targets */
+#ifdef KSZ_HIST_CONFIG_LATENCY
+#define KSZ_LATENCY_STATE_SIZE									(sizeof(KSZ8851_Latency_t) + sizeof(uint32_t))
+#else
+#define KSZ_LATENCY_STATE_SIZE									0
+#endif
+#define KSZ_DRIVER_SCALAR_SIZE									(2 * sizeof(void*) + 3 * sizeof(uint32_t) + 10 * sizeof(uint8_t))
+#define KSZ_DRIVER_PADDING_SIZE									(6 * (sizeof(void*) - 1))	// six runs of byte flags, each padded at most up to pointer alignment
+
+KSZ_STATIC_ASSERT(sizeof(KSZ8851_Registers_t) == 5 * sizeof(uint16_t), registers_size);
+KSZ_STATIC_ASSERT(sizeof(KSZ8851_t) <= sizeof(KSZ8851_Registers_t) + sizeof(KSZ8851_Statistics_t) + sizeof(KSZ8851_Flow_Control_t) +
+				  KSZ_TX_CONFIG_PRIORITIES * sizeof(KSZ8851_TX_Queue_t) + KSZ_TX_CONFIG_TRACK_DEPTH * sizeof(KSZ8851_TX_Track_t) +
+				  KSZ_UDP_CONFIG_MAX_FLOWS * sizeof(KSZ8851_UDP_Flow_t) + KSZ_LATENCY_STATE_SIZE + KSZ_DRIVER_SCALAR_SIZE +
+				  KSZ_DRIVER_PADDING_SIZE, driver_state_size);
+
+/* Exact driver RAM of default queue, tracking, UDP flow and histogram config on 32 bit (ILP32) and 64 bit (LP64) targets, a change
+ * of KSZ8851_t layout must update these numbers and the comment above */
+#if KSZ_TX_CONFIG_PRIORITIES == 3 && KSZ_TX_CONFIG_QUEUE_DEPTH == 8 && KSZ_TX_CONFIG_TRACK_DEPTH == 8 && KSZ_UDP_CONFIG_MAX_FLOWS == 2 && \
+	KSZ_HIST_CONFIG_BUCKETS == 16
+#ifdef KSZ_HIST_CONFIG_LATENCY
+#define KSZ_DRIVER_DEFAULT_SIZE(pointer_size)					(((pointer_size) == 4) ? 988 : ((pointer_size) == 8) ? 1264 : sizeof(KSZ8851_t))
+#else
+#define KSZ_DRIVER_DEFAULT_SIZE(pointer_size)					(((pointer_size) == 4) ? 672 : ((pointer_size) == 8) ? 856 : sizeof(KSZ8851_t))
+#endif
+KSZ_STATIC_ASSERT(sizeof(KSZ8851_t) == KSZ_DRIVER_DEFAULT_SIZE(sizeof(void*)), driver_default_size);
+#endif
+
+/* Single bit fields which reuse flag masks must agree with their shifts */
+KSZ_STATIC_ASSERT(KSZ_FIELD_GET(KSZ_RXFHSR_VALID_MASK, KSZ_RXFHSR_VALID) == 1 && KSZ_FIELD_GET(KSZ_RXFHSR_ICMP_CHECKSUM_ERROR_MASK, KSZ_RXFHSR_ICMP_CHECKSUM_ERROR) == 1, rxfhsr_fields);
+KSZ_STATIC_ASSERT(KSZ_FIELD_GET(KSZ_ISR_LINK_CHANGE_MASK, KSZ_ISR_LINK_CHANGE) == 1 && KSZ_FIELD_GET(KSZ_ISR_SPI_BUS_ERROR_MASK, KSZ_ISR_SPI_BUS_ERROR) == 1, isr_fields);
+KSZ_STATIC_ASSERT(KSZ_FIELD_GET(KSZ_P1SR_LINK_GOOD_MASK, KSZ_P1SR_LINK_GOOD) == 1, p1sr_fields);
+
+/* Highest register address must fit into descriptor table */
+KSZ_STATIC_ASSERT(KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_P1SR1) < KSZ_REG_DESCRIPTOR_COUNT, descriptor_table_size);
+
 /* Private functions prototypes ----------------------------------------------*/
 
-//static uint8_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t *registerValue);
-//static uint8_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t registerValue);
+/* Some specific purpose */
+static bool ksz8851_merge_reserved_bits(KSZ8851_Registers_Addr_t registerAddr, uint16_t *registerValue);
+static uint32_t ksz8851_time_us(KSZ8851_t *driver);
+static void ksz8851_delayUs(KSZ8851_t *driver, uint32_t delay_time);
+static KSZ8851_Status_t ksz8851_wait_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask, uint16_t value, uint32_t timeout_us);
+
+/* Transport of the driver for shared register and fifo routines (ksz8851_transport.h), context is address of KSZ8851_t */
+static KSZ8851_Status_t ksz8851_spi_transmit(void *context, uint8_t *pTxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_spi_receive(void *context, uint8_t *pRxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_spi_transmit_receive(void *context, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_spi_transmit_then_receive(void *context, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength,
+		uint8_t *pRxBuffer, uint16_t rxLength);
+static KSZ8851_Status_t ksz8851_spi_transmit_then_transmit(void *context, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength,
+		uint8_t paddingLength);
+static void ksz8851_spi_begin(void *context);
+static void ksz8851_spi_end(void *context);
+static void ksz8851_reset_pin(void *context, uint8_t pinStatus);
+static void ksz8851_wait_us(void *context, uint32_t delay_time);
+
+/* Register or TX/RX fifo operations */
+static KSZ8851_Status_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t *registerValue);
+static KSZ8851_Status_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t registerValue);
+static KSZ8851_Status_t ksz8851_read_register32(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint32_t *registerValue);
+static KSZ8851_Status_t ksz8851_write_register32(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint32_t registerValue);
+static KSZ8851_Status_t ksz8851_read_fifo(KSZ8851_t *driver, uint8_t *rxBuffer, uint16_t frame_length);
+static KSZ8851_Status_t ksz8851_rx_dma_start(KSZ8851_t *driver);
+static KSZ8851_Status_t ksz8851_rx_dma_stop(KSZ8851_t *driver);
+static KSZ8851_Status_t ksz8851_read_fifo_stream(KSZ8851_t *driver, uint8_t *pPreamble, uint8_t *rxBuffer, uint16_t from, uint16_t to);
+static KSZ8851_Status_t ksz8851_write_fifo(KSZ8851_t *driver, const uint8_t *header, uint8_t header_length, uint8_t *txBuffer, uint16_t frame_length, bool user_buffer);
+
+/* Some specific regsister operations */
+static KSZ8851_Status_t ksz8851_set_registerBits(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask);
+static KSZ8851_Status_t ksz8851_clear_registerBits(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask);
+static KSZ8851_Status_t ksz8851_enable_interrupts(KSZ8851_t *driver, uint16_t register_value);
+static KSZ8851_Status_t ksz8851_disable_interrupts(KSZ8851_t *driver, uint16_t *current_reg_value);
+static KSZ8851_Status_t ksz8851_read_interrupt_status(KSZ8851_t *driver, uint16_t *enabled_interrupts);
+static KSZ8851_Status_t ksz8851_read_rx_frame_header(KSZ8851_t *driver, uint16_t *frame_length);
+static KSZ8851_Status_t ksz8851_release_rx_frame(KSZ8851_t *driver);
+static bool ksz8851_check_rx_frame(KSZ8851_t *driver, uint16_t byte_count);
+static KSZ8851_Status_t ksz8851_service_rx(KSZ8851_t *driver, uint8_t frame_count);
+static KSZ8851_Status_t ksz8851_rx_to_upper_layer(KSZ8851_t *driver, uint16_t byte_count);
+static KSZ8851_Status_t ksz8851_rx_deliver(KSZ8851_t *driver, uint8_t *pRxBuffer, uint16_t frame_length);
+static bool ksz8851_fastpath_candidate(KSZ8851_t *driver, const uint8_t *peek, uint16_t frame_length);
+static bool ksz8851_fastpath_local(KSZ8851_t *driver, const uint8_t *ipv4);
+static uint16_t ksz8851_fastpath_build_reply(KSZ8851_t *driver, uint8_t *frame, uint16_t frame_length);
+static uint16_t ksz8851_checksum_update(uint16_t checksum, uint16_t old_word, uint16_t new_word);
+static KSZ8851_Status_t ksz8851_rx_fastpath(KSZ8851_t *driver, uint8_t *pPreamble, const uint8_t *peek, uint16_t peek_end, uint16_t stream_end, uint16_t frame_length);
+static void ksz8851_set_rx_mode(KSZ8851_t *driver, bool polling);
+static uint32_t ksz8851_wakeup_crc(const KSZ8851_WakeUp_Pattern_t *pattern);
+static void ksz8851_flow_update(KSZ8851_t *driver, uint8_t rx_frame_count);
+static uint32_t ksz8851_take_irq_timestamp(KSZ8851_t *driver);
+static uint32_t ksz8851_timestamp(KSZ8851_t *driver);
+#ifdef KSZ_HIST_CONFIG_LATENCY
+static void ksz8851_histogram_record(KSZ8851_t *driver, KSZ8851_Histogram_t *histogram, uint32_t start);
+#endif
+static KSZ8851_Status_t ksz8851_tx_service(KSZ8851_t *driver);
+static KSZ8851_Status_t ksz8851_tx_wait_space(KSZ8851_t *driver, uint16_t required);
+static bool ksz8851_tx_track_full(KSZ8851_t *driver);
+static void ksz8851_tx_complete(KSZ8851_t *driver, uint16_t tx_status, uint32_t timestamp);
+
+/* Reset operations*/
+static void ksz8851_hard_reset(KSZ8851_t *driver);
+static KSZ8851_Status_t ksz8851_soft_reset(KSZ8851_t *driver, uint8_t soft_reset_type);
+
+/* Private variables ---------------------------------------------------------*/
+
+static const KSZ8851_Transport_t ksz8851_transport =
+{
+	.Transmit				= ksz8851_spi_transmit,
+	.Receive				= ksz8851_spi_receive,
+	.TransmitReceive		= ksz8851_spi_transmit_receive,
+	.TransmitThenReceive	= ksz8851_spi_transmit_then_receive,
+	.TransmitThenTransmit	= ksz8851_spi_transmit_then_transmit,
+	.Begin					= ksz8851_spi_begin,
+	.End					= ksz8851_spi_end,
+	.ResetPin				= ksz8851_reset_pin,
+	.DelayUs				= ksz8851_wait_us,
+};
 
-/* Private functions ---------------------------------------------------------*/
+/* Public functions ----------------------------------------------------------*/
 
 /**
-* @brief Reads internal I/O registers of KSZ8851SNL.
-* @param driver: address of KSZ8851_t struct that contains all driver params.
-* @param register: address of internal register.
-* @param registerValue:
-* @return status of process
+* @brief  Initialize the parameters for KSZ8851 driver. This function must be called after initialization of mcu's peripherals.
+* @param  driver: address of KSZ8851_t struct that defined by user, it holds only runtime state.
+* @param  config: callbacks, pins, MAC address and init profile. It isn't copied, so it can be a const object in flash.
+* @retval status of init process
 */
-//static uint8_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t *registerValue)
-uint8_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t *registerValue)
+KSZ8851_Status_t ksz8851_init(KSZ8851_t *driver, const KSZ8851_Config_t *config)
 {
-	uint32_t tickStart;
-	uint16_t frameBuff = 0;
-	uint8_t  cmdBuff[KSZ_REG_CMD_BUFF_SIZE] = {0};
-	uint8_t  dataBuff[KSZ_REG_DATA_BUFF_SIZE] = {0};
-	uint8_t  returnStatus;
+	uint16_t tmpCurrentRegValue;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	/* Callbacks, GPIO parameters and MAC address are used from config */
+	driver->config				= config;
+
+	memset(&driver->Statistics, 0, sizeof(KSZ8851_Statistics_t));
+	memset(&driver->flow_control, 0, sizeof(KSZ8851_Flow_Control_t));
+	driver->tx_frame_id			= 0;
+	memset(driver->tx_queues, 0, sizeof(driver->tx_queues));
+	memset(driver->udp_flows, 0, sizeof(driver->udp_flows));
+	driver->tx_space_wait		= false;
+	driver->tx_track_head		= 0;
+	driver->tx_track_count		= 0;
+	driver->irq_timestamp_valid	= false;
+	driver->rx_timestamp		= 0;
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	memset(&driver->Latency, 0, sizeof(KSZ8851_Latency_t));
+#endif
+	driver->backpressure		= false;
+	driver->rx_polling			= false;
+	driver->rx_poll_enabled		= (config->functions.POLL_Schedule != NULL);
+	driver->rx_burst_length		= 0;
+
+	/* Step 1: Perform hard reset to KSZ8851SNL */
+	ksz8851_hard_reset(driver);
+
+	/* Step 2: Read device ID until device answers as KSZ8851SNL, it takes as long as the chip needs to leave reset */
+	if(ksz8851_wait_register(driver, KSZ_REG_ADDR_CIDER0, KSZ_CHIP_ID_MASK, KSZ_CHIP_ID, KSZ_TIME_HARD_RESET_TIMEOUT_US) != KSZ_OK)
+	{
+		return KSZ_INIT_ERROR;
+	}
 
-	/*Make chip select output (NSS) pin low before SPI operation*/
-	driver->functions.GPIO_Control(driver->interface.cs_port, driver->interface.cs_pin, KSZ_GPIO_PIN_RESET);
+	/* Step 3: Perform global soft reset */
+	ksz8851_soft_reset(driver, KSZ_CONFIG_GLOBAL_SOFT_RESET);
+
+	/* Step 4: Write QMU MAC_Addres (low, middle, high) */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_MARL0, KSZ_MAKE_U16(config->MAC_address[4], config->MAC_address[5]));
+	ksz8851_write_register(driver, KSZ_REG_ADDR_MARM0, KSZ_MAKE_U16(config->MAC_address[2], config->MAC_address[3]));
+	ksz8851_write_register(driver, KSZ_REG_ADDR_MARH0, KSZ_MAKE_U16(config->MAC_address[0], config->MAC_address[1]));
 
-	/*Shift register addr to bits 9-2 and mask it to make 0 don't care bits*/
-	KSZ_MAKE_FRAME_REG_ADDR(frameBuff, registerAddr);
+#ifdef KSZ_INIT_USE_DEFAULT_DRIVER_SETTINGS
 
-	/* Checks register address whether odd or even and if it's even selects byte 0-1 */
-	KSZ_MAKE_FRAME_REG_BYTES(frameBuff, registerAddr);
+	/* Step 5: Enable QMU transmit frame data pointer auto increment in TXFDPR. Reserved bits are written with their reset values by ksz8851_write_register */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_TXFDPR0, KSZ_CONFIG_TX_FR_DPOINTER_AUTO_INC);
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_TXFDPR0, &tmpCurrentRegValue);
 
-	/* Shifts cmd to frame bits 14-15 */
-	KSZ_MAKE_FRAME_CMD(frameBuff, KSZ8851_READ_REG);
+	/* Step 6: Enable QMU Transmit flow control / Transmit padding / Transmit CRC and IP/TCP/UDP checksum generation.
+	 * ICMP checksum generation stays off, frames of upper layer keep their own ICMP checksums and fast path updates it */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_TXCR0,
+			(KSZ_CONFIG_TX_CTRL_FLOW_ENABLE |
+			KSZ_CONFIG_TX_CTRL_PAD_ENABLE |
+			KSZ_CONFIG_TX_CTRL_CRC_ENABLE |
+			KSZ_CONFIG_TX_CTRL_IP_CHECKSUM |
+			KSZ_CONFIG_TX_CTRL_TCP_CHECKSUM |
+			KSZ_CONFIG_TX_CTRL_UDP_CHECKSUM));
 
-	/*Copy the read register frame to buffer*/
-	cmdBuff[KSZ_REG_BUFF_BYTE0] = (uint8_t)((frameBuff & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE);			//fit MSB byte of cmd (16 bit) variable to one byte
-	cmdBuff[KSZ_REG_BUFF_BYTE1] = (uint8_t)(frameBuff & KSZ_REG_CMD_BYTE1_MASK);										//fit LSB byte of cmd (16 bit) variable to one byte
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_TXCR0, &tmpCurrentRegValue);
 
-	/*Call spi callback function to start spi tx/rx operation*/
-	returnStatus = driver->functions.SPI_TransmitReceiveData(cmdBuff, dataBuff, KSZ_REG_CMD_BUFF_SIZE);
+	/* Step 7: Enable QMU Receive Frame Data Pointer Auto Increment. */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_RXFDPR0, KSZ_CONFIG_RX_FR_DPOINTER_AUTO_INC);
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_RXFDPR0, &tmpCurrentRegValue);
 
-	/*Wait 1mS to be sure SPI packets send and receive completely */
-	tickStart = driver->functions.TIME_GetTick();
-	while(driver->functions.TIME_GetTick() - tickStart < KSZ_TIME_WAIT_1MS);
+	/* Step 8: Configure QMU Receive Frame Threshold for one frame. */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_RXFCTR0, KSZ_CONFIG_RX_FR_CTRL_THRESHOLD_1FR);
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_RXFCTR0, &tmpCurrentRegValue);
 
-	/*Make chip select output (NSS) pin low before SPI operation*/
-	driver->functions.GPIO_Control(driver->interface.cs_port, driver->interface.cs_pin, KSZ_GPIO_PIN_SET);
+	/* Step 9: Receive unicast/multicast(all)/broadcast frames, enable rx flow control, MAC address filter, IP/TCP/UDP checksum verification */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_RXCR1_0,
+			(KSZ_CONFIG_RX_CTRL1_RECEIVE_UNICAST |
+			KSZ_CONFIG_RX_CTRL1_RECEIVE_ALL_MULTICAST |
+			KSZ_CONFIG_RX_CTRL1_RECEIVE_BROADCAST |
+			KSZ_CONFIG_RX_CTRL1_FLOW_ENABLE |
+			KSZ_CONFIG_RX_CTRL1_MAC_FILTER |
+			KSZ_CONFIG_RX_CTRL1_IP_CHECKSUM |
+			KSZ_CONFIG_RX_CTRL1_TCP_CHECKSUM |
+			KSZ_CONFIG_RX_CTRL1_UDP_CHECKSUM));
+
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_RXCR1_0, &tmpCurrentRegValue);
+
+	/* Step 10: Enable QMU Receive UDP Lite frame checksum verification, UDP Lite frame checksum generation, IPv4/IPv6 UDP fragment frame pass, IPv4/IPv6 UDP UDP checksum field is zero pass */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_RXCR2_0,
+			(KSZ_CONFIG_RX_CTRL2_ICMP_CHECKSUM |
+			KSZ_CONFIG_RX_CTRL2_UDP_LITE_CHECKSUM |
+			KSZ_CONFIG_RX_CTRL2_IPV6_UDP_CHECKSUM |
+			KSZ_CONFIG_RX_CTRL2_IPV6_UDP_NOCHECKSUM));
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_RXCR2_0, &tmpCurrentRegValue);
+
+	/* Step 10.1: SPI receive data burst length */
+	ksz8851_set_rx_burst(driver, config->rx_burst);
+
+	/* Step 11: Enable QMU Receive IP Header Two-Byte Offset /Receive Frame Count Threshold/RXQ Auto-Dequeue frame. RXQCR is volatile, it is read before writing */
+	ksz8851_read_register(driver, KSZ_REG_ADDR_RXQCR0, &tmpCurrentRegValue);
+	ksz8851_write_register(driver, KSZ_REG_ADDR_RXQCR0,
+			(KSZ_CONFIG_RX_CMD_AUTO_DEQUEUE_RXQ |
+			KSZ_CONFIG_RX_CMD_FR_COUNT_THR_INT_ENABLE |
+			KSZ_CONFIG_RX_CMD_IP_TWOBYTE_OFFSET_ENABLE | tmpCurrentRegValue));
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_RXQCR0, &tmpCurrentRegValue);
+
+	/* Step 12: Adjusts SPI Data Output (SO) Delay according to SPI master controller configuration. Adjust pin strength */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_OBCR0,
+			(KSZ_CONFIG_ONCHIP_BUS_CLK_DIVIDEBY_1 |
+			KSZ_CONFIG_ONCHIP_BUS_CLK_125MHZ |
+			KSZ_CONFIG_ONCHIP_BUS_PIN_STRENG_8MA));
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_OBCR0, &tmpCurrentRegValue);
+
+	/* Step 13: Restart Port 1 auto-negotiation */
+	ksz8851_read_register(driver, KSZ_REG_ADDR_P1CR0, &tmpCurrentRegValue);
+	ksz8851_write_register(driver, KSZ_REG_ADDR_P1CR0, (KSZ_CONFIG_PORT_AUTO_NEG_RESTART | tmpCurrentRegValue));
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_P1CR0, &tmpCurrentRegValue);
+
+	/* Step 13.1: Force link in half duplex if auto-negotiation is failed (e.g. KSZ8851 is connected to the Hub) */
+	ksz8851_read_register(driver, KSZ_REG_ADDR_P1CR0, &tmpCurrentRegValue);
+
+	if((tmpCurrentRegValue & KSZ_CONFIG_PORT_AUTO_NEG_RESTART) != KSZ_CONFIG_PORT_AUTO_NEG_RESTART)
+	{
+		ksz8851_write_register(driver, KSZ_REG_ADDR_P1CR0, (tmpCurrentRegValue | KSZ_CONFIG_PORT_FORCE_FULL_DUPLEX));		// force PHY in full duplex mdoe
+//		ksz8851_read_register(driver, KSZ_REG_ADDR_P1CR0, &tmpCurrentRegValue);
+	}
+
+	/* Step 14: Clear the interrupts status, ISR bits are cleared by writing 1 so it doesn't need to be read */
+	ksz8851_write_register(driver, KSZ_REG_ADDR_ISR0, KSZ_FLAGS_INTERRUPTS_ALL_CLEAR);
+//	ksz8851_read_register(driver, KSZ_REG_ADDR_ISR0, &tmpCurrentRegValue);
+
+	/* Step 14.1: Configure flow control watermarks according to host RX drain rate, they are built in driver state to save stack */
+	ksz8851_flow_control_defaults(&driver->flow_control, config->rx_drain_rate_kBps);
+	ksz8851_set_flow_control(driver, &driver->flow_control);
+
+	/* Step 17: Enable interrupts of init profile (e.g. link change, receive, receive overrun), and TX done if it is reported */
+	ksz8851_enable_interrupts(driver, config->interrupts | ((config->functions.TX_FrameDone != NULL) ? KSZ_FLAGS_INTERRUPTS_TX : 0));
+
+	/* Step 19: Enable QMU transmit */
+	ksz8851_set_registerBits(driver, KSZ_REG_ADDR_TXCR0, KSZ_CONFIG_TX_CTRL_TX_ENABLE);
+
+	/* Step 20: Enable QMU receive */
+	ksz8851_set_registerBits(driver, KSZ_REG_ADDR_RXCR1_0, KSZ_CONFIG_RX_CTRL1_RX_ENABLE);
+
+	/* Step 21: Keep initial link status, later changes are reported by link change interrupt */
+	ksz8851_read_register(driver, KSZ_REG_ADDR_P1SR0, &tmpCurrentRegValue);
+	driver->Registers.Status.Port1 = tmpCurrentRegValue;
+
+	driver->rx_mode_tick = driver->config->functions.TIME_GetTick(driver->config->functions.user);
 
-	/*Order data. While data is transferred in the MSB first mode in the SPI cycle, byte0 is the first byte to appear and the byte 3 is the last byte for the data phase.*/
-	*registerValue = (uint16_t)((dataBuff[KSZ_REG_BUFF_BYTE3] << KSZ_1BYTE_SHIFTING_VALUE) | dataBuff[KSZ_REG_BUFF_BYTE2]);
+#endif			// KSZ_INIT_USE_DEFAULT_DRIVER_SETTINGS
 
-	return returnStatus;
+	return result;
 }
 
 /**
-* @brief  Writes internal I/O registers of KSZ8851SNL.
-* @param  driver: address of KSZ8851_t struct that contains all driver params.
-* @param  register: address of internal register.
-* @retval status of process
+* @brief  Writes a frame to TXQ and enqueues it for transmission. CRC and padding are added by the chip.
+* 		  It bypasses the priority queues of ksz8851_tx_enqueue.
+* @param  driver: address of KSZ8851_t struct.
+* @param  txBuffer: ethernet frame starting from destination MAC address.
+* @param  frame_length: frame length without CRC, KSZ_ETH_MIN_FRAME_SIZE .. KSZ_ETH_MAX_FRAME_SIZE.
+* @retval KSZ_OK, KSZ_BUSY if TXQ memory is not enough, KSZ_ERROR
 */
-//static uint8_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t registerValue)
-uint8_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_t registerAddr, uint16_t registerValue)
+KSZ8851_Status_t ksz8851_send_frame(KSZ8851_t *driver, uint8_t *txBuffer, uint16_t frame_length)
 {
-	uint32_t tickStart;
-	uint16_t frameBuff = 0;
-	uint8_t  cmdBuff[KSZ_REG_CMD_BUFF_SIZE] = {0};
-	uint8_t  returnStatus;
+	uint16_t tmpTxMemAvailable;
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	uint32_t tmpStart = ksz8851_timestamp(driver);
+#endif
+	KSZ8851_Status_t result;
 
-	/*Make chip select output (NSS) pin low before SPI operation*/
-	driver->functions.GPIO_Control(driver->interface.cs_port, driver->interface.cs_pin, KSZ_GPIO_PIN_RESET);
+	if(frame_length < KSZ_ETH_MIN_FRAME_SIZE || frame_length > KSZ_ETH_MAX_FRAME_SIZE)
+	{
+		return KSZ_ERROR;
+	}
 
-	/*Shift register addr to bits 9-2 and mask it to make 0 don't care bits*/
-	KSZ_MAKE_FRAME_REG_ADDR(frameBuff, registerAddr);
+	/* Frame is written with 4 bytes control/byte count header and dword padding, TXQ must have room for all of them */
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_TXMIR0, &tmpTxMemAvailable);
 
-	/* Checks register address whether odd or even and if it's even selects byte 0-1 */
-	KSZ_MAKE_FRAME_REG_BYTES(frameBuff, registerAddr);
+	if((tmpTxMemAvailable & KSZ_TXMIR_AVAILABLE_MASK) < (KSZ_TX_FIFO_HEADER_SIZE + KSZ_DWORD_ALIGN(frame_length)) || ksz8851_tx_track_full(driver))
+	{
+		driver->Statistics.tx_busy++;
+		return KSZ_BUSY;
+	}
 
-	/* Shifts cmd to frame bits 14-15 */
-	KSZ_MAKE_FRAME_CMD(frameBuff, KSZ8851_WRITE_REG);
+	result |= ksz8851_write_fifo(driver, NULL, 0, txBuffer, frame_length, true);
 
-	/*Copy the read register frame to buffer*/
-	cmdBuff[KSZ_REG_BUFF_BYTE0] = (uint8_t)((frameBuff & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE);			//fit MSB byte of cmd (16 bit) variable to one byte
-	cmdBuff[KSZ_REG_BUFF_BYTE1] = (uint8_t)(frameBuff & KSZ_REG_CMD_BYTE1_MASK);										//fit LSB byte of cmd (16 bit) variable to one byte
-	cmdBuff[KSZ_REG_BUFF_BYTE2] = (uint8_t)(registerValue & KSZ_REG_CMD_BYTE1_MASK);									//fit LSB byte of data (16 bit) variable to one byte
-	cmdBuff[KSZ_REG_BUFF_BYTE3] = (uint8_t)((registerValue & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE);		//fit MSB byte of data (16 bit) variable to one byte
+	if(result == KSZ_OK)
+	{
+		driver->Statistics.tx_frames++;
+#ifdef KSZ_HIST_CONFIG_LATENCY
+		ksz8851_histogram_record(driver, &driver->Latency.tx_enqueue, tmpStart);
+#endif
+	}
 
-	/*Call spi callback function to start spi tx operation*/
-	returnStatus = driver->functions.SPI_TransmitData(cmdBuff, KSZ_REG_CMD_BUFF_SIZE);
+	return result;
+}
 
-	/*Wait 1mS to be sure SPI packets send completely */
-	tickStart = driver->functions.TIME_GetTick();
-	while(driver->functions.TIME_GetTick() - tickStart < KSZ_TIME_WAIT_1MS);
+/**
+* @brief  Puts a frame into a strict priority TX queue and writes queued frames to TXQ while it has room. A frame is sent
+* 		  only when all higher priority queues are empty, so control and real-time frames pass bulk frames waiting in
+* 		  software. Buffer must stay valid until TX_BufferReleased callback. Must be called under the same serialization
+* 		  as ksz8851_irq_handler, which continues sending when TXQ memory becomes available.
+* @param  driver: address of KSZ8851_t struct.
+* @param  priority: 0 (highest) .. KSZ_TX_CONFIG_PRIORITIES - 1
+* @param  txBuffer: ethernet frame starting from destination MAC address.
+* @param  frame_length: frame length without CRC, KSZ_ETH_MIN_FRAME_SIZE .. KSZ_ETH_MAX_FRAME_SIZE.
+* @retval KSZ_OK, KSZ_BUSY if the queue is full, KSZ_ERROR for invalid priority or frame length
+*/
+KSZ8851_Status_t ksz8851_tx_enqueue(KSZ8851_t *driver, uint8_t priority, uint8_t *txBuffer, uint16_t frame_length)
+{
+	KSZ8851_TX_Queue_t *queue;
+	KSZ8851_TX_Entry_t *entry;
 
-	/*Make chip select output (NSS) pin low before SPI operation*/
-	driver->functions.GPIO_Control(driver->interface.cs_port, driver->interface.cs_pin, KSZ_GPIO_PIN_SET);
+	if(priority >= KSZ_TX_CONFIG_PRIORITIES || frame_length < KSZ_ETH_MIN_FRAME_SIZE || frame_length > KSZ_ETH_MAX_FRAME_SIZE)
+	{
+		return KSZ_ERROR;
+	}
+
+	queue = &driver->tx_queues[priority];
+
+	if(queue->count >= KSZ_TX_CONFIG_QUEUE_DEPTH)
+	{
+		queue->rejected++;
+		return KSZ_BUSY;
+	}
+
+	entry = &queue->entries[(queue->head + queue->count) % KSZ_TX_CONFIG_QUEUE_DEPTH];
+	entry->buffer	= txBuffer;
+	entry->length	= frame_length;
+	entry->tick		= driver->config->functions.TIME_GetTick(driver->config->functions.user);
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	entry->stamp	= ksz8851_timestamp(driver);
+#endif
+
+	queue->count++;
+	queue->enqueued++;
 
-	return returnStatus;
+	if(queue->count > queue->high_water)
+	{
+		queue->high_water = queue->count;
+	}
+
+	/* Frame is accepted even if TXQ is full now, it is sent by the TX space available interrupt */
+	ksz8851_tx_service(driver);
+
+	return KSZ_OK;
 }
 
 /**
- * @brief Perform KSZ8851 hardware reset
- * @param driver
- */
-void ksz8851_hard_reset(KSZ8851_t *driver)
+* @brief  Builds Ethernet / IPv4 / UDP headers of a flow once, so datagrams of it are sent by ksz8851_udp_send.
+* @param  driver: address of KSZ8851_t struct.
+* @param  flow: addresses and ports of the flow, source MAC is KSZ8851_Config_t.MAC_address.
+* @param  handle: flow handle, filled by function.
+* @retval KSZ_OK, KSZ_BUSY if all KSZ_UDP_CONFIG_MAX_FLOWS flows are used
+*/
+KSZ8851_Status_t ksz8851_udp_flow_register(KSZ8851_t *driver, const KSZ8851_UDP_Flow_Config_t *flow, uint8_t *handle)
 {
-	uint32_t tickStart;
-	/*Pull reset output of mcu LOW state. KSZ reset input is active low logic*/
-	driver->functions.GPIO_Control(driver->interface.rst_port, driver->interface.rst_pin, KSZ_GPIO_PIN_RESET);
+	uint8_t *header;
+	uint8_t slot;
 
-	/*Wait 1mS to be sure SPI packets send completely */
-	tickStart = driver->functions.TIME_GetTick();
-	while(driver->functions.TIME_GetTick() - tickStart < KSZ_TIME_WAIT_1MS);
+	for(slot = 0; slot < KSZ_UDP_CONFIG_MAX_FLOWS; slot++)
+	{
+		if(!driver->udp_flows[slot].used)
+		{
+			break;
+		}
+	}
+
+	if(slot == KSZ_UDP_CONFIG_MAX_FLOWS)
+	{
+		return KSZ_BUSY;
+	}
+
+	header = driver->udp_flows[slot].header;
+	memset(header, 0, KSZ_UDP_TEMPLATE_SIZE);
+
+	memcpy(header, flow->dst_MAC, KSZ_MAC_ADDRR_LEN);
+	memcpy(&header[KSZ_ETH_SRC_MAC_OFFSET], driver->config->MAC_address, KSZ_MAC_ADDRR_LEN);
+	header[KSZ_ETH_TYPE_OFFSET]				= (uint8_t)(KSZ_ETH_TYPE_IPV4 >> KSZ_1BYTE_SHIFTING_VALUE);
+	header[KSZ_ETH_TYPE_OFFSET + 1]			= (uint8_t)KSZ_ETH_TYPE_IPV4;
+
+	header[KSZ_IPV4_VER_IHL_OFFSET]			= KSZ_IPV4_VER_IHL_NO_OPTIONS;
+	header[KSZ_IPV4_TOS_OFFSET]				= flow->tos;
+	header[KSZ_IPV4_FRAGMENT_OFFSET]		= (uint8_t)(KSZ_IPV4_DONT_FRAGMENT >> KSZ_1BYTE_SHIFTING_VALUE);
+	header[KSZ_IPV4_TTL_OFFSET]				= (flow->ttl != 0) ? flow->ttl : KSZ_IPV4_DEFAULT_TTL;
+	header[KSZ_IPV4_PROTOCOL_OFFSET]		= KSZ_IPV4_PROTOCOL_UDP;
+	memcpy(&header[KSZ_IPV4_SRC_OFFSET], flow->src_ipv4, KSZ_IPV4_ADDR_SIZE);
+	memcpy(&header[KSZ_IPV4_DST_OFFSET], flow->dst_ipv4, KSZ_IPV4_ADDR_SIZE);
 
-	/*Make output HIGH*/
-	driver->functions.GPIO_Control(driver->interface.rst_port, driver->interface.rst_pin, KSZ_GPIO_PIN_SET);
+	header[KSZ_UDP_SRC_PORT_OFFSET]			= (uint8_t)(flow->src_port >> KSZ_1BYTE_SHIFTING_VALUE);
+	header[KSZ_UDP_SRC_PORT_OFFSET + 1]		= (uint8_t)flow->src_port;
+	header[KSZ_UDP_DST_PORT_OFFSET]			= (uint8_t)(flow->dst_port >> KSZ_1BYTE_SHIFTING_VALUE);
+	header[KSZ_UDP_DST_PORT_OFFSET + 1]		= (uint8_t)flow->dst_port;
 
-	tickStart = driver->functions.TIME_GetTick();
-	while(driver->functions.TIME_GetTick() - tickStart < KSZ_TIME_WAIT_1MS);
+	driver->udp_flows[slot].ip_id	= 0;
+	driver->udp_flows[slot].used	= true;
+	*handle = slot;
+
+	return KSZ_OK;
 }
 
-uint8_t ksz8851_soft_reset(KSZ8851_t *driver)
+/**
+* @brief  Frees a flow handle.
+* @param  driver: address of KSZ8851_t struct.
+* @param  handle: handle from ksz8851_udp_flow_register.
+* @retval KSZ_OK, KSZ_ERROR for invalid handle
+*/
+KSZ8851_Status_t ksz8851_udp_flow_unregister(KSZ8851_t *driver, uint8_t handle)
 {
+	if(handle >= KSZ_UDP_CONFIG_MAX_FLOWS || !driver->udp_flows[handle].used)
+	{
+		return KSZ_ERROR;
+	}
+
+	driver->udp_flows[handle].used = false;
 
-	return 0;
+	return KSZ_OK;
 }
 
-///**
-// *
-// * @param value
-// * @return
-// */
-//uint16_t ksz8851_byte16_swap(uint16_t value)
-//{
-//	return (value >> 8) | (value << 8);
-//}
+/**
+* @brief  Sends a UDP datagram on a registered flow. Length and ID fields of the template are patched, checksums are generated
+* 		  by TXQ (KSZ_CONFIG_TX_CTRL_IP_CHECKSUM / UDP_CHECKSUM set by ksz8851_init), and headers and payload are written in
+* 		  one fifo transfer. Payload is copied to TXQ before return.
+* @param  driver: address of KSZ8851_t struct.
+* @param  handle: handle from ksz8851_udp_flow_register.
+* @param  payload: UDP payload.
+* @param  payload_length: 0 .. KSZ_UDP_MAX_PAYLOAD.
+* @retval KSZ_OK, KSZ_BUSY if TXQ memory is not enough, KSZ_ERROR for invalid handle or length
+*/
+KSZ8851_Status_t ksz8851_udp_send(KSZ8851_t *driver, uint8_t handle, uint8_t *payload, uint16_t payload_length)
+{
+	KSZ8851_UDP_Flow_t *flow;
+	uint16_t tmpTxMemAvailable, tmpLength;
+	uint16_t tmpFrameLength = KSZ_UDP_TEMPLATE_SIZE + payload_length;
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	uint32_t tmpStart = ksz8851_timestamp(driver);
+#endif
+	KSZ8851_Status_t result;
+
+	if(handle >= KSZ_UDP_CONFIG_MAX_FLOWS || !driver->udp_flows[handle].used || payload_length > KSZ_UDP_MAX_PAYLOAD)
+	{
+		return KSZ_ERROR;
+	}
+
+	flow = &driver->udp_flows[handle];
 
-/* Public functions ----------------------------------------------------------*/
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_TXMIR0, &tmpTxMemAvailable);
+
+	if((tmpTxMemAvailable & KSZ_TXMIR_AVAILABLE_MASK) < (KSZ_TX_FIFO_HEADER_SIZE + KSZ_DWORD_ALIGN(tmpFrameLength)) || ksz8851_tx_track_full(driver))
+	{
+		driver->Statistics.tx_busy++;
+		return KSZ_BUSY;
+	}
+
+	/* Checksums are cleared, TXQ fills them in */
+	tmpLength = KSZ_IPV4_HEADER_SIZE + KSZ_UDP_HEADER_SIZE + payload_length;
+	flow->header[KSZ_IPV4_TOTAL_LEN_OFFSET]		= (uint8_t)(tmpLength >> KSZ_1BYTE_SHIFTING_VALUE);
+	flow->header[KSZ_IPV4_TOTAL_LEN_OFFSET + 1]	= (uint8_t)tmpLength;
+	flow->header[KSZ_IPV4_ID_OFFSET]			= (uint8_t)(flow->ip_id >> KSZ_1BYTE_SHIFTING_VALUE);
+	flow->header[KSZ_IPV4_ID_OFFSET + 1]		= (uint8_t)flow->ip_id;
+	flow->header[KSZ_IPV4_CHECKSUM_OFFSET]		= 0;
+	flow->header[KSZ_IPV4_CHECKSUM_OFFSET + 1]	= 0;
+
+	tmpLength = KSZ_UDP_HEADER_SIZE + payload_length;
+	flow->header[KSZ_UDP_LENGTH_OFFSET]			= (uint8_t)(tmpLength >> KSZ_1BYTE_SHIFTING_VALUE);
+	flow->header[KSZ_UDP_LENGTH_OFFSET + 1]		= (uint8_t)tmpLength;
+	flow->header[KSZ_UDP_CHECKSUM_OFFSET]		= 0;
+	flow->header[KSZ_UDP_CHECKSUM_OFFSET + 1]	= 0;
+
+	result |= ksz8851_write_fifo(driver, flow->header, KSZ_UDP_TEMPLATE_SIZE, payload, tmpFrameLength, true);
+
+	if(result == KSZ_OK)
+	{
+		flow->ip_id++;
+		driver->Statistics.tx_frames++;
+#ifdef KSZ_HIST_CONFIG_LATENCY
+		ksz8851_histogram_record(driver, &driver->Latency.tx_enqueue, tmpStart);
+#endif
+	}
+
+	return result;
+}
 
 /**
-* @brief  Initialize the parameters for KSZ8851 driver. This function must be called after initialization of mcu's peripherals.
-* @param  controller: address of KSZ8851_Driver_Init_t struct that defined by user.
-* @param  cs_port: chip select (slave select) port.
-* @param  cs_pin: chip select (slave select) pin number.
-* @param  rst_port: KSZ8851 hardware reset control port.
-* @param  rst_pin: KSZ8851 hardware reset control pin.
-* @param  MAC_address: Ethernet MAC address of the device.
-* @param  callbacks: the callback functions defined by user in MCU layer to send data over SPI and to control MCU GPIO's (chip select and hardware reset)
-* @retval status of init process
+* @brief  Reads present frame from RXQ. Frames with error status are released without reading.
+* @param  driver: address of KSZ8851_t struct.
+* @param  rxBuffer: at least KSZ_RX_BUFFER_SIZE(KSZ_ETH_MAX_FRAME_SIZE) bytes.
+* @param  frame_length: length of received frame without CRC, 0 if frame is dropped.
+* @retval status of process
 */
-uint8_t ksz8851_init(KSZ8851_t *driver, uint32_t cs_port, uint16_t cs_pin, uint32_t rst_port, uint16_t rst_pin, uint8_t *MAC_address, KSZ8851_Callbacks_t callbacks)
+KSZ8851_Status_t ksz8851_receive_frame(KSZ8851_t *driver, uint8_t *rxBuffer, uint16_t *frame_length)
 {
-	uint16_t deviceID = 0;
-	uint16_t tmpReadRegister;
-	uint8_t tryCounter = 0;
-	uint8_t returnValue = false;
+	uint16_t tmpByteCount;
+	KSZ8851_Status_t result;
 
-	/* SPI's slave select GPIO parameters */
-	driver->interface.cs_port 	= cs_port;
-	driver->interface.cs_pin 	= cs_pin;
+	*frame_length = 0;
 
-	/* KSZ8851 NRST (hard reset) input's GPIO parameters */
-	driver->interface.rst_port	= rst_port;
-	driver->interface.rst_pin	= rst_pin;
+	result = ksz8851_read_rx_frame_header(driver, &tmpByteCount);
 
-	/* Addresses of user callback functions to control SPI and GPIO */
-	driver->functions 			= callbacks;
+	/* Bad frames are released by their header status, their payload never crosses spi bus */
+	if(!ksz8851_check_rx_frame(driver, tmpByteCount))
+	{
+		return result | ksz8851_release_rx_frame(driver);
+	}
 
-	memcpy((uint8_t*)driver->MAC_Address.bytes, (uint8_t*)MAC_address, KSZ_MAC_ADDRR_LEN);
+	result |= ksz8851_read_fifo(driver, rxBuffer, tmpByteCount);
 
-	do
+	if(result == KSZ_OK)
 	{
-		/* Step 1: Perform hard reset to KSZ8851SNL */
-		ksz8851_hard_reset(driver);
+		*frame_length = tmpByteCount - KSZ_ETH_CRC_SIZE;
+		driver->Statistics.rx_frames++;
+	}
 
-		/* Step 2: Perform global soft reset */
+	return result;
+}
 
-		/* Step 3: Read device ID to be sure device is KSZ8851SNL */
-		ksz8851_read_register(driver, KSZ_REG_ADDR_CIDER0, &deviceID);
+/**
+* @brief  Returns number of frames waiting in RXQ.
+*/
+uint8_t ksz8851_get_rx_frame_count(KSZ8851_t *driver)
+{
+	uint16_t tmpCurrentRegValue = 0;
 
-		tryCounter++;
+	ksz8851_read_register(driver, KSZ_REG_ADDR_RXFCTR0, &tmpCurrentRegValue);
 
-	/* if received value don't match, do this 3 time */
-	}while(((deviceID & KSZ_CHIP_ID_MASK) != KSZ_CHIP_ID) && tryCounter <= KSZ_PROCESS_TRY_LIMIT);
+	return (uint8_t)(tmpCurrentRegValue >> KSZ_RXFCTR_FRAME_COUNT_SHIFT);
+}
 
-	tryCounter = 0;
+/**
+* @brief  Programs a wake-up frame pattern into a free filter slot (WF0 .. WF3). Byte masks and CRC of the selected
+* 		  bytes are computed by driver. Matching frames set KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME.
+* @param  driver: address of KSZ8851_t struct.
+* @param  pattern: pattern description.
+* @param  filter_no: used filter slot, can be NULL.
+* @retval KSZ_OK, KSZ_BUSY if all filters are used, KSZ_ERROR if pattern doesn't fit filter window
+*/
+KSZ8851_Status_t ksz8851_wakeup_set_filter(KSZ8851_t *driver, const KSZ8851_WakeUp_Pattern_t *pattern, uint8_t *filter_no)
+{
+	uint32_t tmpByteMask[2] = {0};
+	uint16_t tmpControl, tmpBaseAddr;
+	uint8_t  slot, i;
+	KSZ8851_Status_t result;
 
-	/* Step 4: Write QMU MAC_Addres (low, middle, high) */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_MARL0, KSZ_BYTE_SWAP_U16(driver->MAC_Address.Group.low));
-	ksz8851_write_register(driver, KSZ_REG_ADDR_MARM0, KSZ_BYTE_SWAP_U16(driver->MAC_Address.Group.middle));
-	ksz8851_write_register(driver, KSZ_REG_ADDR_MARH0, KSZ_BYTE_SWAP_U16(driver->MAC_Address.Group.high));
+	if(pattern->length == 0 || (pattern->offset + pattern->length) > KSZ_WAKEUP_FRAME_WINDOW_SIZE)
+	{
+		return KSZ_ERROR;
+	}
 
-	/* Step 5: Enable QMU transmit frame data pointer auto increment in TXFDPR */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_TXFDPR0, KSZ_CONFIG_TX_FR_DPOINTER_AUTO_INC);
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_WFCR0, &tmpControl);
 
-	/* Step 6: Enable QMU Transmit flow control / Transmit padding / Transmit CRC and IP/TCP/UDP checksum generation. */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_TXCR0,
-			KSZ_CONFIG_TX_CTRL_FLOW_ENABLE |
-			KSZ_CONFIG_TX_CTRL_PAD_ENABLE |
-			KSZ_CONFIG_TX_CTRL_CRC_ENABLE |
-			KSZ_CONFIG_TX_CTRL_IP_CHECKSUM |
-			KSZ_CONFIG_TX_CTRL_TCP_CHECKSUM |
-			KSZ_CONFIG_TX_CTRL_UDP_CHECKSUM);
+	for(slot = 0; slot < KSZ_WAKEUP_FRAME_FILTER_COUNT; slot++)
+	{
+		if((tmpControl & (KSZ_CONFIG_WAKEUP_FRAME0_ENABLE << slot)) == 0)
+		{
+			break;
+		}
+	}
 
-	/* Step 7: Enable QMU Receive Frame Data Pointer Auto Increment. */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_RXFDPR0, KSZ_CONFIG_RX_FR_DPOINTER_AUTO_INC);
+	if(slot == KSZ_WAKEUP_FRAME_FILTER_COUNT)
+	{
+		return KSZ_BUSY;
+	}
 
-	/* Step 8: Configure QMU Receive Frame Threshold for one frame. */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_RXFCTR0, KSZ_CONFIG_RX_FR_CTRL_THRESHOLD_1FR);
+	/* Byte mask bit n selects frame byte n, BM0 holds bytes 0-15 ... BM3 holds bytes 48-63 */
+	for(i = 0; i < pattern->length; i++)
+	{
+		if(pattern->mask == NULL || (pattern->mask[i >> 3] & (1 << (i & 0x07))))
+		{
+			tmpByteMask[(pattern->offset + i) >> 5] |= (uint32_t)1 << ((pattern->offset + i) & 0x1F);
+		}
+	}
 
-	/* Step 9: Receive unicast/multicast(all)/broadcast frames, enable rx flow control, MAC address filter, IP/TCP/UDP checksum verification */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_RXCR1_0,
-			KSZ_CONFIG_RX_CTRL1_RECEIVE_UNICAST |
-			KSZ_CONFIG_RX_CTRL1_RECEIVE_ALL_MULTICAST |
-			KSZ_CONFIG_RX_CTRL1_RECEIVE_BROADCAST |
-			KSZ_CONFIG_RX_CTRL1_FLOW_ENABLE |
-			KSZ_CONFIG_RX_CTRL1_MAC_FILTER |
-			KSZ_CONFIG_RX_CTRL1_IP_CHECKSUM |
-			KSZ_CONFIG_RX_CTRL1_TCP_CHECKSUM |
-			KSZ_CONFIG_RX_CTRL1_UDP_CHECKSUM);
+	if(tmpByteMask[0] == 0 && tmpByteMask[1] == 0)
+	{
+		return KSZ_ERROR;
+	}
 
-	/* Step 10: Enable QMU Receive UDP Lite frame checksum verification, UDP Lite frame checksum generation, IPv4/IPv6 UDP fragment frame pass, IPv4/IPv6 UDP UDP checksum field is zero pass, and single frame data burst */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_RXCR2_0,
-			KSZ_CONFIG_RX_CTRL2_ICMP_CHECKSUM |
-			KSZ_CONFIG_RX_CTRL2_UDP_LITE_CHECKSUM |
-			KSZ_CONFIG_RX_CTRL2_IPV6_UDP_CHECKSUM |
-			KSZ_CONFIG_RX_CTRL2_IPV6_UDP_NOCHECKSUM |
-			KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN);
+	/* CRC0/CRC1, BM0/BM1 and BM2/BM3 are dword aligned register pairs */
+	tmpBaseAddr = KSZ_REG_ADDR_WF0CRC0_0 + slot * KSZ_WAKEUP_FRAME_REG_SPACING;
 
-	/* Step 11: Enable QMU Receive IP Header Two-Byte Offset /Receive Frame Count Threshold/RXQ Auto-Dequeue frame */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_RXQCR0,
-			KSZ_CONFIG_RX_CMD_AUTO_DEQUEUE_RXQ |
-			KSZ_CONFIG_RX_CMD_FR_COUNT_THR_INT_ENABLE |
-			KSZ_CONFIG_RX_CMD_IP_TWOBYTE_OFFSET_ENABLE);
+	result |= ksz8851_write_register32(driver, (KSZ8851_Registers_Addr_t)tmpBaseAddr, ksz8851_wakeup_crc(pattern));
+	result |= ksz8851_write_register32(driver, (KSZ8851_Registers_Addr_t)(tmpBaseAddr + (KSZ_REG_ADDR_WF0BM0_0 - KSZ_REG_ADDR_WF0CRC0_0)), tmpByteMask[0]);
+	result |= ksz8851_write_register32(driver, (KSZ8851_Registers_Addr_t)(tmpBaseAddr + (KSZ_REG_ADDR_WF0BM2_0 - KSZ_REG_ADDR_WF0CRC0_0)), tmpByteMask[1]);
 
-	/* Step 12: Adjusts SPI Data Output (SO) Delay according to SPI master controller configuration. Adjust pin strength */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_OBCR0,
-			KSZ_CONFIG_ONCHIP_BUS_CLK_DIVIDEBY_1 |
-			KSZ_CONFIG_ONCHIP_BUS_CLK_125MHZ |
-			KSZ_CONFIG_ONCHIP_BUS_PIN_STRENG_8MA);
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_WFCR0, tmpControl | (KSZ_CONFIG_WAKEUP_FRAME0_ENABLE << slot));
+	result |= ksz8851_set_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME);
 
-	/* Step 13: Restart Port 1 auto-negotiation */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_P1CR0, KSZ_CONFIG_PORT_AUTO_NEG_RESTART);
+	if(filter_no != NULL)
+	{
+		*filter_no = slot;
+	}
 
-	/* Step 13.1: Force link in half duplex if auto-negotiation is failed (e.g. KSZ8851 is connected to the Hub) */
-	ksz8851_read_register(driver, KSZ_REG_ADDR_P1CR0, &tmpReadRegister);
+	return result;
+}
 
-	if((tmpReadRegister & KSZ_CONFIG_PORT_AUTO_NEG_RESTART) != KSZ_CONFIG_PORT_AUTO_NEG_RESTART)
+/**
+* @brief  Disables a wake-up frame filter slot, so it can be used again.
+*/
+KSZ8851_Status_t ksz8851_wakeup_clear_filter(KSZ8851_t *driver, uint8_t filter_no)
+{
+	uint16_t tmpControl;
+	KSZ8851_Status_t result;
+
+	if(filter_no >= KSZ_WAKEUP_FRAME_FILTER_COUNT)
 	{
-		ksz8851_write_register(driver, KSZ_REG_ADDR_P1CR0, (tmpReadRegister | KSZ_CONFIG_PORT_FORCE_FULL_DUPLEX));		// force PHY in full duplex mdoe
+		return KSZ_ERROR;
 	}
 
-	/* Step 14: Clear the interrupts status */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_ISR0, KSZ_FLAGS_INTERRUPTS_ALL_CLEAR);
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_WFCR0, &tmpControl);
+
+	tmpControl &= ~(KSZ_CONFIG_WAKEUP_FRAME0_ENABLE << filter_no);
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_WFCR0, tmpControl);
+
+	if((tmpControl & KSZ_CONFIG_WAKEUP_FRAME_ALL) == 0)
+	{
+		result |= ksz8851_clear_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Enables or disables magic packet detection.
+*/
+KSZ8851_Status_t ksz8851_wakeup_set_magic_packet(KSZ8851_t *driver, bool enable)
+{
+	KSZ8851_Status_t result;
+
+	if(enable)
+	{
+		result = ksz8851_set_registerBits(driver, KSZ_REG_ADDR_WFCR0, KSZ_CONFIG_WAKEUP_MAGIC_PACKET_ENABLE);
+		result |= ksz8851_set_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET);
+	}
+	else
+	{
+		result = ksz8851_clear_registerBits(driver, KSZ_REG_ADDR_WFCR0, KSZ_CONFIG_WAKEUP_MAGIC_PACKET_ENABLE);
+		result |= ksz8851_clear_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Derives flow control watermarks from host RX drain rate. RXQ fills with the difference of line rate and drain rate
+* 		  while host is late (KSZ_FLOW_CONFIG_SERVICE_LATENCY_US), pause frames must start before that headroom is used.
+* @param  flow: watermarks, filled by function.
+* @param  drain_rate_kBps: rate which host reads RXQ in kbytes/s.
+*/
+void ksz8851_flow_control_defaults(KSZ8851_Flow_Control_t *flow, uint32_t drain_rate_kBps)
+{
+	uint32_t fillRate, headroom;
+
+	fillRate = (drain_rate_kBps < KSZ_ETH_LINE_RATE_KBPS) ? (KSZ_ETH_LINE_RATE_KBPS - drain_rate_kBps) : 0;
+
+	/* kbytes/s * us / 1000 = bytes. Link partner may still send two frames after pause frame is sent */
+	headroom = (fillRate * KSZ_FLOW_CONFIG_SERVICE_LATENCY_US) / 1000 + 2 * KSZ_ETH_WIRE_FRAME_SIZE;
+
+	if(headroom > KSZ_RXQ_SIZE / 2)
+	{
+		headroom = KSZ_RXQ_SIZE / 2;
+	}
+
+	flow->overrun_watermark			= KSZ_CONFIG_WATERMARK_OVERRUN_DEFAULT;
+	flow->high_watermark			= (uint16_t)headroom;
+	flow->low_watermark				= (uint16_t)(headroom + 2 * KSZ_ETH_WIRE_FRAME_SIZE);
+
+	/* Application is told to slow down when RXQ is as full as it is at high watermark with maximum size frames */
+	flow->backpressure_on_frames	= (uint8_t)((KSZ_RXQ_SIZE - flow->high_watermark) / KSZ_ETH_WIRE_FRAME_SIZE);
+	flow->backpressure_off_frames	= flow->backpressure_on_frames / 2;
+}
+
+/**
+* @brief  Writes flow control watermarks to FCLWR, FCHWR and FCOWR and sets backpressure marks.
+* @retval KSZ_OK, KSZ_ERROR if watermarks aren't ordered (overrun < high < low < RXQ size)
+*/
+KSZ8851_Status_t ksz8851_set_flow_control(KSZ8851_t *driver, const KSZ8851_Flow_Control_t *flow)
+{
+	KSZ8851_Status_t result;
+
+	if(!(flow->overrun_watermark < flow->high_watermark && flow->high_watermark < flow->low_watermark &&
+		 flow->low_watermark < KSZ_RXQ_SIZE && flow->backpressure_off_frames < flow->backpressure_on_frames))
+	{
+		return KSZ_ERROR;
+	}
+
+	/* FCLWR and FCHWR are a dword aligned register pair */
+	result = ksz8851_write_register32(driver, KSZ_REG_ADDR_FCLWR0,
+			((uint32_t)((flow->high_watermark / KSZ_CONFIG_WATERMARK_UNIT) & KSZ_CONFIG_WATERMARK_MASK) << 16) |
+			((flow->low_watermark / KSZ_CONFIG_WATERMARK_UNIT) & KSZ_CONFIG_WATERMARK_MASK));
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_FCOWR0, (flow->overrun_watermark / KSZ_CONFIG_WATERMARK_UNIT) & KSZ_CONFIG_WATERMARK_MASK);
+
+	driver->flow_control = *flow;
+
+	return result;
+}
+
+/**
+* @brief  Selects SPI RX data burst length. Fifo reads are split into transactions of that size.
+* @param  driver: address of KSZ8851_t struct.
+* @param  burst: KSZ_CONFIG_RX_CTRL2_DATA_BURST_4BYTES/8BYTES/16BYTES/32BYTES or KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN
+* @retval KSZ_OK, KSZ_ERROR for unknown burst value
+*/
+KSZ8851_Status_t ksz8851_set_rx_burst(KSZ8851_t *driver, uint16_t burst)
+{
+	uint16_t tmpCurrentRegValue;
+	KSZ8851_Status_t result;
+
+	if((burst & ~KSZ_CONFIG_RX_CTRL2_DATA_BURST_MASK) != 0 || burst > KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN)
+	{
+		return KSZ_ERROR;
+	}
 
-	/* Step 14.1: */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_FCLWR0, KSZ_CONFIG_WATERMARK_4KB);
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_RXCR2_0, &tmpCurrentRegValue);
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_RXCR2_0, (tmpCurrentRegValue & ~KSZ_CONFIG_RX_CTRL2_DATA_BURST_MASK) | burst);
+
+	/* 4 << field gives 4, 8, 16, 32 bytes; single frame burst reads whole frame in one transaction */
+	if(burst == KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN)
+	{
+		driver->rx_burst_length = 0;
+	}
+	else
+	{
+		driver->rx_burst_length = (uint8_t)(KSZ_DWORD_VALUE << (burst >> KSZ_CONFIG_RX_CTRL2_DATA_BURST_SHIFT));
+	}
 
-	/* Step 14.2: */
-	ksz8851_write_register(driver, KSZ_REG_ADDR_FCHWR0, KSZ_CONFIG_WATERMARK_6KB);
+	return result;
+}
 
-	/* Step 17: */
+/**
+* @brief  Drains up to budget frames from RXQ in polling mode. When RXQ is empty, RX interrupt is enabled again and
+* 		  driver returns to interrupt mode. Must be called under the same serialization as ksz8851_irq_handler.
+* @param  driver: address of KSZ8851_t struct.
+* @param  budget: maximum number of frames handed over in this call.
+* @param  processed: number of frames taken from RXQ, can be NULL.
+* @retval status of process
+*/
+KSZ8851_Status_t ksz8851_poll(KSZ8851_t *driver, uint8_t budget, uint8_t *processed)
+{
+	uint8_t tmpFrameCount;
+	KSZ8851_Status_t result;
 
-	/* Step 19: */
+	if(processed != NULL)
+	{
+		*processed = 0;
+	}
 
-	/* Step 20: */
+	if(!driver->rx_polling)
+	{
+		return KSZ_OK;
+	}
 
-	/* Step 21: */
+	driver->Statistics.rx_polls++;
+	driver->rx_timestamp = ksz8851_take_irq_timestamp(driver);
 
-	/* Step 22: */
+	/* Clear RX status first, so a frame received after counting asserts INTRN as soon as RX interrupt is enabled */
+	result = ksz8851_write_register(driver, KSZ_REG_ADDR_ISR0, KSZ_FLAGS_INTERRUPTS_RX);
 
+	tmpFrameCount = ksz8851_get_rx_frame_count(driver);
 
+	if(tmpFrameCount > budget)
+	{
+		result |= ksz8851_service_rx(driver, budget);
+	}
+	else
+	{
+		result |= ksz8851_service_rx(driver, tmpFrameCount);
+		result |= ksz8851_set_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX);
+		ksz8851_set_rx_mode(driver, false);
+	}
 
+	if(processed != NULL)
+	{
+		*processed = (tmpFrameCount > budget) ? budget : tmpFrameCount;
+	}
 
-	return returnValue;
+	return result;
+}
+
+/**
+* @brief  Returns true while RX is in polling mode.
+*/
+bool ksz8851_is_polling(KSZ8851_t *driver)
+{
+	return driver->rx_polling;
+}
+
+/**
+* @brief  Allows polling mode without POLL_Schedule callback, for callers which check ksz8851_is_polling and call ksz8851_poll
+* 		  by themselves (e.g. ksz8851_service). Without it and POLL_Schedule, ksz8851_irq_handler never enters polling mode.
+* @param  driver: address of KSZ8851_t struct.
+*/
+void ksz8851_enable_polling(KSZ8851_t *driver)
+{
+	driver->rx_poll_enabled = true;
+}
+
+/**
+* @brief  Services KSZ8851 interrupt. Must be called from thread context (main loop or driver task) after INTRN pin goes low,
+* 		  since it performs spi transactions. Received frames are handed over by RX_GetBuffer / RX_FrameReceived callbacks.
+* @param  driver: address of KSZ8851_t struct.
+* @retval status of process
+*/
+KSZ8851_Status_t ksz8851_irq_handler(KSZ8851_t *driver)
+{
+	uint16_t tmpInterruptStatus, tmpCurrentRegValue;
+	uint32_t tmpTimestamp;
+	uint8_t  tmpFrameCount;
+	KSZ8851_Status_t result;
+
+	/* Timestamp is taken before spi transactions, frames serviced below arrived before it */
+	tmpTimestamp = ksz8851_take_irq_timestamp(driver);
+
+	result = ksz8851_read_interrupt_status(driver, NULL);
+	tmpInterruptStatus = driver->Registers.Status.Interrupt & KSZ_FLAGS_INTERRUPTS_ALL_CLEAR;
+
+	if(tmpInterruptStatus == 0)
+	{
+		return result;
+	}
+
+	/* ISR bits are cleared by writing 1, clear them before servicing so events during service assert INTRN again */
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_ISR0, tmpInterruptStatus);
+
+	if(tmpInterruptStatus & KSZ_FLAGS_INTERRUPTS_LINK_CHANGE)
+	{
+		result |= ksz8851_read_register(driver, KSZ_REG_ADDR_P1SR0, &tmpCurrentRegValue);
+		driver->Registers.Status.Port1 = tmpCurrentRegValue;
+
+		if(driver->config->functions.LINK_StatusChanged != NULL)
+		{
+			driver->config->functions.LINK_StatusChanged(driver->config->functions.user, KSZ_FIELD_GET(tmpCurrentRegValue, KSZ_P1SR_LINK_GOOD));
+		}
+	}
+
+	if((tmpInterruptStatus & (KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME | KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET)) &&
+	   driver->config->functions.WAKEUP_Detected != NULL)
+	{
+		driver->config->functions.WAKEUP_Detected(driver->config->functions.user,
+				tmpInterruptStatus & (KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME | KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET));
+	}
+
+	if(tmpInterruptStatus & KSZ_FLAGS_INTERRUPTS_RX_OVERRUN)
+	{
+		driver->Statistics.rx_overruns++;
+	}
+
+	if((tmpInterruptStatus & KSZ_FLAGS_INTERRUPTS_TX) && driver->config->functions.TX_FrameDone != NULL)
+	{
+		result |= ksz8851_read_register(driver, KSZ_REG_ADDR_TXSR0, &tmpCurrentRegValue);
+		driver->Registers.Status.Tx = tmpCurrentRegValue;
+
+		ksz8851_tx_complete(driver, tmpCurrentRegValue, tmpTimestamp);
+
+		/* Queued frames may wait for a free frame ID */
+		result |= ksz8851_tx_service(driver);
+	}
+
+	if(tmpInterruptStatus & KSZ_FLAGS_INTERRUPTS_TX_SPACE_AVAILABLE)
+	{
+		driver->tx_space_wait = false;
+		result |= ksz8851_tx_service(driver);
+	}
+
+	/* RXQ belongs to ksz8851_poll in polling mode */
+	if((tmpInterruptStatus & KSZ_FLAGS_INTERRUPTS_RX) && !driver->rx_polling)
+	{
+		driver->rx_timestamp = tmpTimestamp;
+		tmpFrameCount = ksz8851_get_rx_frame_count(driver);
+
+		/* Polling mode is entered only if somebody calls ksz8851_poll, a bare irq handler user keeps servicing RX inline */
+		if(KSZ_POLL_CONFIG_ENTER_FRAMES != 0 && driver->rx_poll_enabled && tmpFrameCount >= KSZ_POLL_CONFIG_ENTER_FRAMES)
+		{
+			/* Heavy load: mask RX interrupt and let upper layer drain RXQ with budget */
+			result |= ksz8851_clear_registerBits(driver, KSZ_REG_ADDR_IER0, KSZ_FLAGS_INTERRUPTS_RX);
+			ksz8851_set_rx_mode(driver, true);
+
+			if(driver->config->functions.POLL_Schedule != NULL)
+			{
+				driver->config->functions.POLL_Schedule(driver->config->functions.user);
+			}
+		}
+		else
+		{
+			result |= ksz8851_service_rx(driver, tmpFrameCount);
+		}
+	}
+
+	/* INTRN is an edge for the host. An event between reading and clearing ISR keeps INTRN low without a new edge, so if an enabled
+	 * interrupt is still pending, IER is cleared and written back: INTRN goes high and falls again */
+	result |= ksz8851_read_interrupt_status(driver, &tmpCurrentRegValue);
+
+	if((driver->Registers.Status.Interrupt & tmpCurrentRegValue) != 0)
+	{
+		result |= ksz8851_disable_interrupts(driver, NULL);
+		result |= ksz8851_enable_interrupts(driver, tmpCurrentRegValue);
+	}
+
+	return result;
+}
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+/**
+* @brief  Copies latency histograms. Must be called under the same serialization as ksz8851_irq_handler.
+* @param  driver: address of KSZ8851_t struct.
+* @param  snapshot: histograms, filled by function.
+* @param  reset: clears histograms after copying, so next snapshot covers a new interval.
+*/
+void ksz8851_latency_snapshot(KSZ8851_t *driver, KSZ8851_Latency_t *snapshot, bool reset)
+{
+	*snapshot = driver->Latency;
+
+	if(reset)
+	{
+		memset(&driver->Latency, 0, sizeof(KSZ8851_Latency_t));
+	}
+}
+
+/**
+* @brief  Returns upper bound of the bucket that holds given percentile of recorded values, e.g. 99 for tail latency.
+* @retval latency in TIME_Timestamp units, 0 if histogram is empty
+*/
+uint32_t ksz8851_histogram_percentile(const KSZ8851_Histogram_t *histogram, uint8_t percent)
+{
+	uint32_t tmpRank, tmpSum = 0;
+	uint8_t  i;
+
+	if(histogram->count == 0)
+	{
+		return 0;
+	}
+
+	/* Rank of the percentile value, rounded up; 64 bit product doesn't overflow for any count */
+	tmpRank = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+
+	for(i = 0; i < KSZ_HIST_CONFIG_BUCKETS - 1; i++)
+	{
+		tmpSum += histogram->buckets[i];
+
+		if(tmpSum >= tmpRank)
+		{
+			return (i == 0) ? 0 : ((1UL << i) - 1);
+		}
+	}
+
+	return histogram->max;
+}
+#endif
+
+/**
+* @brief  Takes RX timestamp at interrupt entry. It can be called from INTRN falling edge interrupt, it doesn't touch spi.
+* 		  Without it, ksz8851_irq_handler takes the timestamp when it starts.
+* @param  driver: address of KSZ8851_t struct.
+*/
+void ksz8851_irq_timestamp(KSZ8851_t *driver)
+{
+	if(driver->config->functions.TIME_Timestamp != NULL)
+	{
+		driver->irq_timestamp		= driver->config->functions.TIME_Timestamp(driver->config->functions.user);
+		driver->irq_timestamp_valid	= true;
+	}
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Puts reset value of reserved bits into the value that will be written, so register doesn't have to be read before writing.
+ * 		   It is done only for host owned registers which chip doesn't change, their reserved bits are still equal to reset value.
+ * @param  registerAddr: address of internal register.
+ * @param  registerValue: value that will be written, reserved bits are replaced.
+ * @return true if reserved bits merged, false if register has no reserved bits or it must be read before writing.
+ */
+static bool ksz8851_merge_reserved_bits(KSZ8851_Registers_Addr_t registerAddr, uint16_t *registerValue)
+{
+	const KSZ8851_Reg_Descriptor_t *descriptor = &ksz8851_reg_descriptors[KSZ_REG_DESCRIPTOR_INDEX(registerAddr)];
+
+	if(descriptor->reserved_mask == 0 || (descriptor->flags & (KSZ_REG_FLAG_HOST_OWNED | KSZ_REG_FLAG_VOLATILE)) != KSZ_REG_FLAG_HOST_OWNED)
+	{
+		return false;
+	}
+
+	*registerValue = (*registerValue & ~descriptor->reserved_mask) | (descriptor->reset_value & descriptor->reserved_mask);
+
+	return true;
+}
+
+/**
+ * @brief  Returns driver time base in microseconds. Without TIME_GetTickUs it has TIME_GetTick (ms) resolution, differences of
+ * 		   two values are still correct when the counter wraps.
+ * @param  driver
+ * @return time in us
+ */
+static uint32_t ksz8851_time_us(KSZ8851_t *driver)
+{
+	if(driver->config->functions.TIME_GetTickUs != NULL)
+	{
+		return driver->config->functions.TIME_GetTickUs(driver->config->functions.user);
+	}
+
+	return driver->config->functions.TIME_GetTick(driver->config->functions.user) * KSZ_TIME_US_PER_MS;
+}
+
+/**
+ * @brief  Waits at least delay_time, calls TIME_Yield while waiting.
+ * @param  driver
+ * @param  delay_time: us
+ */
+static void ksz8851_delayUs(KSZ8851_t *driver, uint32_t delay_time)
+{
+	uint32_t tickStart = ksz8851_time_us(driver);
+
+	while(ksz8851_time_us(driver) - tickStart < delay_time)
+	{
+		if(driver->config->functions.TIME_Yield != NULL)
+		{
+			driver->config->functions.TIME_Yield(driver->config->functions.user);
+		}
+	}
+}
+
+/**
+ * @brief  Reads a register until masked bits are equal to value, calls TIME_Yield between reads.
+ * @param  driver
+ * @param  registerAddr
+ * @param  bit_mask
+ * @param  value: expected value of masked bits
+ * @param  timeout_us
+ * @return KSZ_OK, KSZ_TIMEOUT if register doesn't reach value in timeout_us, or spi error
+ */
+static KSZ8851_Status_t ksz8851_wait_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask, uint16_t value, uint32_t timeout_us)
+{
+	uint16_t tmpCurrentRegValue;
+	uint32_t tickStart = ksz8851_time_us(driver);
+	KSZ8851_Status_t result;
+
+	while(1)
+	{
+		result = ksz8851_read_register(driver, registerAddr, &tmpCurrentRegValue);
+
+		if(result != KSZ_OK || (tmpCurrentRegValue & bit_mask) == value)
+		{
+			return result;
+		}
+
+		if(ksz8851_time_us(driver) - tickStart >= timeout_us)
+		{
+			return KSZ_TIMEOUT;
+		}
+
+		if(driver->config->functions.TIME_Yield != NULL)
+		{
+			driver->config->functions.TIME_Yield(driver->config->functions.user);
+		}
+	}
+}
+
+/**
+ * @brief  Transmits data by SPI_TransmitData callback.
+ * @param  context: address of KSZ8851_t struct
+ */
+static KSZ8851_Status_t ksz8851_spi_transmit(void *context, uint8_t *pTxBuffer, uint16_t dataLength)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	return driver->config->functions.SPI_TransmitData(driver->config->functions.user, pTxBuffer, dataLength);
+}
+
+/**
+ * @brief  Receives data by SPI_ReceiveData callback.
+ * @param  context: address of KSZ8851_t struct
+ */
+static KSZ8851_Status_t ksz8851_spi_receive(void *context, uint8_t *pRxBuffer, uint16_t dataLength)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	return driver->config->functions.SPI_ReceiveData(driver->config->functions.user, pRxBuffer, dataLength);
+}
+
+/**
+ * @brief  Transmits and receives data by SPI_TransmitReceiveData callback.
+ * @param  context: address of KSZ8851_t struct
+ */
+static KSZ8851_Status_t ksz8851_spi_transmit_receive(void *context, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	return driver->config->functions.SPI_TransmitReceiveData(driver->config->functions.user, pTxBuffer, pRxBuffer, dataLength);
+}
+
+/**
+ * @brief  Transmits then receives into two buffers inside one chip select period. It is one chained transfer if port has
+ * 		   SPI_TransmitThenReceive, otherwise SPI_TransmitData and SPI_ReceiveData are called.
+ * @param  context: address of KSZ8851_t struct
+ */
+static KSZ8851_Status_t ksz8851_spi_transmit_then_receive(void *context, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength,
+		uint8_t *pRxBuffer, uint16_t rxLength)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	if(driver->config->functions.SPI_TransmitThenReceive == NULL)
+	{
+		return ksz8851_transport_split_receive(&ksz8851_transport, context, pTxBuffer, txLength, pRxHeader, rxHeaderLength, pRxBuffer, rxLength);
+	}
+
+	return driver->config->functions.SPI_TransmitThenReceive(driver->config->functions.user, pTxBuffer, txLength, pRxHeader, rxHeaderLength,
+			pRxBuffer, rxLength);
+}
+
+/**
+ * @brief  Transmits two buffers and dword padding inside one chip select period. It is one chained transfer if port has
+ * 		   SPI_TransmitThenTransmit, otherwise SPI_TransmitData is called for each part.
+ * @param  context: address of KSZ8851_t struct
+ */
+static KSZ8851_Status_t ksz8851_spi_transmit_then_transmit(void *context, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength,
+		uint8_t paddingLength)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	if(driver->config->functions.SPI_TransmitThenTransmit == NULL)
+	{
+		return ksz8851_transport_split_transmit(&ksz8851_transport, context, pHeader, headerLength, pTxBuffer, dataLength, paddingLength);
+	}
+
+	return driver->config->functions.SPI_TransmitThenTransmit(driver->config->functions.user, pHeader, headerLength, pTxBuffer, dataLength,
+			paddingLength);
+}
+
+/**
+ * @brief  Starts spi transaction. If the chip shares spi bus with other KSZ8851 instances, waits until bus is granted to this instance.
+ * @param  context: address of KSZ8851_t struct
+ */
+static void ksz8851_spi_begin(void *context)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	if(driver->bus != NULL)
+	{
+		ksz8851_bus_acquire(driver->bus, driver->bus_slot);
+	}
+
+#if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
+	/*Make chip select output (NSS) pin low before SPI operation*/
+	driver->config->functions.GPIO_Control(driver->config->functions.user, driver->config->interface.cs_port, driver->config->interface.cs_pin, KSZ_GPIO_PIN_RESET);
+#endif
+}
+
+/**
+ * @brief  Ends spi transaction and hands shared spi bus over to next waiting instance.
+ * @param  context: address of KSZ8851_t struct
+ */
+static void ksz8851_spi_end(void *context)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+#if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
+	/*Make chip select output (NSS) pin high after SPI operation*/
+	driver->config->functions.GPIO_Control(driver->config->functions.user, driver->config->interface.cs_port, driver->config->interface.cs_pin, KSZ_GPIO_PIN_SET);
+#endif
+
+	if(driver->bus != NULL)
+	{
+		ksz8851_bus_release(driver->bus, driver->bus_slot);
+	}
+}
+
+/**
+ * @brief  Drives reset input (RSTN) of the chip.
+ * @param  context: address of KSZ8851_t struct
+ * @param  pinStatus: KSZ_GPIO_PIN_RESET or KSZ_GPIO_PIN_SET
+ */
+static void ksz8851_reset_pin(void *context, uint8_t pinStatus)
+{
+	KSZ8851_t *driver = (KSZ8851_t*)context;
+
+	driver->config->functions.GPIO_Control(driver->config->functions.user, driver->config->interface.rst_port, driver->config->interface.rst_pin, pinStatus);
+}
+
+/**
+ * @brief  Waits at least delay_time us, calls TIME_Yield while waiting.
+ * @param  context: address of KSZ8851_t struct
+ */
+static void ksz8851_wait_us(void *context, uint32_t delay_time)
+{
+	ksz8851_delayUs((KSZ8851_t*)context, delay_time);
+}
+
+/**
+* @brief Reads internal I/O registers of KSZ8851SNL.
+* @param driver: address of KSZ8851_t struct that contains all driver params.
+* @param register: address of internal register.
+* @param *registerValue:
+* @return status of process
+*/
+static KSZ8851_Status_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t *registerValue)
+{
+	return ksz8851_transport_read_register(&ksz8851_transport, driver, registerAddr, registerValue);
+}
+
+/**
+* @brief  Writes internal I/O registers of KSZ8851SNL.
+* @param  driver: address of KSZ8851_t struct that contains all driver params.
+* @param  register: address of internal register.
+* @return status of process
+*/
+static KSZ8851_Status_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t registerValue)
+{
+	/* if The register that data will be written have some reserved bits, they are written with their reset value to prevent unpredictable
+	 * and fatal result (ref: KSZ8851 datasheet, section 4.2 Regsiter Map). Volatile registers are left to the caller to read before writing */
+	ksz8851_merge_reserved_bits(registerAddr, &registerValue);
+
+	return ksz8851_transport_write_register(&ksz8851_transport, driver, registerAddr, registerValue);
+}
+
+/**
+* @brief  Reads dword aligned register pair of KSZ8851SNL in one spi transaction by setting all 4 byte enable bits.
+* @param  driver: address of KSZ8851_t struct that contains all driver params.
+* @param  registerAddr: dword aligned address of lower register of the pair.
+* @param  *registerValue: bit 15-0 is the register on registerAddr, bit 31-16 is the register on registerAddr + 2.
+* @return status of process
+*/
+static KSZ8851_Status_t ksz8851_read_register32(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint32_t *registerValue)
+{
+	return ksz8851_transport_read_register32(&ksz8851_transport, driver, registerAddr, registerValue);
+}
+
+/**
+* @brief  Writes dword aligned register pair of KSZ8851SNL in one spi transaction by setting all 4 byte enable bits.
+* @param  driver: address of KSZ8851_t struct that contains all driver params.
+* @param  registerAddr: dword aligned address of lower register of the pair.
+* @param  registerValue: bit 15-0 is written to registerAddr, bit 31-16 is written to registerAddr + 2.
+* @return status of process
+*/
+static KSZ8851_Status_t ksz8851_write_register32(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint32_t registerValue)
+{
+	return ksz8851_transport_write_register32(&ksz8851_transport, driver, registerAddr, registerValue);
+}
+
+/**
+ * @brief  Reads IER and ISR together (0x90 - 0x93) and keeps ISR content in driver status registers.
+ * @param  driver
+ * @param  enabled_interrupts: current IER content, can be NULL.
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_read_interrupt_status(KSZ8851_t *driver, uint16_t *enabled_interrupts)
+{
+	uint32_t tmpRegPair;
+	KSZ8851_Status_t result;
+
+	result = ksz8851_read_register32(driver, KSZ_REG_ADDR_IER0, &tmpRegPair);
+
+	driver->Registers.Status.Interrupt = (uint16_t)(tmpRegPair >> 16);
+
+	if(enabled_interrupts != NULL)
+	{
+		*enabled_interrupts = (uint16_t)tmpRegPair;
+	}
+
+	return result;
+}
+
+/**
+ * @brief  Reads RXFHSR and RXFHBCR of the present frame together (0x7C - 0x7F) and keeps header status in driver status registers.
+ * @param  driver
+ * @param  frame_length: receive byte count of the present frame.
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_read_rx_frame_header(KSZ8851_t *driver, uint16_t *frame_length)
+{
+	uint32_t tmpRegPair;
+	KSZ8851_Status_t result;
+
+	result = ksz8851_read_register32(driver, KSZ_REG_ADDR_RXFHSR0, &tmpRegPair);
+
+	driver->Registers.Status.Rx_Frame_Header = (uint16_t)tmpRegPair;
+	*frame_length = (uint16_t)(tmpRegPair >> 16) & KSZ_RX_FRAME_BYTE_COUNT_MASK;
+
+	return result;
+}
+
+/**
+ * @brief  Releases present frame in RXQ without reading it.
+ * @param  driver
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_release_rx_frame(KSZ8851_t *driver)
+{
+	KSZ8851_Status_t result;
+
+	result = ksz8851_set_registerBits(driver, KSZ_REG_ADDR_RXQCR0, KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR);
+
+	/* Release bit is self clearing, next frame header is valid after it is cleared */
+	result |= ksz8851_wait_register(driver, KSZ_REG_ADDR_RXQCR0, KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR, 0, KSZ_TIME_RX_RELEASE_TIMEOUT_US);
+
+	return result;
+}
+
+/**
+ * @brief  Checks header status of present frame and counts discard reason of bad frames.
+ * @param  driver
+ * @param  byte_count: receive byte count of the frame (RXFHBCR)
+ * @return true if frame can be read, false if it must be released
+ */
+static bool ksz8851_check_rx_frame(KSZ8851_t *driver, uint16_t byte_count)
+{
+	uint16_t tmpFrameStatus = driver->Registers.Status.Rx_Frame_Header;
+
+	if((tmpFrameStatus & KSZ_STATUS_RX_FRAME_VALID) != 0 && (tmpFrameStatus & KSZ_STATUS_RX_FRAME_ERRORS) == 0 &&
+	   byte_count > KSZ_ETH_CRC_SIZE && byte_count <= (KSZ_ETH_MAX_FRAME_SIZE + KSZ_ETH_CRC_SIZE))
+	{
+		return true;
+	}
+
+	driver->Statistics.rx_dropped++;
+
+	if(tmpFrameStatus & KSZ_STATUS_RX_FRAME_CRC_ERROR)
+	{
+		driver->Statistics.rx_crc_errors++;
+	}
+	else if(tmpFrameStatus & KSZ_STATUS_RX_FRAME_RUNT)
+	{
+		driver->Statistics.rx_runts++;
+	}
+	else if((tmpFrameStatus & KSZ_STATUS_RX_FRAME_TOO_LONG) || byte_count > (KSZ_ETH_MAX_FRAME_SIZE + KSZ_ETH_CRC_SIZE))
+	{
+		driver->Statistics.rx_too_long++;
+	}
+	else if(tmpFrameStatus & KSZ_STATUS_RX_FRAME_MII_ERROR)
+	{
+		driver->Statistics.rx_mii_errors++;
+	}
+	else if(tmpFrameStatus & KSZ_STATUS_RX_FRAME_ERRORS)
+	{
+		driver->Statistics.rx_checksum_errors++;
+	}
+	else
+	{
+		driver->Statistics.rx_invalid++;
+	}
+
+	return false;
+}
+
+/**
+ * @brief  Hands frames in RXQ over to upper layer by RX_GetBuffer / RX_FrameReceived callbacks.
+ * @param  driver
+ * @param  frame_count: number of frames taken from RXQ, at most RXFCTR frame count
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_service_rx(KSZ8851_t *driver, uint8_t frame_count)
+{
+	uint16_t tmpByteCount;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	ksz8851_flow_update(driver, frame_count);
+
+	while(frame_count-- > 0)
+	{
+		result |= ksz8851_read_rx_frame_header(driver, &tmpByteCount);
+
+		/* Bad frames are released by their header status, their payload never crosses spi bus */
+		if(!ksz8851_check_rx_frame(driver, tmpByteCount))
+		{
+			result |= ksz8851_release_rx_frame(driver);
+			continue;
+		}
+
+		result |= ksz8851_rx_to_upper_layer(driver, tmpByteCount);
+	}
+
+	/* RXQ count is read again only while backpressure is asserted, to release it as soon as RXQ is drained */
+	if(driver->backpressure)
+	{
+		ksz8851_flow_update(driver, ksz8851_get_rx_frame_count(driver));
+	}
+
+	return result;
+}
+
+/**
+ * @brief  Reads present good frame into a buffer of upper layer. If RX_PeekFrame or fast path is defined, first KSZ_RX_CONFIG_PEEK_SIZE
+ * 		   bytes are read before, and frames rejected by it are released without reading the rest of frame. Fast path requests are
+ * 		   answered by the driver.
+ * @param  driver
+ * @param  byte_count: receive byte count of the frame (RXFHBCR), including CRC.
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_rx_to_upper_layer(KSZ8851_t *driver, uint16_t byte_count)
+{
+	uint8_t  tmpPreamble[KSZ_RX_FIFO_PREAMBLE_SIZE];
+	uint8_t  tmpPeekBuff[KSZ_DWORD_ALIGN(KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_CONFIG_PEEK_SIZE) - KSZ_RX_FIFO_PREAMBLE_SIZE];
+	uint8_t  *pRxBuffer = NULL;
+	uint16_t tmpFrameLength = byte_count - KSZ_ETH_CRC_SIZE;
+	uint16_t tmpStreamEnd, tmpPeekEnd = 0;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	if(driver->config->functions.RX_GetBuffer == NULL || driver->config->functions.RX_FrameReceived == NULL)
+	{
+		driver->Statistics.rx_dropped++;
+		driver->Statistics.rx_no_buffer++;
+		return ksz8851_release_rx_frame(driver);
+	}
+
+	if(driver->config->functions.RX_PeekFrame == NULL && driver->config->fastpath_ipv4 == NULL)
+	{
+		pRxBuffer = driver->config->functions.RX_GetBuffer(driver->config->functions.user, tmpFrameLength);
+
+		if(pRxBuffer == NULL)
+		{
+			driver->Statistics.rx_dropped++;
+			driver->Statistics.rx_no_buffer++;
+			return ksz8851_release_rx_frame(driver);
+		}
+
+		result = ksz8851_read_fifo(driver, pRxBuffer, byte_count);
+	}
+	else
+	{
+		/* Peek ends on a fifo dword boundary, so the rest of frame is read by aligned transactions in the same DMA session. Stream
+		 * end is derived from RX_GetBuffer contract, data written into the buffer never exceeds KSZ_RX_BUFFER_SIZE(tmpFrameLength) */
+		tmpStreamEnd	= KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(tmpFrameLength);
+		tmpPeekEnd		= KSZ_RX_FIFO_PREAMBLE_SIZE + sizeof(tmpPeekBuff);
+
+		if(tmpPeekEnd > tmpStreamEnd)
+		{
+			tmpPeekEnd = tmpStreamEnd;
+		}
+
+		result = ksz8851_rx_dma_start(driver);
+		result |= ksz8851_read_fifo_stream(driver, tmpPreamble, tmpPeekBuff, 0, tmpPeekEnd);
+
+		if(ksz8851_fastpath_candidate(driver, tmpPeekBuff, tmpFrameLength))
+		{
+			return result | ksz8851_rx_fastpath(driver, tmpPreamble, tmpPeekBuff, tmpPeekEnd, tmpStreamEnd, tmpFrameLength);
+		}
+
+		if(driver->config->functions.RX_PeekFrame == NULL || driver->config->functions.RX_PeekFrame(driver->config->functions.user, tmpPeekBuff,
+				(tmpFrameLength < sizeof(tmpPeekBuff)) ? tmpFrameLength : sizeof(tmpPeekBuff), tmpFrameLength))
+		{
+			pRxBuffer = driver->config->functions.RX_GetBuffer(driver->config->functions.user, tmpFrameLength);
+		}
+		else
+		{
+			driver->Statistics.rx_peek_dropped++;
+		}
+
+		if(pRxBuffer != NULL)
+		{
+			memcpy(pRxBuffer, tmpPeekBuff, tmpPeekEnd - KSZ_RX_FIFO_PREAMBLE_SIZE);
+			result |= ksz8851_read_fifo_stream(driver, tmpPreamble, pRxBuffer, tmpPeekEnd, tmpStreamEnd);
+			driver->Statistics.rx_bytes += tmpStreamEnd;
+		}
+		else
+		{
+			driver->Statistics.rx_bytes += tmpPeekEnd;
+		}
+
+		result |= ksz8851_rx_dma_stop(driver);
+
+		if(pRxBuffer == NULL)
+		{
+			driver->Statistics.rx_dropped++;
+			return result | ksz8851_release_rx_frame(driver);
+		}
+	}
+
+	return result | ksz8851_rx_deliver(driver, pRxBuffer, tmpFrameLength);
+}
+
+/**
+ * @brief  Hands over a frame read from RXQ to upper layer.
+ * @param  driver
+ * @param  pRxBuffer: buffer from RX_GetBuffer holding the frame
+ * @param  frame_length: frame length without CRC
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_rx_deliver(KSZ8851_t *driver, uint8_t *pRxBuffer, uint16_t frame_length)
+{
+	KSZ8851_Frame_Info_t tmpInfo;
+
+	driver->Statistics.rx_frames++;
+
+	if(driver->config->functions.RX_FrameInfo != NULL)
+	{
+		tmpInfo.timestamp	= driver->rx_timestamp;
+		tmpInfo.status		= driver->Registers.Status.Rx_Frame_Header;
+		tmpInfo.length		= frame_length;
+		tmpInfo.frame_id	= 0;
+		tmpInfo.buffer		= pRxBuffer;
+
+		driver->config->functions.RX_FrameInfo(driver->config->functions.user, &tmpInfo);
+	}
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	ksz8851_histogram_record(driver, &driver->Latency.rx_delivery, driver->rx_timestamp);
+#endif
+
+	driver->config->functions.RX_FrameReceived(driver->config->functions.user, pRxBuffer, frame_length);
+
+	return KSZ_OK;
+}
+
+/**
+ * @brief  Checks peeked bytes for an ARP request or an IPv4 ICMP frame which fast path may answer. Addresses are checked
+ * 		   after the whole frame is read.
+ * @param  driver
+ * @param  peek: first bytes of frame, at least KSZ_IPV4_PROTOCOL_OFFSET + 1 of them when frame is long enough
+ * @param  frame_length: frame length without CRC
+ * @return true if frame is read whole and passed to ksz8851_rx_fastpath
+ */
+static bool ksz8851_fastpath_candidate(KSZ8851_t *driver, const uint8_t *peek, uint16_t frame_length)
+{
+	uint16_t tmpEthType;
+
+	if(driver->config->fastpath_ipv4 == NULL || frame_length < KSZ_ARP_FRAME_SIZE || frame_length > KSZ_FASTPATH_CONFIG_MAX_FRAME)
+	{
+		return false;
+	}
+
+	tmpEthType = KSZ_MAKE_U16(peek[KSZ_ETH_TYPE_OFFSET], peek[KSZ_ETH_TYPE_OFFSET + 1]);
+
+	if(tmpEthType == KSZ_ETH_TYPE_ARP)
+	{
+		return (KSZ_MAKE_U16(peek[KSZ_ARP_OPER_OFFSET], peek[KSZ_ARP_OPER_OFFSET + 1]) == KSZ_ARP_OPER_REQUEST);
+	}
+
+	return (tmpEthType == KSZ_ETH_TYPE_IPV4 && peek[KSZ_IPV4_VER_IHL_OFFSET] == KSZ_IPV4_VER_IHL_NO_OPTIONS &&
+			peek[KSZ_IPV4_PROTOCOL_OFFSET] == KSZ_IPV4_PROTOCOL_ICMP);
+}
+
+/**
+ * @brief  Checks if an IPv4 address is one of fast path addresses
+ * @param  driver
+ * @param  ipv4: address in network order
+ * @return true if it is local
+ */
+static bool ksz8851_fastpath_local(KSZ8851_t *driver, const uint8_t *ipv4)
+{
+	uint8_t i;
+
+	for(i = 0; i < driver->config->fastpath_ipv4_count; i++)
+	{
+		if(memcmp(ipv4, &driver->config->fastpath_ipv4[i * KSZ_IPV4_ADDR_SIZE], KSZ_IPV4_ADDR_SIZE) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief  Turns an ARP request or ICMP echo request for a fast path address into its reply in place. IPv4 checksum is cleared
+ * 		   and generated by TXQ (KSZ_CONFIG_TX_CTRL_IP_CHECKSUM), ICMP checksum is updated for the changed type (RFC 1624).
+ * @param  driver
+ * @param  frame: received frame
+ * @param  frame_length: frame length without CRC
+ * @return reply length, 0 if frame isn't a request for a fast path address
+ */
+static uint16_t ksz8851_fastpath_build_reply(KSZ8851_t *driver, uint8_t *frame, uint16_t frame_length)
+{
+	uint8_t  tmpIpv4[KSZ_IPV4_ADDR_SIZE];
+	uint16_t tmpLength;
+	uint16_t tmpChecksum;
+
+	if(KSZ_MAKE_U16(frame[KSZ_ETH_TYPE_OFFSET], frame[KSZ_ETH_TYPE_OFFSET + 1]) == KSZ_ETH_TYPE_ARP)
+	{
+		if(KSZ_MAKE_U16(frame[KSZ_ARP_HTYPE_OFFSET], frame[KSZ_ARP_HTYPE_OFFSET + 1]) != KSZ_ARP_HTYPE_ETHERNET ||
+		   KSZ_MAKE_U16(frame[KSZ_ARP_PTYPE_OFFSET], frame[KSZ_ARP_PTYPE_OFFSET + 1]) != KSZ_ETH_TYPE_IPV4 ||
+		   KSZ_MAKE_U16(frame[KSZ_ARP_ADDR_SIZES_OFFSET], frame[KSZ_ARP_ADDR_SIZES_OFFSET + 1]) != KSZ_ARP_ADDR_SIZES ||
+		   !ksz8851_fastpath_local(driver, &frame[KSZ_ARP_TPA_OFFSET]))
+		{
+			return 0;
+		}
+
+		/* Requester becomes target, requested address is answered with own MAC */
+		memcpy(tmpIpv4, &frame[KSZ_ARP_TPA_OFFSET], KSZ_IPV4_ADDR_SIZE);
+		memcpy(&frame[KSZ_ARP_THA_OFFSET], &frame[KSZ_ARP_SHA_OFFSET], KSZ_MAC_ADDRR_LEN + KSZ_IPV4_ADDR_SIZE);
+		memcpy(&frame[KSZ_ARP_SHA_OFFSET], driver->config->MAC_address, KSZ_MAC_ADDRR_LEN);
+		memcpy(&frame[KSZ_ARP_SPA_OFFSET], tmpIpv4, KSZ_IPV4_ADDR_SIZE);
+		frame[KSZ_ARP_OPER_OFFSET + 1] = KSZ_ARP_OPER_REPLY;
+
+		tmpLength = KSZ_ARP_FRAME_SIZE;
+	}
+	else
+	{
+		tmpLength = KSZ_ETH_HEADER_SIZE + KSZ_MAKE_U16(frame[KSZ_IPV4_TOTAL_LEN_OFFSET], frame[KSZ_IPV4_TOTAL_LEN_OFFSET + 1]);
+
+		/* Echo request to own MAC and address, not fragmented */
+		if(frame[KSZ_ICMP_TYPE_OFFSET] != KSZ_ICMP_ECHO_REQUEST || tmpLength > frame_length ||
+		   tmpLength < KSZ_ETH_HEADER_SIZE + KSZ_IPV4_HEADER_SIZE + KSZ_ICMP_HEADER_SIZE ||
+		   (KSZ_MAKE_U16(frame[KSZ_IPV4_FRAGMENT_OFFSET], frame[KSZ_IPV4_FRAGMENT_OFFSET + 1]) & KSZ_IPV4_FRAGMENT_MASK) != 0 ||
+		   memcmp(frame, driver->config->MAC_address, KSZ_MAC_ADDRR_LEN) != 0 ||
+		   !ksz8851_fastpath_local(driver, &frame[KSZ_IPV4_DST_OFFSET]))
+		{
+			return 0;
+		}
+
+		memcpy(tmpIpv4, &frame[KSZ_IPV4_DST_OFFSET], KSZ_IPV4_ADDR_SIZE);
+		memcpy(&frame[KSZ_IPV4_DST_OFFSET], &frame[KSZ_IPV4_SRC_OFFSET], KSZ_IPV4_ADDR_SIZE);
+		memcpy(&frame[KSZ_IPV4_SRC_OFFSET], tmpIpv4, KSZ_IPV4_ADDR_SIZE);
+		frame[KSZ_IPV4_TTL_OFFSET]				= KSZ_IPV4_DEFAULT_TTL;
+		frame[KSZ_IPV4_CHECKSUM_OFFSET]			= 0;
+		frame[KSZ_IPV4_CHECKSUM_OFFSET + 1]		= 0;
+		frame[KSZ_ICMP_TYPE_OFFSET]				= KSZ_ICMP_ECHO_REPLY;
+
+		/* Type is high byte of first ICMP word, code and the rest of message are echoed unchanged */
+		tmpChecksum = ksz8851_checksum_update(KSZ_MAKE_U16(frame[KSZ_ICMP_CHECKSUM_OFFSET], frame[KSZ_ICMP_CHECKSUM_OFFSET + 1]),
+											  KSZ_MAKE_U16(KSZ_ICMP_ECHO_REQUEST, 0), KSZ_MAKE_U16(KSZ_ICMP_ECHO_REPLY, 0));
+		frame[KSZ_ICMP_CHECKSUM_OFFSET]			= (uint8_t)(tmpChecksum >> KSZ_1BYTE_SHIFTING_VALUE);
+		frame[KSZ_ICMP_CHECKSUM_OFFSET + 1]		= (uint8_t)tmpChecksum;
+	}
+
+	/* Reply goes back to sender */
+	memcpy(frame, &frame[KSZ_ETH_SRC_MAC_OFFSET], KSZ_MAC_ADDRR_LEN);
+	memcpy(&frame[KSZ_ETH_SRC_MAC_OFFSET], driver->config->MAC_address, KSZ_MAC_ADDRR_LEN);
+
+	return tmpLength;
+}
+
+/**
+ * @brief  Updates an internet checksum for one changed 16 bit word, HC' = ~(~HC + ~m + m') of RFC 1624. Unlike recomputation
+ * 		   it needs no other word of the message.
+ * @param  checksum: checksum field before the change
+ * @param  old_word: word before the change
+ * @param  new_word: word after the change
+ * @return new checksum field
+ */
+static uint16_t ksz8851_checksum_update(uint16_t checksum, uint16_t old_word, uint16_t new_word)
+{
+	uint32_t tmpSum = (uint32_t)(uint16_t)~checksum + (uint16_t)~old_word + new_word;
+
+	/* End around carry, two folds are enough for three 16 bit addends */
+	tmpSum = (tmpSum & 0xFFFF) + (tmpSum >> 16);
+	tmpSum = (tmpSum & 0xFFFF) + (tmpSum >> 16);
+
+	return (uint16_t)~tmpSum;
+}
+
+/**
+ * @brief  Reads the rest of a fast path candidate in the running DMA session and answers it through TXQ. Frames which
+ * 		   aren't requests for fast path addresses are handed over to upper layer as usual.
+ * @param  driver
+ * @param  pPreamble: preamble buffer of the DMA session
+ * @param  peek: peeked bytes
+ * @param  peek_end: fifo position of peek end
+ * @param  stream_end: fifo position of frame end
+ * @param  frame_length: frame length without CRC
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_rx_fastpath(KSZ8851_t *driver, uint8_t *pPreamble, const uint8_t *peek, uint16_t peek_end, uint16_t stream_end, uint16_t frame_length)
+{
+	uint8_t  tmpFrameBuff[KSZ_RX_BUFFER_SIZE(KSZ_FASTPATH_CONFIG_MAX_FRAME)];
+	uint8_t  *pRxBuffer = NULL;
+	uint16_t tmpReplyLength, tmpTxMemAvailable;
+	KSZ8851_Status_t result;
+
+	memcpy(tmpFrameBuff, peek, peek_end - KSZ_RX_FIFO_PREAMBLE_SIZE);
+	result = ksz8851_read_fifo_stream(driver, pPreamble, tmpFrameBuff, peek_end, stream_end);
+	driver->Statistics.rx_bytes += stream_end;
+
+	/* TXQ can't be written while RXQ DMA session is open */
+	result |= ksz8851_rx_dma_stop(driver);
+
+	tmpReplyLength = ksz8851_fastpath_build_reply(driver, tmpFrameBuff, frame_length);
+
+	if(tmpReplyLength != 0)
+	{
+		result |= ksz8851_read_register(driver, KSZ_REG_ADDR_TXMIR0, &tmpTxMemAvailable);
+
+		if((tmpTxMemAvailable & KSZ_TXMIR_AVAILABLE_MASK) < (KSZ_TX_FIFO_HEADER_SIZE + KSZ_DWORD_ALIGN(tmpReplyLength)) || ksz8851_tx_track_full(driver))
+		{
+			driver->Statistics.rx_fastpath_dropped++;
+			return result;
+		}
+
+		result |= ksz8851_write_fifo(driver, NULL, 0, tmpFrameBuff, tmpReplyLength, false);
+		driver->Statistics.rx_fastpath_replies++;
+		driver->Statistics.tx_frames++;
+
+		return result;
+	}
+
+	if(driver->config->functions.RX_PeekFrame == NULL || driver->config->functions.RX_PeekFrame(driver->config->functions.user, tmpFrameBuff,
+			(frame_length < KSZ_RX_CONFIG_PEEK_SIZE) ? frame_length : KSZ_RX_CONFIG_PEEK_SIZE, frame_length))
+	{
+		pRxBuffer = driver->config->functions.RX_GetBuffer(driver->config->functions.user, frame_length);
+	}
+	else
+	{
+		driver->Statistics.rx_peek_dropped++;
+	}
+
+	if(pRxBuffer == NULL)
+	{
+		driver->Statistics.rx_dropped++;
+		return result;
+	}
+
+	/* CRC and fifo padding stay in stack buffer */
+	memcpy(pRxBuffer, tmpFrameBuff, frame_length);
+
+	return result | ksz8851_rx_deliver(driver, pRxBuffer, frame_length);
+}
+
+/**
+ * @brief  Switches RX between interrupt and polling mode and accumulates time spent in previous mode.
+ * @param  driver
+ * @param  polling: new mode
+ */
+static void ksz8851_set_rx_mode(KSZ8851_t *driver, bool polling)
+{
+	uint32_t tmpTick = driver->config->functions.TIME_GetTick(driver->config->functions.user);
+
+	if(driver->rx_polling)
+	{
+		driver->Statistics.rx_polling_mode_ms += tmpTick - driver->rx_mode_tick;
+	}
+	else
+	{
+		driver->Statistics.rx_interrupt_mode_ms += tmpTick - driver->rx_mode_tick;
+	}
+
+	if(polling && !driver->rx_polling)
+	{
+		driver->Statistics.rx_mode_switches++;
+	}
+
+	driver->rx_polling		= polling;
+	driver->rx_mode_tick	= tmpTick;
+}
+
+/**
+ * @brief  Asserts or releases application backpressure when RXQ frame count crosses flow control marks.
+ * @param  driver
+ * @param  rx_frame_count: frames waiting in RXQ
+ */
+static void ksz8851_flow_update(KSZ8851_t *driver, uint8_t rx_frame_count)
+{
+	if(driver->flow_control.backpressure_on_frames == 0)
+	{
+		return;
+	}
+
+	if(!driver->backpressure && rx_frame_count >= driver->flow_control.backpressure_on_frames)
+	{
+		driver->backpressure = true;
+	}
+	else if(driver->backpressure && rx_frame_count <= driver->flow_control.backpressure_off_frames)
+	{
+		driver->backpressure = false;
+	}
+	else
+	{
+		return;
+	}
+
+	if(driver->config->functions.FLOW_Backpressure != NULL)
+	{
+		driver->config->functions.FLOW_Backpressure(driver->config->functions.user, driver->backpressure, rx_frame_count);
+	}
+}
+
+/**
+ * @brief  Writes head frames of TX queues to TXQ in strict priority order while TXQ memory is enough. When the head frame
+ * 		   of the highest non-empty queue doesn't fit, nothing behind it is sent and TXQ memory available monitor is armed.
+ * @param  driver
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_tx_service(KSZ8851_t *driver)
+{
+	KSZ8851_TX_Queue_t *queue;
+	KSZ8851_TX_Entry_t tmpEntry;
+	uint16_t tmpTxMemAvailable, tmpRequired;
+	uint32_t tmpLatency;
+	uint8_t  priority = 0;
+	KSZ8851_Status_t result;
+
+	result = ksz8851_read_register(driver, KSZ_REG_ADDR_TXMIR0, &tmpTxMemAvailable);
+	tmpTxMemAvailable &= KSZ_TXMIR_AVAILABLE_MASK;
+
+	while(priority < KSZ_TX_CONFIG_PRIORITIES && result == KSZ_OK)
+	{
+		queue = &driver->tx_queues[priority];
+
+		if(queue->count == 0)
+		{
+			priority++;
+			continue;
+		}
+
+		tmpEntry	= queue->entries[queue->head];
+		tmpRequired	= KSZ_TX_FIFO_HEADER_SIZE + KSZ_DWORD_ALIGN(tmpEntry.length);
+
+		/* Frame waits for TX done interrupt if all tracked frame IDs are in flight */
+		if(ksz8851_tx_track_full(driver))
+		{
+			break;
+		}
+
+		/* Lower priorities leave reserved TXQ memory to priority 0 */
+		if(tmpTxMemAvailable < tmpRequired + ((priority != 0) ? KSZ_TX_CONFIG_RESERVED_BYTES : 0))
+		{
+			result |= ksz8851_tx_wait_space(driver, tmpRequired + ((priority != 0) ? KSZ_TX_CONFIG_RESERVED_BYTES : 0));
+			break;
+		}
+
+		result |= ksz8851_write_fifo(driver, NULL, 0, tmpEntry.buffer, tmpEntry.length, true);
+
+		if(result != KSZ_OK)
+		{
+			break;
+		}
+
+		tmpTxMemAvailable -= tmpRequired;
+
+		queue->head = (queue->head + 1) % KSZ_TX_CONFIG_QUEUE_DEPTH;
+		queue->count--;
+		queue->sent++;
+		driver->Statistics.tx_frames++;
+
+		tmpLatency = driver->config->functions.TIME_GetTick(driver->config->functions.user) - tmpEntry.tick;
+		queue->latency_total_ms += tmpLatency;
+
+		if(tmpLatency > queue->latency_max_ms)
+		{
+			queue->latency_max_ms = tmpLatency;
+		}
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+		ksz8851_histogram_record(driver, &driver->Latency.tx_enqueue, tmpEntry.stamp);
+#endif
+
+		if(driver->config->functions.TX_BufferReleased != NULL)
+		{
+			driver->config->functions.TX_BufferReleased(driver->config->functions.user, tmpEntry.buffer, tmpEntry.length);
+		}
+
+		/* A higher priority frame may be queued by the callback */
+		priority = 0;
+	}
+
+	return result;
+}
+
+/**
+ * @brief  Arms TXQ memory available monitor, so TX space available interrupt occurs when TXQ has the requested room.
+ * 		   Monitor bit clears itself, it is armed once per wait.
+ * @param  driver
+ * @param  required: TXQ bytes needed by the waiting frame.
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_tx_wait_space(KSZ8851_t *driver, uint16_t required)
+{
+	KSZ8851_Status_t result;
+
+	if(driver->tx_space_wait)
+	{
+		return KSZ_OK;
+	}
+
+	result  = ksz8851_write_register(driver, KSZ_REG_ADDR_TXNTFSR0, required);
+	result |= ksz8851_set_registerBits(driver, KSZ_REG_ADDR_TXQCR0, KSZ_CONFIG_TXQ_MEMORY_AVAILABLE_MONITOR);
+
+	if(result == KSZ_OK)
+	{
+		driver->tx_space_wait = true;
+	}
+
+	return result;
+}
+
+/**
+ * @brief  Returns timestamp of INTRN isr if it is taken, otherwise takes it now.
+ * @param  driver
+ * @return timestamp, 0 if TIME_Timestamp isn't set
+ */
+static uint32_t ksz8851_take_irq_timestamp(KSZ8851_t *driver)
+{
+	if(driver->irq_timestamp_valid)
+	{
+		driver->irq_timestamp_valid = false;
+		return driver->irq_timestamp;
+	}
+
+	return ksz8851_timestamp(driver);
+}
+
+/**
+ * @brief  Returns true if TX_FrameDone is set and all tracked frame IDs are in flight.
+ * @param  driver
+ * @return true if next frame can't be sent yet
+ */
+static bool ksz8851_tx_track_full(KSZ8851_t *driver)
+{
+	return (driver->config->functions.TX_FrameDone != NULL && driver->tx_track_count >= KSZ_TX_CONFIG_TRACK_DEPTH);
+}
+
+/**
+ * @brief  Reports tracked frames up to the frame in TXSR. TXQ transmits in send order and TXSR holds the last completed frame,
+ * 		   so frames before it are done as well; their own collision status isn't available and they are reported without it.
+ * @param  driver
+ * @param  tx_status: TXSR
+ * @param  timestamp: TX done interrupt timestamp
+ */
+static void ksz8851_tx_complete(KSZ8851_t *driver, uint16_t tx_status, uint32_t timestamp)
+{
+	KSZ8851_TX_Track_t *track;
+	KSZ8851_Frame_Info_t tmpInfo;
+	uint8_t tmpFrameId = (uint8_t)KSZ_FIELD_GET(tx_status, KSZ_TXSR_FRAME_ID);
+	uint8_t i;
+
+	/* Stale or unknown frame ID doesn't release anything */
+	for(i = 0; i < driver->tx_track_count; i++)
+	{
+		if(driver->tx_track[(driver->tx_track_head + i) % KSZ_TX_CONFIG_TRACK_DEPTH].frame_id == tmpFrameId)
+		{
+			break;
+		}
+	}
+
+	if(i == driver->tx_track_count)
+	{
+		return;
+	}
+
+	for(; driver->tx_track_count > 0; )
+	{
+		track = &driver->tx_track[driver->tx_track_head];
+
+		tmpInfo.timestamp	= timestamp;
+		tmpInfo.length		= track->length;
+		tmpInfo.frame_id	= track->frame_id;
+		tmpInfo.buffer		= track->buffer;
+		tmpInfo.status		= (track->frame_id == tmpFrameId) ? tx_status : track->frame_id;
+
+		driver->tx_track_head = (driver->tx_track_head + 1) % KSZ_TX_CONFIG_TRACK_DEPTH;
+		driver->tx_track_count--;
+		driver->Statistics.tx_completed++;
+
+		if(tmpInfo.status & (KSZ_TXSR_MAX_COLLISION_MASK | KSZ_TXSR_LATE_COLLISION_MASK))
+		{
+			driver->Statistics.tx_collision_failures++;
+		}
+
+		driver->config->functions.TX_FrameDone(driver->config->functions.user, &tmpInfo);
+
+		if(tmpInfo.frame_id == tmpFrameId)
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * @brief  Returns TIME_Timestamp value.
+ * @param  driver
+ * @return timestamp, 0 if TIME_Timestamp isn't set
+ */
+static uint32_t ksz8851_timestamp(KSZ8851_t *driver)
+{
+	if(driver->config->functions.TIME_Timestamp == NULL)
+	{
+		return 0;
+	}
+
+	return driver->config->functions.TIME_Timestamp(driver->config->functions.user);
+}
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+/**
+ * @brief  Records time since start in its log2 bucket. Bucket is found by binary search over bit positions, so record costs
+ * 		   the same few operations for any value.
+ * @param  driver
+ * @param  histogram
+ * @param  start: TIME_Timestamp value at beginning of measured path
+ */
+static void ksz8851_histogram_record(KSZ8851_t *driver, KSZ8851_Histogram_t *histogram, uint32_t start)
+{
+	uint32_t tmpValue, tmpRest;
+	uint8_t  tmpBucket = 0;
+
+	if(driver->config->functions.TIME_Timestamp == NULL)
+	{
+		return;
+	}
+
+	tmpValue = driver->config->functions.TIME_Timestamp(driver->config->functions.user) - start;
+
+	/* Bucket is number of significant bits of value */
+	if(tmpValue != 0)
+	{
+		tmpRest   = tmpValue;
+		tmpBucket = 1;
+
+		if(tmpRest >= 0x10000)	{ tmpRest >>= 16; tmpBucket += 16; }
+		if(tmpRest >= 0x100)	{ tmpRest >>= 8;  tmpBucket += 8;  }
+		if(tmpRest >= 0x10)		{ tmpRest >>= 4;  tmpBucket += 4;  }
+		if(tmpRest >= 0x4)		{ tmpRest >>= 2;  tmpBucket += 2;  }
+		if(tmpRest >= 0x2)		{ tmpBucket += 1; }
+	}
+
+	if(tmpBucket >= KSZ_HIST_CONFIG_BUCKETS)
+	{
+		tmpBucket = KSZ_HIST_CONFIG_BUCKETS - 1;
+	}
+
+	histogram->buckets[tmpBucket]++;
+	histogram->count++;
+
+	if(tmpValue > histogram->max)
+	{
+		histogram->max = tmpValue;
+	}
+}
+#endif
+
+/**
+ * @brief  Computes wake-up frame CRC over the pattern bytes selected by mask, in the order they appear in the frame. Register
+ * 		   starts with all ones and shifts toward MSB with the normal form polynomial, bits of each byte are taken LSB first as
+ * 		   they arrive from wire, result isn't inverted. It is the bit reversed ethernet FCS before final inversion, "123456789"
+ * 		   gives 0x9B63D02C.
+ * @param  pattern
+ * @return CRC value that is written to WFnCRC1:WFnCRC0
+ */
+static uint32_t ksz8851_wakeup_crc(const KSZ8851_WakeUp_Pattern_t *pattern)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	uint8_t  i, bit, octet;
+
+	for(i = 0; i < pattern->length; i++)
+	{
+		if(pattern->mask != NULL && (pattern->mask[i >> 3] & (1 << (i & 0x07))) == 0)
+		{
+			continue;
+		}
+
+		octet = pattern->bytes[i];
+
+		for(bit = 0; bit < 8; bit++, octet >>= 1)
+		{
+			crc = (crc << 1) ^ ((((crc >> 31) ^ octet) & 0x01) ? KSZ_WAKEUP_FRAME_CRC_POLYNOMIAL : 0);
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * @brief  Reads present frame from RXQ by QMU DMA transfer. Frame header must be read before (ksz8851_read_rx_frame_header)
+ * @param  driver
+ * @param  rxBuffer: at least KSZ_RX_BUFFER_SIZE(frame_length - KSZ_ETH_CRC_SIZE) bytes, frame starts from first byte.
+ * @param  frame_length: receive byte count of the frame (RXFHBCR), including CRC.
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_read_fifo(KSZ8851_t *driver, uint8_t *rxBuffer, uint16_t frame_length)
+{
+	uint8_t  tmpPreamble[KSZ_RX_FIFO_PREAMBLE_SIZE];
+	uint16_t tmpTotalLength;
+	KSZ8851_Status_t result;
+
+	/* Dummy bytes, frame status, byte count and IP header offset come before frame data. Frame status and byte count are already known.
+	 * The data length that read from KSZ must be DWORD aligned during read fifo operation, IP header offset is counted in the alignment
+	 * ref: KSZ datasheet section 3.5.6 */
+	tmpTotalLength = KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(frame_length - KSZ_ETH_CRC_SIZE);
+
+	result = ksz8851_rx_dma_start(driver);
+	result |= ksz8851_read_fifo_stream(driver, tmpPreamble, rxBuffer, 0, tmpTotalLength);
+	result |= ksz8851_rx_dma_stop(driver);
+
+	driver->Statistics.rx_bytes += tmpTotalLength;
+
+	return result;
+}
+
+/**
+ * @brief  Resets RX frame data pointer to the beginning of the present frame and starts QMU DMA transfer to host CPU.
+ * @param  driver
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_rx_dma_start(KSZ8851_t *driver)
+{
+	KSZ8851_Status_t result;
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	driver->fifo_stamp = ksz8851_timestamp(driver);
+#endif
+
+	result = ksz8851_transport_rx_dma_start(&ksz8851_transport, driver);
+
+	return result;
+}
+
+/**
+ * @brief  Stops QMU DMA transfer. Frame is dequeued automatically if it is read completely.
+ * @param  driver
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_rx_dma_stop(KSZ8851_t *driver)
+{
+	KSZ8851_Status_t result;
+
+	result = ksz8851_transport_dma(&ksz8851_transport, driver, false);
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	ksz8851_histogram_record(driver, &driver->Latency.fifo_transfer, driver->fifo_stamp);
+#endif
+
+	return result;
+}
+
+/**
+ * @brief  Reads part of RXQ fifo stream of present frame during DMA transfer. Stream position 0 is first dummy byte, frame data
+ * 		   starts at KSZ_RX_FIFO_PREAMBLE_SIZE. Stream is read in transactions of rx_burst_length bytes, or in one transaction in
+ * 		   single frame burst mode.
+ * @param  driver
+ * @param  pPreamble: KSZ_RX_FIFO_PREAMBLE_SIZE bytes for dummy bytes, frame status, byte count and IP header offset
+ * @param  rxBuffer: frame data, first byte is frame byte 0
+ * @param  from: first stream position, dword aligned
+ * @param  to: stream position after last byte, dword aligned
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_read_fifo_stream(KSZ8851_t *driver, uint8_t *pPreamble, uint8_t *rxBuffer, uint16_t from, uint16_t to)
+{
+	return ksz8851_transport_read_fifo_stream(&ksz8851_transport, driver, driver->rx_burst_length, pPreamble, rxBuffer, from, to,
+			&driver->Statistics.rx_spi_bursts);
+}
+
+/**
+ * @brief  Writes a frame to TXQ by QMU DMA transfer and enqueues it. TXQ memory must be checked before (TXMIR)
+ * @param  driver
+ * @param  header: frame bytes sent before txBuffer in the same transfer (e.g. UDP template), can be NULL
+ * @param  header_length: 0 .. KSZ_UDP_TEMPLATE_SIZE
+ * @param  txBuffer: ethernet frame, or the rest of it after header
+ * @param  frame_length: frame length without CRC, including header
+ * @param  user_buffer: false for frames built by the driver, TX_FrameDone reports them with NULL buffer
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_write_fifo(KSZ8851_t *driver, const uint8_t *header, uint8_t header_length, uint8_t *txBuffer, uint16_t frame_length, bool user_buffer)
+{
+	uint8_t  headerBuff[KSZ_FIFO_CMD_SIZE + KSZ_TX_FIFO_HEADER_SIZE + KSZ_UDP_TEMPLATE_SIZE];
+	uint16_t tmpCurrentRegValue, tmpControlWord;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	/* Control word and byte count are little endian */
+	tmpControlWord = driver->tx_frame_id & KSZ_TX_CTRL_FRAME_ID_MASK;
+
+	/* TX done interrupt is requested only if completion is reported, frame is tracked by its frame ID until then */
+	if(driver->config->functions.TX_FrameDone != NULL)
+	{
+		tmpControlWord |= KSZ_TX_CTRL_INT_ON_COMPLETION;
+	}
+
+	driver->tx_frame_id = (driver->tx_frame_id + 1) & KSZ_TX_CTRL_FRAME_ID_MASK;
+
+	/* Write fifo command and frame header are sent from one buffer */
+	headerBuff[KSZ_REG_BUFF_BYTE0] = KSZ_FIFO_CMD_WRITE;
+	headerBuff[KSZ_REG_BUFF_BYTE1] = (uint8_t)tmpControlWord;
+	headerBuff[KSZ_REG_BUFF_BYTE2] = (uint8_t)(tmpControlWord >> KSZ_1BYTE_SHIFTING_VALUE);
+	headerBuff[KSZ_REG_BUFF_BYTE3] = (uint8_t)frame_length;
+	headerBuff[KSZ_REG_BUFF_BYTE4] = (uint8_t)(frame_length >> KSZ_1BYTE_SHIFTING_VALUE);
+
+	if(header_length != 0)
+	{
+		memcpy(&headerBuff[KSZ_FIFO_CMD_SIZE + KSZ_TX_FIFO_HEADER_SIZE], header, header_length);
+	}
+
+	/* Disable all interrupts before starting fifo writing process, keep which IER content to enable current interrupts after process */
+	result = ksz8851_disable_interrupts(driver, &tmpCurrentRegValue);
+
+	/* Start QMU DMA transfer operation to write frame data from host CPU to the TXQ. */
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	driver->fifo_stamp = ksz8851_timestamp(driver);
+#endif
+	result |= ksz8851_transport_dma(&ksz8851_transport, driver, true);
+
+	/* Command, frame header and frame data are one chained transfer, DWORD padding is its tail */
+	result |= ksz8851_transport_write_fifo(&ksz8851_transport, driver, headerBuff, KSZ_FIFO_CMD_SIZE + KSZ_TX_FIFO_HEADER_SIZE + header_length,
+			txBuffer, frame_length - header_length, frame_length);
+
+	/* Stop QMU DMA transfer operation */
+	result |= ksz8851_transport_dma(&ksz8851_transport, driver, false);
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	ksz8851_histogram_record(driver, &driver->Latency.fifo_transfer, driver->fifo_stamp);
+#endif
+
+	/* Enqueue the frame for transmission */
+	result |= ksz8851_set_registerBits(driver, KSZ_REG_ADDR_TXQCR0, KSZ_CONFIG_TXQ_MANUAL_ENQUEUE);
+
+	if(driver->config->functions.TX_FrameDone != NULL && result == KSZ_OK)
+	{
+		KSZ8851_TX_Track_t *track = &driver->tx_track[(driver->tx_track_head + driver->tx_track_count) % KSZ_TX_CONFIG_TRACK_DEPTH];
+
+		track->buffer	= user_buffer ? txBuffer : NULL;
+		track->length	= frame_length;
+		track->frame_id	= (uint8_t)(tmpControlWord & KSZ_TX_CTRL_FRAME_ID_MASK);
+		driver->tx_track_count++;
+	}
+
+	result |= ksz8851_enable_interrupts(driver, tmpCurrentRegValue);
+
+	return result;
+}
+
+/**
+ * @brief  Sets bits of a register by read-modify-write
+ * @param driver
+ * @param registerAddr
+ * @param bit_mask
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_set_registerBits(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask)
+{
+	uint16_t tmpCurrentRegValue;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	/* Read current value in the register */
+	result = ksz8851_read_register(driver, registerAddr, &tmpCurrentRegValue);
+
+	/* Set only issued bit/bits */
+	tmpCurrentRegValue |= bit_mask;
+
+	/* Write new register value */
+	result |= ksz8851_write_register(driver, registerAddr, tmpCurrentRegValue);
+
+	return result;
+}
+
+/**
+ * @brief  Clears bits of a register by read-modify-write
+ * @param driver
+ * @param registerAddr
+ * @param bit_mask
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_clear_registerBits(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t bit_mask)
+{
+	uint16_t tmpCurrentRegValue;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	/* Read current value in the register */
+	result = ksz8851_read_register(driver, registerAddr, &tmpCurrentRegValue);
+
+	/* Reset only issued bit/bits */
+	tmpCurrentRegValue &= ~bit_mask;
+
+	/* Write new register value */
+	result |= ksz8851_write_register(driver, registerAddr, tmpCurrentRegValue);
+
+	return result;
+}
+
+/**
+ * @brief
+ * @param driver
+ * @param register_value
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_enable_interrupts(KSZ8851_t *driver, uint16_t register_value)
+{
+	KSZ8851_Status_t result = KSZ_OK;
+
+	result = ksz8851_write_register(driver, KSZ_REG_ADDR_IER0, register_value);
+
+	return result;
+}
+
+/**
+ * @brief
+ * @param driver
+ * @param current_reg_value
+ * @return result
+ */
+static KSZ8851_Status_t ksz8851_disable_interrupts(KSZ8851_t *driver, uint16_t *current_reg_value)
+{
+	KSZ8851_Status_t result = KSZ_OK;
+
+	if(current_reg_value != NULL)
+	{
+		result = ksz8851_read_register(driver, KSZ_REG_ADDR_IER0, current_reg_value);
+	}
+
+	result |= ksz8851_write_register(driver, KSZ_REG_ADDR_IER0, KSZ_CONFIG_CLEAR_ALL_BITS);
+
+	return result;
+}
+
+/**
+ * @brief Perform KSZ8851 hardware reset
+ * @param driver
+ */
+static void ksz8851_hard_reset(KSZ8851_t *driver)
+{
+	ksz8851_transport_hard_reset(&ksz8851_transport, driver);
+
+	/* Recovery is waited by reading chip ID in ksz8851_init */
+}
+
+/**
+ * @brief Perform KSZ8851 software reset
+ * @param driver address of KSZ8851_Driver_Init_t struct that defined by user.
+ * @param reset_type type of reset
+ * @return process status
+ */
+static KSZ8851_Status_t ksz8851_soft_reset(KSZ8851_t *driver, uint8_t soft_reset_type)
+{
+	return ksz8851_transport_soft_reset(&ksz8851_transport, driver, soft_reset_type);
 }
 
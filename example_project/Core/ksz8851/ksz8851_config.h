@@ -0,0 +1,82 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_config.h
+ * @description : 	This file provides configuration settings to source and header files of ksz8851 that is how to compiling or working
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	03.07.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+ 
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+ 
+ ******************************************************************************/
+ 
+ /* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_CONFIG_H
+#define __KSZ8851_CONFIG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_INIT_USE_DEFAULT_DRIVER_SETTINGS						1				// if user wnats to use its own settings for ksz configuration, this defination must be disable.
+//#define KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER						1				// if user wants to use non blocking spi functions (with interrupt or dma) or to control CS pin on upper layer, this defination must be enable
+//#define KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE				1				// if user wants to use non blocking spi functions (with interrupt or dma), this defination must be enable
+
+#define KSZ_BUS_CONFIG_MAX_INSTANCES								2				// number of KSZ8851 chips which can share one spi bus through ksz8851_bus (max 8)
+#define KSZ_BUS_CONFIG_AGING_LIMIT									4				// a waiting instance gains one priority level each time it is skipped, up to this limit, so low priority chips aren't starved
+
+#define KSZ_FLOW_CONFIG_RX_DRAIN_RATE_KBPS							1000			// rate which host reads frames from RXQ (kbytes/s), default watermarks are derived from it
+#define KSZ_FLOW_CONFIG_SERVICE_LATENCY_US							1000			// worst case time between INTRN and start of RXQ draining (us)
+
+#define KSZ_RX_CONFIG_DATA_BURST									KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN	// SPI RX data burst set by init, 4/8/16/32 bytes bursts suit spi dma which can't read a whole frame in one transfer
+
+#define KSZ_RX_CONFIG_PEEK_SIZE										32				// frame bytes passed to RX_PeekFrame callback (destination MAC .. L4 ports), rounded up to fifo dword alignment
+
+#define KSZ_FASTPATH_CONFIG_MAX_FRAME								128				// longest ARP / ICMP echo request (without CRC) answered by RX fast path, it is read to stack
+
+#define KSZ_TX_CONFIG_PRIORITIES									3				// number of strict priority TX queues, priority 0 is sent first
+#define KSZ_TX_CONFIG_QUEUE_DEPTH									8				// frames held by each TX queue until TXQ has room for them
+#define KSZ_TX_CONFIG_TRACK_DEPTH									8				// transmitted frames tracked by frame ID until TX_FrameDone reports them (max 63)
+#define KSZ_UDP_CONFIG_MAX_FLOWS									2				// UDP header templates held by driver for ksz8851_udp_send
+#define KSZ_TX_CONFIG_RESERVED_BYTES								0				// TXQ memory (bytes) that lower priorities leave free for priority 0 frames, 0 disables reservation
+
+//#define KSZ_HIST_CONFIG_LATENCY									1				// built-in latency histograms (RX interrupt to delivery, send call to TXQ enqueue, fifo transfer), they take about 320 bytes of driver RAM and timestamps on every frame
+#define KSZ_HIST_CONFIG_BUCKETS										16				// log2 buckets of each histogram, last bucket collects all longer latencies
+
+#define KSZ_CLASS_CONFIG_MAX_CLASSES								4				// number of RX classes (queues) of ksz8851_classifier, class 0 has highest priority
+#define KSZ_CLASS_CONFIG_MAX_RULES									8				// number of EtherType/VLAN rules of ksz8851_classifier
+#define KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH							16				// maximum frames held by each class queue
+
+#define KSZ_POOL_CONFIG_SMALL_SIZE									128				// data bytes of small buffers of ksz8851_pool (ARP, TCP ACK, short UDP)
+#define KSZ_POOL_CONFIG_SMALL_COUNT									8
+#define KSZ_POOL_CONFIG_MEDIUM_SIZE									512
+#define KSZ_POOL_CONFIG_MEDIUM_COUNT								4
+#define KSZ_POOL_CONFIG_LARGE_SIZE									1536			// large buffers hold a full size frame
+#define KSZ_POOL_CONFIG_LARGE_COUNT									4
+
+#define KSZ_POLL_CONFIG_ENTER_FRAMES								4				// RX interrupt switches to polling mode if RXQ holds at least this many frames, 0 disables polling mode
+#define KSZ_POLL_CONFIG_BUDGET										8				// frames drained by each ksz8851_poll call of driver service
+
+#define KSZ_SERVICE_CONFIG_TASK_STACK_SIZE							1024			// stack size of driver task created by ksz8851_service (in bytes, meaning depends on OS port)
+#define KSZ_SERVICE_CONFIG_TASK_PRIORITY							3				// priority of driver task created by ksz8851_service (meaning depends on OS port)
+#define KSZ_SERVICE_CONFIG_POLL_IDLE_MS								1				// driver task in polling mode waits INTRN this long after a poll round which found no frame
+#define KSZ_SERVICE_CONFIG_IRQ_TIMEOUT_MS							100				// driver task checks interrupt status also if INTRN isn't signalled in this time, so a missed edge doesn't stall the chip
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_H */
+
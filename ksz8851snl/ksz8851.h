@@ -40,6 +40,11 @@ extern "C"
 #define KSZ_TIME_WAIT_1MS										1
 #define KSZ_TIME_WAIT_10MS										10
 #define KSZ_TIME_WAIT_20MS										20
+#define KSZ_TIME_US_PER_MS										1000
+#define KSZ_TIME_HARD_RESET_PULSE_US							10000		//RSTN low time (datasheet min 10 ms)
+#define KSZ_TIME_HARD_RESET_TIMEOUT_US							200000		//chip ID must be readable in this time after RSTN goes high
+#define KSZ_TIME_SOFT_RESET_US									1000		//GRR reset bit hold time and recovery time
+#define KSZ_TIME_RX_RELEASE_TIMEOUT_US							100			//self clearing RRXEF bit must clear in this time
 
 #define KSZ_PROCESS_TRY_LIMIT									3
 
@@ -47,9 +52,12 @@ extern "C"
 #define KSZ_REG_BUFF_BYTE1										1
 #define KSZ_REG_BUFF_BYTE2										2
 #define KSZ_REG_BUFF_BYTE3										3
+#define KSZ_REG_BUFF_BYTE4										4
+#define KSZ_REG_BUFF_BYTE5										5
 
 #define KSZ_REG_CMD_BUFF_SIZE									4			//bytes
 #define KSZ_REG_DATA_BUFF_SIZE									4			//bytes
+#define KSZ_REG32_CMD_BUFF_SIZE									6			//bytes, 2 bytes command and 4 bytes data of register pair
 
 #define KSZ_REG_CMD_BYTE0_MASK									0xFF00		//masks LSB byte of command to put one byte buffer
 #define KSZ_REG_CMD_BYTE1_MASK									0x00FF		//masks MSB byte of command to put one byte buffer
@@ -62,6 +70,8 @@ extern "C"
 
 #define KSZ_REG_BYTES_SELECT_0_1_MASK_VALUE						0x03		//to select register's byte0 and byte1
 #define KSZ_REG_BYTES_SELECT_2_3_MASK_VALUE						0x0C		//to select register's byte2 and byte3
+#define KSZ_REG_BYTES_SELECT_ALL_MASK_VALUE						0x0F		//to select all 4 bytes of dword aligned register pair
+#define KSZ_REG_DWORD_ADDR_MASK_VALUE							0xFC		//register pair accesses must start on dword aligned address
 #define KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE					10			//shifting step the selected register bytes between frame bits 10-13
 
 #define KSZ_DWORD_VALUE											4			// Dword (32 bit, 4 byte)
@@ -69,6 +79,82 @@ extern "C"
 #define KSZ_RX_FRAME_LEN_MULTIPLE_VALUE							0x03		//While Rx frame reading from KSZ frame data must be reading dword aligned (multiple of 4 bytes).
 																			//bitwise and this value with rx frame len give us idea how many bytes pad there will be in the rx frame reading
 																			//ref: KSZ datasheet section 3.5.6
+#define KSZ_RX_FRAME_BYTE_COUNT_MASK							0x0FFF		//bit 11-0 of RXFHBCR: receive byte count of frame
+
+#define KSZ_FIFO_CMD_READ										0x80		//SPI command byte to read RXQ fifo (opcode 10b in bit 7-6)
+#define KSZ_FIFO_CMD_WRITE										0xC0		//SPI command byte to write TXQ fifo (opcode 11b in bit 7-6)
+#define KSZ_FIFO_CMD_SIZE										1			//bytes
+#define KSZ_RX_FIFO_DUMMY_SIZE									4			//dummy bytes at the beginning of RXQ fifo read
+#define KSZ_RX_FIFO_HEADER_SIZE									4			//frame status (2 bytes) and byte count (2 bytes) after dummy bytes
+#define KSZ_RX_IP_OFFSET_SIZE									2			//bytes added before frame when KSZ_CONFIG_RX_CMD_IP_TWOBYTE_OFFSET_ENABLE is set
+#define KSZ_RX_FIFO_PREAMBLE_SIZE								(KSZ_RX_FIFO_DUMMY_SIZE + KSZ_RX_FIFO_HEADER_SIZE + KSZ_RX_IP_OFFSET_SIZE)	//bytes read from RXQ fifo before frame data
+#define KSZ_TX_FIFO_HEADER_SIZE									4			//control word (2 bytes) and byte count (2 bytes) before frame data
+#define KSZ_ETH_CRC_SIZE										4			//frame check sequence appended by MAC, counted in RXFHBCR
+#define KSZ_ETH_MAX_FRAME_SIZE									1514		//maximum ethernet frame without CRC
+#define KSZ_ETH_MIN_FRAME_SIZE									14			//ethernet header
+
+/* ARP / IPv4 / ICMP / UDP fields used by RX fast path and UDP flow templates, offsets from destination MAC address */
+#define KSZ_ETH_TYPE_OFFSET										12			// EtherType (or TPID of 802.1Q tag) offset in frame
+#define KSZ_ETH_SRC_MAC_OFFSET									6
+#define KSZ_ETH_HEADER_SIZE										14
+#define KSZ_ETH_TYPE_ARP										0x0806
+#define KSZ_ETH_TYPE_IPV4										0x0800
+#define KSZ_IPV4_ADDR_SIZE										4			//bytes
+#define KSZ_ARP_HTYPE_OFFSET									14
+#define KSZ_ARP_HTYPE_ETHERNET									1
+#define KSZ_ARP_PTYPE_OFFSET									16			//protocol type, KSZ_ETH_TYPE_IPV4
+#define KSZ_ARP_ADDR_SIZES_OFFSET								18
+#define KSZ_ARP_ADDR_SIZES										0x0604		//hardware / protocol address lengths
+#define KSZ_ARP_OPER_OFFSET										20
+#define KSZ_ARP_OPER_REQUEST									1
+#define KSZ_ARP_OPER_REPLY										2
+#define KSZ_ARP_SHA_OFFSET										22			//sender MAC
+#define KSZ_ARP_SPA_OFFSET										28			//sender IPv4
+#define KSZ_ARP_THA_OFFSET										32			//target MAC
+#define KSZ_ARP_TPA_OFFSET										38			//target IPv4
+#define KSZ_ARP_FRAME_SIZE										42
+#define KSZ_IPV4_VER_IHL_OFFSET									14
+#define KSZ_IPV4_VER_IHL_NO_OPTIONS								0x45		//version 4, 20 bytes header
+#define KSZ_IPV4_TOS_OFFSET										15
+#define KSZ_IPV4_TOTAL_LEN_OFFSET								16
+#define KSZ_IPV4_ID_OFFSET										18
+#define KSZ_IPV4_FRAGMENT_OFFSET								20
+#define KSZ_IPV4_FRAGMENT_MASK									0x3FFF		//more fragments flag and fragment offset
+#define KSZ_IPV4_DONT_FRAGMENT									0x4000
+#define KSZ_IPV4_TTL_OFFSET										22
+#define KSZ_IPV4_DEFAULT_TTL									64
+#define KSZ_IPV4_PROTOCOL_OFFSET								23
+#define KSZ_IPV4_PROTOCOL_ICMP									1
+#define KSZ_IPV4_PROTOCOL_UDP									17
+#define KSZ_IPV4_CHECKSUM_OFFSET								24
+#define KSZ_IPV4_SRC_OFFSET										26
+#define KSZ_IPV4_DST_OFFSET										30
+#define KSZ_IPV4_HEADER_SIZE									20
+#define KSZ_ICMP_TYPE_OFFSET									34
+#define KSZ_ICMP_CHECKSUM_OFFSET								36
+#define KSZ_ICMP_HEADER_SIZE									8
+#define KSZ_ICMP_ECHO_REQUEST									8
+#define KSZ_ICMP_ECHO_REPLY										0
+#define KSZ_UDP_SRC_PORT_OFFSET									34
+#define KSZ_UDP_DST_PORT_OFFSET									36
+#define KSZ_UDP_LENGTH_OFFSET									38
+#define KSZ_UDP_CHECKSUM_OFFSET									40
+#define KSZ_UDP_HEADER_SIZE										8
+#define KSZ_UDP_TEMPLATE_SIZE									42			//Ethernet, IPv4 and UDP headers before payload
+#define KSZ_UDP_MAX_PAYLOAD										(KSZ_ETH_MAX_FRAME_SIZE - KSZ_UDP_TEMPLATE_SIZE)
+
+#define KSZ_TX_CTRL_INT_ON_COMPLETION							0x8000		//TX control word: generate TX interrupt when this frame is transmitted
+#define KSZ_TX_CTRL_FRAME_ID_MASK								0x003F		//TX control word: frame ID of this frame
+
+#define KSZ_TXMIR_AVAILABLE_MASK								0x1FFF		//bit 12-0 of TXMIR: available TXQ memory in bytes
+#define KSZ_RXFCTR_FRAME_COUNT_SHIFT							8			//bit 15-8 of RXFCTR: number of frames in RXQ
+
+/* Rounds length up to multiple of dword as fifo operations require */
+#define KSZ_DWORD_ALIGN(length)									(((length) + KSZ_RX_FRAME_LEN_MULTIPLE_VALUE) & ~KSZ_RX_FRAME_LEN_MULTIPLE_VALUE)
+
+/* Bytes of RX buffer for a frame of length bytes without CRC. Fifo read copies CRC and dword padding behind the frame, padding
+ * counts 2 bytes IP header offset which is read before frame data (datasheet section 3.5.6) */
+#define KSZ_RX_BUFFER_SIZE(length)								(KSZ_DWORD_ALIGN((length) + KSZ_ETH_CRC_SIZE + KSZ_RX_IP_OFFSET_SIZE) - KSZ_RX_IP_OFFSET_SIZE)
 
 
 /* Specific configuration and status values for some register*/
@@ -93,6 +179,11 @@ extern "C"
 #define KSZ_CONFIG_TX_CTRL_UDP_CHECKSUM							0x0080		// Enable UDP frame checksum generation
 #define KSZ_CONFIG_TX_CTRL_ICMP_CHECKSUM						0x0100		// Enable ICMP frame checksum generation
 
+/* TXQ command register configuration values bit by bit */
+#define KSZ_CONFIG_TXQ_MANUAL_ENQUEUE							0x0001		// Enqueue TX frame in TXQ for transmission, self clearing
+#define KSZ_CONFIG_TXQ_MEMORY_AVAILABLE_MONITOR					0x0002		// Enable TXQ memory available monitor
+#define KSZ_CONFIG_TXQ_AUTO_ENQUEUE								0x0004		// Enable auto-enqueue TXQ frame
+
 /* QMU transmit status register values */
 
 /* TX frame data pointer register configuration values */
@@ -125,6 +216,8 @@ extern "C"
 #define KSZ_CONFIG_RX_CTRL2_DATA_BURST_16BYTES					0x0040		// 16 bytes SPI Receive Data Burst Length
 #define KSZ_CONFIG_RX_CTRL2_DATA_BURST_32BYTES					0x0060		// 32 bytes SPI Receive Data Burst Length
 #define KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN					0x0080		// Single frame data burst length
+#define KSZ_CONFIG_RX_CTRL2_DATA_BURST_MASK						0x00E0		// SPI Receive Data Burst Length field
+#define KSZ_CONFIG_RX_CTRL2_DATA_BURST_SHIFT					5
 
 
 /* RX frame count and threshold register configuration values */
@@ -139,6 +232,20 @@ extern "C"
 #define KSZ_CONFIG_RX_CMD_DURATION_TIM_THR_ENABLE				0x0080		// Enable RX interrupt on timer duration
 #define KSZ_CONFIG_RX_CMD_IP_TWOBYTE_OFFSET_ENABLE				0x0200		// Enable adding 2-bytes offset before IP frame header
 
+/* Receive frame header status register values bit by bit */
+#define KSZ_STATUS_RX_FRAME_CRC_ERROR							0x0001		// CRC error
+#define KSZ_STATUS_RX_FRAME_RUNT								0x0002		// Frame is shorter than 64 bytes
+#define KSZ_STATUS_RX_FRAME_TOO_LONG							0x0004		// Frame is longer than 2000 bytes
+#define KSZ_STATUS_RX_FRAME_MII_ERROR							0x0010		// MII symbol error
+#define KSZ_STATUS_RX_FRAME_UDP_CHECKSUM_ERROR					0x0400		// UDP checksum error
+#define KSZ_STATUS_RX_FRAME_TCP_CHECKSUM_ERROR					0x0800		// TCP checksum error
+#define KSZ_STATUS_RX_FRAME_IP_CHECKSUM_ERROR					0x1000		// IP checksum error
+#define KSZ_STATUS_RX_FRAME_ICMP_CHECKSUM_ERROR					0x2000		// ICMP checksum error
+#define KSZ_STATUS_RX_FRAME_VALID								0x8000		// Present frame in RXQ is valid
+#define KSZ_STATUS_RX_FRAME_ERRORS								(KSZ_STATUS_RX_FRAME_CRC_ERROR | KSZ_STATUS_RX_FRAME_RUNT | KSZ_STATUS_RX_FRAME_TOO_LONG | \
+																 KSZ_STATUS_RX_FRAME_MII_ERROR | KSZ_STATUS_RX_FRAME_UDP_CHECKSUM_ERROR | KSZ_STATUS_RX_FRAME_TCP_CHECKSUM_ERROR | \
+																 KSZ_STATUS_RX_FRAME_IP_CHECKSUM_ERROR | KSZ_STATUS_RX_FRAME_ICMP_CHECKSUM_ERROR)
+
 /* RX command register status values bit by bit */
 #define KSZ_STATUS_RX_CMD_FR_COUNT_THR_INT						0x0400		// RX interrupt is occured on frame count threshold
 #define KSZ_STATUS_RX_CMD_BYTE_COUNT_THR_INT					0x0800		// RX interrupt is occured on byte count threshold
@@ -167,43 +274,194 @@ extern "C"
 #define KSZ_CONFIG_PORT_TX_DISABLE               				0x4000   	// Disable port transmit
 #define KSZ_CONFIG_PORT_LED_OFF                  				0x8000   	// Turn off all the port LEDs (LED3/LED2/LED1/LED0)
 
+/* Wake-up frame control register configuration values bit by bit */
+#define KSZ_CONFIG_WAKEUP_FRAME0_ENABLE							0x0001		// Enable wake-up frame 0 filter
+#define KSZ_CONFIG_WAKEUP_FRAME1_ENABLE							0x0002		// Enable wake-up frame 1 filter
+#define KSZ_CONFIG_WAKEUP_FRAME2_ENABLE							0x0004		// Enable wake-up frame 2 filter
+#define KSZ_CONFIG_WAKEUP_FRAME3_ENABLE							0x0008		// Enable wake-up frame 3 filter
+#define KSZ_CONFIG_WAKEUP_MAGIC_PACKET_ENABLE					0x0080		// Enable magic packet detection
+#define KSZ_CONFIG_WAKEUP_FRAME_ALL								0x000F
+
+#define KSZ_WAKEUP_FRAME_FILTER_COUNT							4			// WF0 .. WF3
+#define KSZ_WAKEUP_FRAME_WINDOW_SIZE							64			// filters compare first 64 bytes of frame, one byte mask bit per byte
+#define KSZ_WAKEUP_FRAME_REG_SPACING							0x10		// address distance between WFn and WFn+1 registers
+#define KSZ_WAKEUP_FRAME_CRC_POLYNOMIAL							0x04C11DB7	// ethernet CRC-32 polynomial in normal form, see ksz8851_wakeup_crc for bit order
+
+/* Port 1 status register values bit by bit */
+#define KSZ_STATUS_PORT_LINK_GOOD								0x0020		// Link good
+
 /* Interrupt status flag's register configuration values bit by bit */
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
-//#define KSZ_FLAGS_INTERRUPTS_
+#define KSZ_FLAGS_INTERRUPTS_SPI_BUS_ERROR						0x0002		// SPI bus error
+#define KSZ_FLAGS_INTERRUPTS_ENERGY_DETECT						0x0004		// Energy detect
+#define KSZ_FLAGS_INTERRUPTS_LINKUP_DETECT						0x0008		// Wake-up from linkup detect
+#define KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET					0x0010		// Receive magic packet detect
+#define KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME					0x0020		// Receive wake-up frame detect
+#define KSZ_FLAGS_INTERRUPTS_TX_SPACE_AVAILABLE					0x0040		// Transmit memory space available
+#define KSZ_FLAGS_INTERRUPTS_RX_PROCESS_STOPPED					0x0100		// Receive process stopped
+#define KSZ_FLAGS_INTERRUPTS_TX_PROCESS_STOPPED					0x0200		// Transmit process stopped
+#define KSZ_FLAGS_INTERRUPTS_RX_OVERRUN							0x0800		// Receive overrun
+#define KSZ_FLAGS_INTERRUPTS_RX									0x2000		// Receive frame available
+#define KSZ_FLAGS_INTERRUPTS_TX									0x4000		// Transmit frame done
+#define KSZ_FLAGS_INTERRUPTS_LINK_CHANGE						0x8000		// Link status changed
 #define KSZ_FLAGS_INTERRUPTS_ALL_CLEAR							0xEB42		// Clear all interrupt flags
+#define KSZ_FLAGS_INTERRUPTS_DEFAULT							(KSZ_FLAGS_INTERRUPTS_LINK_CHANGE | KSZ_FLAGS_INTERRUPTS_RX | KSZ_FLAGS_INTERRUPTS_RX_OVERRUN | KSZ_FLAGS_INTERRUPTS_TX_SPACE_AVAILABLE)	// Interrupts enabled by ksz8851_init
+#define KSZ_CONFIG_PROFILE_DEFAULT								.interrupts = KSZ_FLAGS_INTERRUPTS_DEFAULT, .rx_burst = KSZ_RX_CONFIG_DATA_BURST, .rx_drain_rate_kBps = KSZ_FLOW_CONFIG_RX_DRAIN_RATE_KBPS	// init profile members of KSZ8851_Config_t initializer
+
+/* Status register fields as mask / shift pairs. Registers are copied to uint16_t once and decoded with KSZ_FIELD_GET,
+ * e.g. KSZ_FIELD_GET(txsr, KSZ_TXSR_FRAME_ID), which costs an AND and a shift. Single bit masks reuse the flags above */
+#define KSZ_FIELD_GET(value, field)								(((value) & field##_MASK) >> field##_SHIFT)
+#define KSZ_FIELD_SET(value, field, field_value)				(uint16_t)(((value) & ~field##_MASK) | (((field_value) << field##_SHIFT) & field##_MASK))
+
+/* TXSR (TX status register) */
+#define KSZ_TXSR_FRAME_ID_MASK									0x003F		// frame ID of the transmitted frame
+#define KSZ_TXSR_FRAME_ID_SHIFT									0
+#define KSZ_TXSR_MAX_COLLISION_MASK								0x1000		// transmission failed, maximum collisions
+#define KSZ_TXSR_MAX_COLLISION_SHIFT							12
+#define KSZ_TXSR_LATE_COLLISION_MASK							0x2000		// transmission failed, late collision
+#define KSZ_TXSR_LATE_COLLISION_SHIFT							13
+
+/* RXFHSR (RX frame header status register) */
+#define KSZ_RXFHSR_CRC_ERROR_MASK								KSZ_STATUS_RX_FRAME_CRC_ERROR
+#define KSZ_RXFHSR_CRC_ERROR_SHIFT								0
+#define KSZ_RXFHSR_RUNT_MASK									KSZ_STATUS_RX_FRAME_RUNT
+#define KSZ_RXFHSR_RUNT_SHIFT									1
+#define KSZ_RXFHSR_TOO_LONG_MASK								KSZ_STATUS_RX_FRAME_TOO_LONG
+#define KSZ_RXFHSR_TOO_LONG_SHIFT								2
+#define KSZ_RXFHSR_ETHERNET_TYPE_MASK							0x0008		// frame is ethernet type (length/type field > 1500)
+#define KSZ_RXFHSR_ETHERNET_TYPE_SHIFT							3
+#define KSZ_RXFHSR_MII_ERROR_MASK								KSZ_STATUS_RX_FRAME_MII_ERROR
+#define KSZ_RXFHSR_MII_ERROR_SHIFT								4
+#define KSZ_RXFHSR_UNICAST_MASK									0x0020		// unicast frame
+#define KSZ_RXFHSR_UNICAST_SHIFT								5
+#define KSZ_RXFHSR_MULTICAST_MASK								0x0040		// multicast frame
+#define KSZ_RXFHSR_MULTICAST_SHIFT								6
+#define KSZ_RXFHSR_BROADCAST_MASK								0x0080		// broadcast frame
+#define KSZ_RXFHSR_BROADCAST_SHIFT								7
+#define KSZ_RXFHSR_UDP_CHECKSUM_ERROR_MASK						KSZ_STATUS_RX_FRAME_UDP_CHECKSUM_ERROR
+#define KSZ_RXFHSR_UDP_CHECKSUM_ERROR_SHIFT						10
+#define KSZ_RXFHSR_TCP_CHECKSUM_ERROR_MASK						KSZ_STATUS_RX_FRAME_TCP_CHECKSUM_ERROR
+#define KSZ_RXFHSR_TCP_CHECKSUM_ERROR_SHIFT						11
+#define KSZ_RXFHSR_IP_CHECKSUM_ERROR_MASK						KSZ_STATUS_RX_FRAME_IP_CHECKSUM_ERROR
+#define KSZ_RXFHSR_IP_CHECKSUM_ERROR_SHIFT						12
+#define KSZ_RXFHSR_ICMP_CHECKSUM_ERROR_MASK						KSZ_STATUS_RX_FRAME_ICMP_CHECKSUM_ERROR
+#define KSZ_RXFHSR_ICMP_CHECKSUM_ERROR_SHIFT					13
+#define KSZ_RXFHSR_VALID_MASK									KSZ_STATUS_RX_FRAME_VALID
+#define KSZ_RXFHSR_VALID_SHIFT									15
+
+/* ISR (interrupt status register) */
+#define KSZ_ISR_SPI_BUS_ERROR_MASK								KSZ_FLAGS_INTERRUPTS_SPI_BUS_ERROR
+#define KSZ_ISR_SPI_BUS_ERROR_SHIFT								1
+#define KSZ_ISR_ENERGY_DETECT_MASK								KSZ_FLAGS_INTERRUPTS_ENERGY_DETECT
+#define KSZ_ISR_ENERGY_DETECT_SHIFT								2
+#define KSZ_ISR_LINKUP_DETECT_MASK								KSZ_FLAGS_INTERRUPTS_LINKUP_DETECT
+#define KSZ_ISR_LINKUP_DETECT_SHIFT								3
+#define KSZ_ISR_RX_MAGIC_PACKET_MASK							KSZ_FLAGS_INTERRUPTS_RX_MAGIC_PACKET
+#define KSZ_ISR_RX_MAGIC_PACKET_SHIFT							4
+#define KSZ_ISR_RX_WAKEUP_FRAME_MASK							KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME
+#define KSZ_ISR_RX_WAKEUP_FRAME_SHIFT							5
+#define KSZ_ISR_TX_SPACE_AVAILABLE_MASK							KSZ_FLAGS_INTERRUPTS_TX_SPACE_AVAILABLE
+#define KSZ_ISR_TX_SPACE_AVAILABLE_SHIFT						6
+#define KSZ_ISR_RX_PROCESS_STOPPED_MASK							KSZ_FLAGS_INTERRUPTS_RX_PROCESS_STOPPED
+#define KSZ_ISR_RX_PROCESS_STOPPED_SHIFT						8
+#define KSZ_ISR_TX_PROCESS_STOPPED_MASK							KSZ_FLAGS_INTERRUPTS_TX_PROCESS_STOPPED
+#define KSZ_ISR_TX_PROCESS_STOPPED_SHIFT						9
+#define KSZ_ISR_RX_OVERRUN_MASK									KSZ_FLAGS_INTERRUPTS_RX_OVERRUN
+#define KSZ_ISR_RX_OVERRUN_SHIFT								11
+#define KSZ_ISR_RX_MASK											KSZ_FLAGS_INTERRUPTS_RX
+#define KSZ_ISR_RX_SHIFT										13
+#define KSZ_ISR_TX_MASK											KSZ_FLAGS_INTERRUPTS_TX
+#define KSZ_ISR_TX_SHIFT										14
+#define KSZ_ISR_LINK_CHANGE_MASK								KSZ_FLAGS_INTERRUPTS_LINK_CHANGE
+#define KSZ_ISR_LINK_CHANGE_SHIFT								15
+
+/* P1MBSR (PHY 1 MII basic status register) */
+#define KSZ_P1MBSR_EXTENDED_CAPABLE_MASK						0x0001		// extended register capable
+#define KSZ_P1MBSR_EXTENDED_CAPABLE_SHIFT						0
+#define KSZ_P1MBSR_JABBER_TEST_MASK								0x0002		// not supported by KSZ8851
+#define KSZ_P1MBSR_JABBER_TEST_SHIFT							1
+#define KSZ_P1MBSR_LINK_MASK									0x0004		// link is up
+#define KSZ_P1MBSR_LINK_SHIFT									2
+#define KSZ_P1MBSR_AN_CAPABLE_MASK								0x0008		// auto-negotiation capable
+#define KSZ_P1MBSR_AN_CAPABLE_SHIFT								3
+#define KSZ_P1MBSR_AN_COMPLETE_MASK								0x0020		// auto-negotiation complete
+#define KSZ_P1MBSR_AN_COMPLETE_SHIFT							5
+#define KSZ_P1MBSR_PREAMBLE_SUPPRESSED_MASK						0x0040		// not supported by KSZ8851
+#define KSZ_P1MBSR_PREAMBLE_SUPPRESSED_SHIFT					6
+#define KSZ_P1MBSR_10BT_HALF_CAPABLE_MASK						0x0800		// 10BASE-T half-duplex capable
+#define KSZ_P1MBSR_10BT_HALF_CAPABLE_SHIFT						11
+#define KSZ_P1MBSR_10BT_FULL_CAPABLE_MASK						0x1000		// 10BASE-T full-duplex capable
+#define KSZ_P1MBSR_10BT_FULL_CAPABLE_SHIFT						12
+#define KSZ_P1MBSR_100BT_HALF_CAPABLE_MASK						0x2000		// 100BASE-TX half-duplex capable
+#define KSZ_P1MBSR_100BT_HALF_CAPABLE_SHIFT						13
+#define KSZ_P1MBSR_100BT_FULL_CAPABLE_MASK						0x4000		// 100BASE-TX full-duplex capable
+#define KSZ_P1MBSR_100BT_FULL_CAPABLE_SHIFT						14
+#define KSZ_P1MBSR_100BT4_CAPABLE_MASK							0x8000		// 100BASE-T4 capable
+#define KSZ_P1MBSR_100BT4_CAPABLE_SHIFT							15
+
+/* P1SR (port 1 status register) */
+#define KSZ_P1SR_PARTNER_10BT_HALF_MASK							0x0001		// link partner 10BT half-duplex capable
+#define KSZ_P1SR_PARTNER_10BT_HALF_SHIFT						0
+#define KSZ_P1SR_PARTNER_10BT_FULL_MASK							0x0002		// link partner 10BT full-duplex capable
+#define KSZ_P1SR_PARTNER_10BT_FULL_SHIFT						1
+#define KSZ_P1SR_PARTNER_100BT_HALF_MASK						0x0004		// link partner 100BT half-duplex capable
+#define KSZ_P1SR_PARTNER_100BT_HALF_SHIFT						2
+#define KSZ_P1SR_PARTNER_100BT_FULL_MASK						0x0008		// link partner 100BT full-duplex capable
+#define KSZ_P1SR_PARTNER_100BT_FULL_SHIFT						3
+#define KSZ_P1SR_PARTNER_FLOW_CONTROL_MASK						0x0010		// link partner flow control (pause) capable
+#define KSZ_P1SR_PARTNER_FLOW_CONTROL_SHIFT						4
+#define KSZ_P1SR_LINK_GOOD_MASK									KSZ_STATUS_PORT_LINK_GOOD
+#define KSZ_P1SR_LINK_GOOD_SHIFT								5
+#define KSZ_P1SR_AN_DONE_MASK									0x0040		// auto-negotiation done
+#define KSZ_P1SR_AN_DONE_SHIFT									6
+#define KSZ_P1SR_MDI_X_MASK										0x0080		// MDI enabled, MDI-X disabled
+#define KSZ_P1SR_MDI_X_SHIFT									7
+#define KSZ_P1SR_FULL_DUPLEX_MASK								0x0200		// operation duplex is full
+#define KSZ_P1SR_FULL_DUPLEX_SHIFT								9
+#define KSZ_P1SR_SPEED_100_MASK									0x0400		// operation speed is 100 Mbps
+#define KSZ_P1SR_SPEED_100_SHIFT								10
+#define KSZ_P1SR_POLARITY_REVERSED_MASK							0x2000		// polarity is reversed
+#define KSZ_P1SR_POLARITY_REVERSED_SHIFT						13
+#define KSZ_P1SR_HP_AUTO_MDIX_MASK								0x8000		// HP Auto MDI-X mode (reset: Microchip Auto MDI-X)
+#define KSZ_P1SR_HP_AUTO_MDIX_SHIFT								15
 
 /* Flow control watermark configuration values */
 #define KSZ_CONFIG_WATERMARK_4KB								0x0400		// 4KB watermark
 #define KSZ_CONFIG_WATERMARK_6KB								0x0600		// 6KB watermark
+#define KSZ_CONFIG_WATERMARK_UNIT								4			// watermark registers count available RXQ space in dwords
+#define KSZ_CONFIG_WATERMARK_MASK								0x1FFF
+#define KSZ_CONFIG_WATERMARK_OVERRUN_DEFAULT					256			// bytes, reset value of FCOWR
 
+#define KSZ_RXQ_SIZE											12288		// RXQ memory in bytes
+#define KSZ_ETH_LINE_RATE_KBPS									12500		// 100BASE-TX line rate in kbytes/s
+#define KSZ_ETH_WIRE_FRAME_SIZE									1518		// maximum frame in RXQ including CRC
 
-#define KSZ_CONFIG_CLEAR_ALL_BITS								0x0000
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
-//#define KSZ_CONFIG_
 
+#define KSZ_CONFIG_CLEAR_ALL_BITS								0x0000
 
+/* Reserved bit masks of registers (ref: KSZ datasheet section 4.2 Register Map). Reserved bits must be written with their reset value */
+#define KSZ_REG_RESERVED_OBCR									0xFFB8
+#define KSZ_REG_RESERVED_EEPCR									0xFFC0
+#define KSZ_REG_RESERVED_GRR									0xFFFC
+#define KSZ_REG_RESERVED_WFCR									0xFF70
+#define KSZ_REG_RESERVED_TXCR									0xFE00
+#define KSZ_REG_RESERVED_RXCR1									0x000C
+#define KSZ_REG_RESERVED_RXCR2									0xFF00
+#define KSZ_REG_RESERVED_TXQCR									0xFFF8
+#define KSZ_REG_RESERVED_RXQCR									0xE106
+#define KSZ_REG_RESERVED_FDPR									0xB800		// TXFDPR and RXFDPR
+#define KSZ_REG_RESERVED_IER									0x1480
+#define KSZ_REG_RESERVED_ISR									0x1481
+#define KSZ_REG_RESERVED_FCWR									0xE000		// FCLWR, FCHWR and FCOWR
+#define KSZ_REG_RESERVED_PHYRR									0xFFFE
+#define KSZ_REG_RESERVED_P1ANAR									0x5A00
+#define KSZ_REG_RESERVED_P1CR									0x1900
+
+/* Register descriptor flags */
+#define KSZ_REG_FLAG_READ_ONLY									0x01		// Register is read only, writes have no effect
+#define KSZ_REG_FLAG_HOST_OWNED									0x02		// Register content is changed only by host writes
+#define KSZ_REG_FLAG_VOLATILE									0x04		// Chip changes register content (status, self clearing or write 1 to clear bits), it can't be derived from reset value
+
+#define KSZ_REG_DESCRIPTOR_COUNT								128			// One descriptor per 16 bit register, index is (address >> 1)
 
 /* Enums ---------------------------------------------------------------------*/
 
@@ -479,176 +737,245 @@ enum
 
 /* Structs -------------------------------------------------------------------*/
 
+/* Static description of a 16 bit register, it is used to write reserved bits without reading them first */
 typedef struct
 {
-	uint32_t (*TIME_GetTick)(void);																						// function pointer for user callback. To get sys tick value to use between process.
-	KSZ8851_Status_t  (*SPI_TransmitData)(uint8_t *pTxBuffer, uint16_t dataLength);										// function pointer for user callback. To transmit data (simplex) using default spi func.
-	KSZ8851_Status_t  (*SPI_ReceiveData)(uint8_t *pRxBuffer, uint16_t dataLength);
-	KSZ8851_Status_t  (*SPI_TransmitReceiveData)(uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);			// function pointer for user callback. To transmit and receive (full duplex) using default spi func.
-	void  	 (*GPIO_Control)(uint32_t port, uint16_t pin, uint8_t pinStatus);											// function pointer for user callback. To select slave before spi comm or to control reset input of ksz8851
+	uint16_t reset_value;
+	uint16_t reserved_mask;
+	uint8_t  flags;
+
+}KSZ8851_Reg_Descriptor_t;
+
+typedef struct
+{
+	uint32_t		timestamp;								// TIME_Timestamp value at RX interrupt entry (or ksz8851_poll call) / at TX done interrupt
+	uint16_t		status;									// RXFHSR of received frame, TXSR of transmitted frame (KSZ_TXSR_MAX_COLLISION / LATE_COLLISION mean failure)
+	uint16_t		length;									// frame length without CRC
+	uint8_t			frame_id;								// frame ID of transmitted frame (KSZ_TXSR_FRAME_ID), 0 for received frame
+	uint8_t			*buffer;								// frame buffer given to send function / received frame buffer
+
+}KSZ8851_Frame_Info_t;
+
+typedef struct
+{
+	uint32_t (*TIME_GetTick)(void *user);																				// function pointer for user callback. To get sys tick value to use between process.
+	KSZ8851_Status_t  (*SPI_TransmitData)(void *user, uint8_t *pTxBuffer, uint16_t dataLength);							// function pointer for user callback. To transmit data (simplex) using default spi func.
+	KSZ8851_Status_t  (*SPI_ReceiveData)(void *user, uint8_t *pRxBuffer, uint16_t dataLength);
+	KSZ8851_Status_t  (*SPI_TransmitReceiveData)(void *user, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);	// function pointer for user callback. To transmit and receive (full duplex) using default spi func.
+	void  	 (*GPIO_Control)(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus);								// function pointer for user callback. To select slave before spi comm or to control reset input of ksz8851
+	void	*user;																										// user context of the instance, it's passed as first argument to all callbacks (e.g. spi handle of the chip)
+
+	/* Optional callbacks, can be NULL */
+	uint32_t (*TIME_GetTickUs)(void *user);																			// function pointer for user callback. Free running microsecond counter (e.g. timer or cycle counter), driver waits use TIME_GetTick in ms resolution without it.
+	void	 (*TIME_Yield)(void *user);																					// function pointer for user callback. Called in each iteration of driver waits (e.g. OS yield), waits spin without it.
+	uint32_t (*TIME_Timestamp)(void *user);																			// function pointer for user callback. High resolution timestamp (cycle counter or timer) of frame metadata, frames aren't timestamped without it.
+	uint8_t* (*RX_GetBuffer)(void *user, uint16_t frameLength);															// function pointer for user callback. Returns buffer for received frame (at least KSZ_RX_BUFFER_SIZE(frameLength) bytes) or NULL to drop it.
+	void	 (*RX_FrameReceived)(void *user, uint8_t *pRxBuffer, uint16_t frameLength);									// function pointer for user callback. Hands received frame (without CRC) over to upper layer, buffer belongs to user again.
+	bool	 (*RX_PeekFrame)(void *user, const uint8_t *pHeader, uint16_t headerLength, uint16_t frameLength);			// function pointer for user callback. Gets first bytes of a frame before RX_GetBuffer, returns false to release frame without reading the rest.
+	void	 (*LINK_StatusChanged)(void *user, bool linkUp);																// function pointer for user callback. Called from ksz8851_irq_handler when link goes up or down.
+	void	 (*WAKEUP_Detected)(void *user, uint16_t events);															// function pointer for user callback. Called from ksz8851_irq_handler with KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME / RX_MAGIC_PACKET flags.
+	void	 (*FLOW_Backpressure)(void *user, bool asserted, uint8_t rxFrameCount);										// function pointer for user callback. Called when RXQ occupancy crosses high (asserted) or low (released) mark.
+	void	 (*POLL_Schedule)(void *user);																					// function pointer for user callback. Called when RX switches to polling mode, ksz8851_poll must be called until polling ends.
+	void	 (*RX_FrameInfo)(void *user, const KSZ8851_Frame_Info_t *info);												// function pointer for user callback. Called just before RX_FrameReceived with metadata (timestamp, status) of the same frame.
+	void	 (*TX_FrameDone)(void *user, const KSZ8851_Frame_Info_t *info);												// function pointer for user callback. Called from ksz8851_irq_handler once for each transmitted frame in send order, frames are tagged with frame ID and request TX done interrupt only if it is set.
+	void	 (*TX_BufferReleased)(void *user, uint8_t *pTxBuffer, uint16_t frameLength);								// function pointer for user callback. Frame of ksz8851_tx_enqueue is copied to TXQ, buffer belongs to user again.
+	KSZ8851_Status_t  (*SPI_TransmitThenReceive)(void *user, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength, uint8_t *pRxBuffer, uint16_t rxLength);	// function pointer for user callback. Transmits, then receives rxHeaderLength bytes to pRxHeader and rxLength bytes to pRxBuffer (half duplex, either length can be 0) as one chained transfer, replaces SPI_TransmitData + SPI_ReceiveData of fifo reads.
+	KSZ8851_Status_t  (*SPI_TransmitThenTransmit)(void *user, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength, uint8_t paddingLength);	// function pointer for user callback. Transmits two buffers and paddingLength (0..3) bytes of any content as one chained transfer, replaces SPI_TransmitData calls of fifo writes.
 
 }KSZ8851_Callbacks_t;
 
 typedef struct
 {
 #if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
-	volatile uint32_t cs_port;
+	uint32_t cs_port;
 #endif
 
-	volatile uint32_t rst_port;
+	uint32_t rst_port;
 
 #if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
-	volatile uint16_t cs_pin;
+	uint16_t cs_pin;
 #endif
 
-	volatile uint16_t rst_pin;
+	uint16_t rst_pin;
 
 }KSZ8851_Interface_t;
 
-typedef union
+typedef struct
+{
+	KSZ8851_Callbacks_t				functions;				// user callbacks
+	KSZ8851_Interface_t				interface;				// chip select and hard reset pins
+	uint8_t							MAC_address[KSZ_MAC_ADDRR_LEN];	// Ethernet MAC address, byte 0 is MSB of MAC high address
+	uint16_t						interrupts;				// IER value written by ksz8851_init, e.g. KSZ_FLAGS_INTERRUPTS_DEFAULT
+	uint16_t						rx_burst;				// SPI RX data burst set by ksz8851_init, e.g. KSZ_RX_CONFIG_DATA_BURST
+	uint32_t						rx_drain_rate_kBps;		// default flow control watermarks are derived from it, e.g. KSZ_FLOW_CONFIG_RX_DRAIN_RATE_KBPS
+	const uint8_t					*fastpath_ipv4;			// IPv4 addresses answered by ARP / ICMP echo fast path, KSZ_IPV4_ADDR_SIZE bytes each in network order, NULL disables it. Echo reply checksum is updated by driver, TXCR ICMP checksum generation stays off
+	uint8_t							fastpath_ipv4_count;	// number of fastpath_ipv4 addresses
+
+}KSZ8851_Config_t;
+
+/* Copies of status registers. Fields are decoded by KSZ_FIELD_GET with KSZ_<register>_<field> masks, bitfield layout isn't portable */
+typedef struct
+{
+	uint16_t		Tx;										// TXSR, KSZ_TXSR_xxx fields
+	uint16_t		Rx_Frame_Header;						// RXFHSR of present frame, KSZ_RXFHSR_xxx fields
+	uint16_t		Interrupt;								// ISR, KSZ_ISR_xxx fields
+	uint16_t		PHY1_MII_Basic;							// P1MBSR, KSZ_P1MBSR_xxx fields
+	uint16_t		Port1;									// P1SR, KSZ_P1SR_xxx fields
+
+}KSZ8851_Status_Reg_t;
+
+
+typedef struct
 {
-	volatile uint8_t bytes[KSZ_MAC_ADDRR_LEN];								// All bytes of MAC Address. byte[0] indicates MSB of MAC high address
+	KSZ8851_Status_Reg_t Status;
 
-	struct
-	{
-		volatile uint16_t high;												// Example MAC: 01:23:45:67:89:ab   High addr is, 0x0123.
-		volatile uint16_t middle;
-		volatile uint16_t low;
-	}Group;
+}KSZ8851_Registers_t;
 
-}MAC_Address_t;
+typedef struct
+{
+	uint8_t			offset;									// offset of first pattern byte from beginning of frame (destination MAC address)
+	uint8_t			length;									// number of pattern bytes, offset + length <= KSZ_WAKEUP_FRAME_WINDOW_SIZE
+	const uint8_t	*bytes;									// pattern bytes
+	const uint8_t	*mask;									// bit n of mask[n / 8] selects bytes[n] for comparison, NULL compares all bytes
+
+}KSZ8851_WakeUp_Pattern_t;
 
 typedef struct
 {
-	union
-		{
-			volatile uint16_t all;
-
-			struct
-			{
-				volatile uint16_t	frame_ID					:6,
-									Reserved0					:6,
-									max_Collision				:1,
-									late_Collision				:1,
-									Reserved1					:2;
-			}Bits;
-
-		}Tx;
-
-	union
-		{
-			volatile uint16_t all;
-
-			struct
-			{
-				volatile uint16_t	crc_Error					:1,
-									runt_Frame					:1,
-									frame_Too_Long				:1,
-									ethernet_Type_Frame			:1,
-									MII_Error					:1,
-									unicast_Frame				:1,
-									multicast_Frame				:1,
-									broadcast_Frame				:1,
-									Reserved0					:2,
-									UDP_Frame_Checksum			:1,
-									TCP_Frame_Checksum			:1,
-									IP_Frame_Checksum			:1,
-									ICMP_Frame_Checksum			:1,
-									Reserved1					:1,
-									present_Frame_Valid			:1;
-			}Bits;
-
-		}Rx_Frame_Header;
-
-	union
-		{
-			volatile uint16_t all;
-
-			struct
-			{
-				volatile uint16_t	Reserved0					:1,
-									SPI_Bus_Error				:1,						// When this bit is set, it indicates that SPI bus error status has occurred.
-									energy_Detect				:1,						// When this bit is set, it depends what it indicates according to IER bit 2 and bit 1. Checkout datasheet of product.
-									linkup_Detect				:1,						// When this bit is set, it indicates that wake-up from linkup detect statushas occurred.
-									Rx_Magic_Packet_Detect		:1,						// When this bit is set, it indicates that Receive magic packet detect status has occurred.
-									Rx_Wakeup_Fr_Detect			:1,						// When this bit is set, it indicates that Receive wakeup frame detect status has occurred.
-									Tx_Space_Available			:1,						// When this bit is set, it indicates that Transmit memory space available status has occurred.
-									Reserved1					:1,
-									Rx_Process_Stopped			:1,						// When this bit is set, it indicates that the Receive Process has stopped
-									Tx_Process_Stopped			:1,						// When this bit is set, it indicates that the Transmit Process has stopped.
-									Reserved2					:1,
-									Rx_Overrun					:1,						// When this bit is set, it indicates that the Receive Overrun status has occurred.
-									Reserved3					:1,
-									Rx_Frame_Available			:1,						// When this bit is set, it indicates that the QMU RXQ has received at least a frame from the MAC interface and the frame is ready for the host CPU to process
-									Tx_Frame_Available			:1,						// When this bit is set, it indicates that the TXQ MAC has transmitted at least a frame on the MAC interface and the QMU TXQ is ready for new frames from the host
-									link_Status_Changed			:1;						// When this bit is set, it indicates that the link status has changed from link up to link down, or link down to link up.
-			}Bits;
-
-		}Interrupt;
-
-	union
-		{
-			volatile uint16_t all;
-
-			struct
-			{
-				volatile uint16_t	extended_Reg_Capable		:1,						// When this bit is set, it indicates that extended register is capable.
-									jabber_Test					:1,						// Not supported by KSZ8851
-									link						:1,						// When this bit is set, it indicates that link is up.(reset: link is down)
-									auto_Negotiation_Capable	:1,						// When this bit is set, it indicates that auto-negotiation capable.
-									Reserved0					:1,
-									auto_Negotiation_Complete	:1,						// When this bit is set, it indicates that auto-negotiation complete.
-									preamble_Suppressed			:1,						// Not supported by KSZ8851
-									Reserved1					:4,
-									Base10_Half_Capable			:1,						// When this bit is set, it indicates that 10BASE-T half-duplex capable.
-									Base10_Full_Capable			:1,						// When this bit is set, it indicates that 10BASE-T full-duplex capable.
-									Base100_Half_Capable		:1,						// When this bit is set, it indicates that 100BASE-T half-duplex capable.
-									Base100_Full_Capable		:1,						// When this bit is set, it indicates that 100BASE-TX full-duplex capable.
-									Base100_T4_Capable			:1;						// When this bit is set, it indicates that 100BASE-T4 capable.
-			}Bits;
-
-		}PHY1_MII_Basic;
-
-	union
-		{
-			volatile uint16_t all;
-
-			struct
-			{
-				volatile uint16_t	partner_10BT_Half_D_Capable	:1,						// When this bit is set, it indicates that link partner 10BT half-duplex capable.
-									partner_10BT_Full_D_Capable	:1,						// When this bit is set, it indicates that link partner 10BT full-duplex capable.
-									partner_100BT_Half_D_Capable:1,						// When this bit is set, it indicates that link partner 100BT half-duplex capable.
-									partner_100BT_Full_D_Capable:1,						// When this bit is set, it indicates that link partner 100BT full-duplex capable.
-									partner_Flow_Cont_Capable	:1,						// When this bit is set, it indicates that link partner flow control (pause) capable.
-									link_Is_Good				:1,						// When this bit is set, it indicates that link good.
-									auto_Negotiation_Done		:1,						// When this bit is set, it indicates that auto-negotiation done.
-									MDI_X						:1,						// When this bit is set, it indicates that MDI enable and MDI-X disable
-									Reserved0					:1,
-									operation_Duplex			:1,						// When this bit is set, it indicates that link duplex is full.
-									operation_Speed				:1,						// When this bit is set, it indicates that link speed is 100 Mbps (reset: 10 Mbps)
-									Reserved1					:2,
-									polarity_Is_Reverse			:1,						// When this bit is set, it indicates that  polarity is reversed.
-									Reserved2					:1,
-									HP_Auto_MDI_X				:1;						// When this bit is set, it indicates that HP Auto MDI-X mode enabled (reset: Microchip Auto MDI-X mode.)
-			}Bits;
-
-		}Port1;
+	uint8_t			dst_MAC[KSZ_MAC_ADDRR_LEN];				// destination (or gateway) MAC address
+	uint8_t			src_ipv4[KSZ_IPV4_ADDR_SIZE];			// addresses in network order
+	uint8_t			dst_ipv4[KSZ_IPV4_ADDR_SIZE];
+	uint16_t		src_port;
+	uint16_t		dst_port;
+	uint8_t			ttl;									// 0 uses KSZ_IPV4_DEFAULT_TTL
+	uint8_t			tos;
 
-}KSZ8851_Status_Reg_t;
+}KSZ8851_UDP_Flow_Config_t;
+
+typedef struct
+{
+	uint8_t			header[KSZ_UDP_TEMPLATE_SIZE];			// headers built by ksz8851_udp_flow_register, length, ID and checksums are patched per datagram
+	uint16_t		ip_id;									// IPv4 identification of next datagram
+	bool			used;
 
+}KSZ8851_UDP_Flow_t;
 
 typedef struct
 {
-	volatile KSZ8851_Status_Reg_t Status;
+	uint16_t		low_watermark;							// bytes of free RXQ space, pause frames stop when free space rises above it (FCLWR)
+	uint16_t		high_watermark;							// bytes of free RXQ space, pause frames start when free space falls below it (FCHWR)
+	uint16_t		overrun_watermark;						// bytes of free RXQ space, received frames are dropped below it (FCOWR)
+	uint8_t			backpressure_on_frames;					// RXQ frame count which asserts FLOW_Backpressure
+	uint8_t			backpressure_off_frames;				// RXQ frame count which releases FLOW_Backpressure
 
-}KSZ8851_Registers_t;
+}KSZ8851_Flow_Control_t;
 
 typedef struct
 {
-	volatile KSZ8851_Interface_t 	interface;
-	volatile KSZ8851_Callbacks_t 	functions;
-	volatile MAC_Address_t 			MAC_Address;
-	volatile KSZ8851_Registers_t	Registers;
+	uint32_t rx_frames;														// frames handed over to upper layer
+	uint32_t rx_dropped;													// frames released from RXQ without reading (error status or no buffer)
+	uint32_t rx_crc_errors;													// frames released because of CRC error
+	uint32_t rx_runts;														// frames released because they are shorter than 64 bytes
+	uint32_t rx_too_long;													// frames released because they are longer than 2000 bytes or KSZ_ETH_MAX_FRAME_SIZE
+	uint32_t rx_mii_errors;													// frames released because of MII symbol error
+	uint32_t rx_checksum_errors;											// frames released because of IP/TCP/UDP/ICMP checksum error
+	uint32_t rx_invalid;													// frames released because frame valid bit isn't set or byte count is too small
+	uint32_t rx_no_buffer;													// frames released because upper layer had no buffer
+	uint32_t rx_peek_dropped;												// frames released by RX_PeekFrame after reading their header
+	uint32_t rx_overruns;													// receive overrun interrupts
+	uint32_t rx_fastpath_replies;											// ARP / ICMP echo requests answered by RX fast path
+	uint32_t rx_fastpath_dropped;											// fast path replies dropped since TXQ memory or a tracked frame ID was not free
+	uint32_t tx_frames;														// frames enqueued to TXQ
+	uint32_t tx_busy;														// send requests rejected since TXQ memory was not enough or all tracked frame IDs are in flight
+	uint32_t tx_completed;													// frames reported by TX_FrameDone
+	uint32_t tx_collision_failures;											// frames reported with maximum or late collision status
+	uint32_t rx_bytes;														// bytes read from RXQ fifo, including header and padding
+	uint32_t rx_spi_bursts;													// spi transactions used for RXQ fifo reads
+	uint32_t rx_polls;														// ksz8851_poll calls
+	uint32_t rx_mode_switches;												// switches from interrupt to polling mode
+	uint32_t rx_interrupt_mode_ms;											// time spent in interrupt mode, updated at mode switches
+	uint32_t rx_polling_mode_ms;											// time spent in polling mode, updated at mode switches
+
+}KSZ8851_Statistics_t;
+
+typedef struct
+{
+	uint8_t			*buffer;
+	uint16_t		length;
+	uint32_t		tick;									// TIME_GetTick value at ksz8851_tx_enqueue
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	uint32_t		stamp;									// TIME_Timestamp value at ksz8851_tx_enqueue
+#endif
+
+}KSZ8851_TX_Entry_t;
+
+typedef struct
+{
+	uint8_t			*buffer;
+	uint16_t		length;
+	uint8_t			frame_id;
+
+}KSZ8851_TX_Track_t;
+
+typedef struct
+{
+	KSZ8851_TX_Entry_t	entries[KSZ_TX_CONFIG_QUEUE_DEPTH];
+	uint8_t			head;
+	uint8_t			count;									// current depth
+	uint8_t			high_water;								// maximum depth seen
+	uint32_t		enqueued;								// frames accepted by ksz8851_tx_enqueue
+	uint32_t		sent;									// frames written to TXQ
+	uint32_t		rejected;								// frames rejected since queue was full
+	uint32_t		latency_max_ms;							// longest time from ksz8851_tx_enqueue to TXQ
+	uint32_t		latency_total_ms;						// sum of latencies, average is latency_total_ms / sent
+
+}KSZ8851_TX_Queue_t;
+
+typedef struct
+{
+	uint32_t		buckets[KSZ_HIST_CONFIG_BUCKETS];		// bucket 0 counts 0, bucket n counts 2^(n-1) .. 2^n - 1, last bucket also counts longer values
+	uint32_t		count;
+	uint32_t		max;
+
+}KSZ8851_Histogram_t;
+
+typedef struct
+{
+	KSZ8851_Histogram_t	rx_delivery;						// RX interrupt entry (or ksz8851_poll call) to RX_FrameReceived
+	KSZ8851_Histogram_t	tx_enqueue;							// ksz8851_send_frame / ksz8851_tx_enqueue call to TXQ enqueue
+	KSZ8851_Histogram_t	fifo_transfer;						// RXQ / TXQ fifo transfer duration, from DMA start to DMA stop
+
+}KSZ8851_Latency_t;
+
+struct KSZ8851_Bus;
+
+typedef struct
+{
+	const KSZ8851_Config_t			*config;				// configuration (can be const in flash), it must stay valid while driver is used
+	KSZ8851_Registers_t				Registers;
+	KSZ8851_Statistics_t			Statistics;
+	KSZ8851_Flow_Control_t			flow_control;
+	bool							backpressure;			// FLOW_Backpressure is asserted
+	bool							rx_polling;				// RX interrupt is masked, RXQ is drained by ksz8851_poll
+	bool							rx_poll_enabled;		// somebody calls ksz8851_poll (POLL_Schedule is set or ksz8851_enable_polling), otherwise RX is always serviced in ksz8851_irq_handler
+	uint8_t							rx_burst_length;		// bytes per RXQ fifo read transaction, 0 is whole frame
+	uint32_t						rx_mode_tick;			// tick of last RX mode switch
+	uint8_t							tx_frame_id;			// frame ID of next transmitted frame
+	KSZ8851_TX_Queue_t				tx_queues[KSZ_TX_CONFIG_PRIORITIES];	// strict priority software queues in front of TXQ
+	bool							tx_space_wait;			// TXQ memory available monitor is armed
+	KSZ8851_TX_Track_t				tx_track[KSZ_TX_CONFIG_TRACK_DEPTH];	// frames in TXQ in send order, used only with TX_FrameDone
+	uint8_t							tx_track_head;
+	uint8_t							tx_track_count;
+	KSZ8851_UDP_Flow_t				udp_flows[KSZ_UDP_CONFIG_MAX_FLOWS];	// header templates of ksz8851_udp_send
+	volatile uint32_t				irq_timestamp;			// TIME_Timestamp value taken by ksz8851_irq_timestamp in INTRN isr
+	volatile bool					irq_timestamp_valid;	// irq_timestamp isn't used by ksz8851_irq_handler yet
+	uint32_t						rx_timestamp;			// timestamp of frames which are handed over now
+#ifdef KSZ_HIST_CONFIG_LATENCY
+	KSZ8851_Latency_t				Latency;				// histograms in TIME_Timestamp units, recorded only if TIME_Timestamp is set
+	uint32_t						fifo_stamp;				// TIME_Timestamp value at RX DMA start
+#endif
+	struct KSZ8851_Bus				*bus;					// shared spi bus arbiter, NULL if the chip has its own spi bus. Set by ksz8851_bus_attach
+	uint8_t							bus_slot;				// index of the instance on the shared bus
 
 }KSZ8851_t;
 
@@ -664,9 +991,32 @@ typedef struct
 /* Checks register address whether odd or even and if it's even selects byte 0-1 */
 #define KSZ_MAKE_FRAME_REG_BYTES(frame_buff, reg_addr)		((reg_addr & KSZ_REG_ADDR_EVEN_CHECK_VALUE) != 0) ? (frame_buff |= (uint16_t)(KSZ_REG_BYTES_SELECT_2_3_MASK_VALUE << KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE)) : \
 																													(frame_buff |= (uint16_t)(KSZ_REG_BYTES_SELECT_0_1_MASK_VALUE << KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE))
+/* Builds whole 16 bit register command frame (cmd, byte enable and address bits). It is a constant expression when cmd and reg_addr are constant
+ * so command bytes of a register access with known address are computed at compile time, also usable in C++ constexpr context (ref: KSZ datasheet section 3.5.2) */
+#define KSZ_REG_FRAME(cmd, reg_addr)						(uint16_t)(((uint16_t)(cmd) << KSZ_REG_CMD_SHIFT_VALUE) | \
+															(((((reg_addr) & KSZ_REG_ADDR_EVEN_CHECK_VALUE) != 0) ? KSZ_REG_BYTES_SELECT_2_3_MASK_VALUE : KSZ_REG_BYTES_SELECT_0_1_MASK_VALUE) << KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE) | \
+															(((uint16_t)(reg_addr) << KSZ_REG_ADDR_BIT_SHIFT_VALUE) & KSZ_REG_ADDR_MASK_VALUE))
+
+/* First (MSB) and second (LSB) byte of register command frame in the SPI transfer order */
+#define KSZ_REG_FRAME_BYTE0(cmd, reg_addr)					(uint8_t)((KSZ_REG_FRAME(cmd, reg_addr) & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE)
+#define KSZ_REG_FRAME_BYTE1(cmd, reg_addr)					(uint8_t)(KSZ_REG_FRAME(cmd, reg_addr) & KSZ_REG_CMD_BYTE1_MASK)
+
+/* Register pair (32 bit) command frame with all byte enable bits set. reg_addr must be dword aligned, lower word is the register on reg_addr and
+ * upper word is the register on reg_addr + 2 */
+#define KSZ_REG32_FRAME(cmd, reg_addr)						(uint16_t)(((uint16_t)(cmd) << KSZ_REG_CMD_SHIFT_VALUE) | \
+															(KSZ_REG_BYTES_SELECT_ALL_MASK_VALUE << KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE) | \
+															(((uint16_t)((reg_addr) & KSZ_REG_DWORD_ADDR_MASK_VALUE) << KSZ_REG_ADDR_BIT_SHIFT_VALUE) & KSZ_REG_ADDR_MASK_VALUE))
+
 /* Byte swapping for uint16_t */
+#define KSZ_MAKE_U16(msb, lsb)									(uint16_t)(((uint16_t)(msb) << KSZ_1BYTE_SHIFTING_VALUE) | (lsb))
 #define KSZ_BYTE_SWAP_U16(value)								(uint16_t) ((value >> KSZ_1BYTE_SHIFTING_VALUE) | (value << KSZ_1BYTE_SHIFTING_VALUE))
 
+/* Compile time check, it fails to compile with negative array size when cond is false */
+#define KSZ_STATIC_ASSERT(cond, name)						typedef char ksz_static_assert_##name[(cond) ? 1 : -1]
+
+/* Index of register in descriptor table */
+#define KSZ_REG_DESCRIPTOR_INDEX(reg_addr)					((uint8_t)(reg_addr) >> 1)
+
 /* Time comparison, getting time difference and getting present time  */
 #define TIMER_DIFF(a,b)     	((((int32_t)a)-((int32_t)b)))
 #define TIMER_COMP(a,b)			(TIMER_DIFF((a),(b)) < 0)
@@ -677,39 +1027,207 @@ typedef struct
 /* Variables -----------------------------------------------------------------*/
 
 
+/* Inline functions ----------------------------------------------------------*/
+
+/**
+* @brief  Puts register command frame bytes to the head of spi buffer. When registerAddr is known at compile time, this is reduced
+* 		  to two stores of constant bytes.
+* @param  cmdBuff: spi tx buffer, at least 2 bytes.
+* @param  cmd: KSZ8851_READ_REG or KSZ8851_WRITE_REG.
+* @param  registerAddr: address of internal register.
+*/
+static inline void ksz8851_make_reg_cmd(uint8_t *cmdBuff, KSZ8851_Cmd cmd, KSZ8851_Registers_Addr_t registerAddr)
+{
+	cmdBuff[KSZ_REG_BUFF_BYTE0] = KSZ_REG_FRAME_BYTE0(cmd, registerAddr);
+	cmdBuff[KSZ_REG_BUFF_BYTE1] = KSZ_REG_FRAME_BYTE1(cmd, registerAddr);
+}
+
+/**
+* @brief  Puts register pair (32 bit) command frame bytes to the head of spi buffer.
+* @param  cmdBuff: spi tx buffer, at least 2 bytes.
+* @param  cmd: KSZ8851_READ_REG or KSZ8851_WRITE_REG.
+* @param  registerAddr: dword aligned address of lower register of the pair.
+*/
+static inline void ksz8851_make_reg32_cmd(uint8_t *cmdBuff, KSZ8851_Cmd cmd, KSZ8851_Registers_Addr_t registerAddr)
+{
+	cmdBuff[KSZ_REG_BUFF_BYTE0] = (uint8_t)((KSZ_REG32_FRAME(cmd, registerAddr) & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE);
+	cmdBuff[KSZ_REG_BUFF_BYTE1] = (uint8_t)(KSZ_REG32_FRAME(cmd, registerAddr) & KSZ_REG_CMD_BYTE1_MASK);
+}
+
 /* Private functions ---------------------------------------------------------*/
 //KSZ8851_Status_t ksz8851_read_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t *registerValue);
 //KSZ8851_Status_t ksz8851_write_register(KSZ8851_t *driver, KSZ8851_Registers_Addr_t registerAddr, uint16_t registerValue);
 
 /* Public functions ----------------------------------------------------------*/
 
-#if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
 /**
 * @brief  Initialize the parameters for KSZ8851 driver. This function must be called after initialization of mcu's peripherals.
-* @param  driver: address of KSZ8851_Driver_Init_t struct that defined by user.
-* @param  cs_port: chip select (slave select) port.
-* @param  cs_pin: chip select (slave select) pin number.
-* @param  rst_port: KSZ8851 hardware reset control port.
-* @param  rst_pin: KSZ8851 hardware reset control pin.
-* @param  MAC_address: Ethernet MAC address of the device.
-* @param  callbacks: the calbback funtions defined by user in MCU layer to send data over spi and to control mcu gpio 's (chip select and hardware reset)
+* @param  driver: address of KSZ8851_t struct that defined by user, it holds only runtime state.
+* @param  config: callbacks, pins, MAC address and init profile. It isn't copied, so it can be a const object in flash.
 * @retval status of init process
 */
-KSZ8851_Status_t ksz8851_init(KSZ8851_t *driver, uint32_t cs_port, uint16_t cs_pin,
-		uint32_t rst_port, uint16_t rst_pin, uint8_t *MAC_address, KSZ8851_Callbacks_t callbacks);
-#else
+KSZ8851_Status_t ksz8851_init(KSZ8851_t *driver, const KSZ8851_Config_t *config);
+
 /**
-* @brief  Initialize the parameters for KSZ8851 driver. This function must be called after initialization of mcu's peripherals.
-* @param  driver: address of KSZ8851_Driver_Init_t struct that defined by user.
-* @param  rst_port: KSZ8851 hardware reset control port.
-* @param  rst_pin: KSZ8851 hardware reset control pin.
-* @param  MAC_address: Ethernet MAC address of the device.
-* @param  callbacks: the calbback funtions defined by user in MCU layer to send data over spi and to control mcu gpio 's (chip select and hardware reset)
-* @retval status of init process
+* @brief  Writes a frame to TXQ and enqueues it for transmission. CRC and padding are added by the chip.
+* @param  driver: address of KSZ8851_t struct.
+* @param  txBuffer: ethernet frame starting from destination MAC address.
+* @param  frame_length: frame length without CRC, KSZ_ETH_MIN_FRAME_SIZE .. KSZ_ETH_MAX_FRAME_SIZE.
+* @retval KSZ_OK, KSZ_BUSY if TXQ memory is not enough, KSZ_ERROR
+*/
+KSZ8851_Status_t ksz8851_send_frame(KSZ8851_t *driver, uint8_t *txBuffer, uint16_t frame_length);
+
+/**
+* @brief  Reads present frame from RXQ. Frames with error status are released without reading.
+* @param  driver: address of KSZ8851_t struct.
+* @param  rxBuffer: at least KSZ_RX_BUFFER_SIZE(KSZ_ETH_MAX_FRAME_SIZE) bytes.
+* @param  frame_length: length of received frame without CRC, 0 if frame is dropped.
+* @retval status of process
+*/
+KSZ8851_Status_t ksz8851_receive_frame(KSZ8851_t *driver, uint8_t *rxBuffer, uint16_t *frame_length);
+
+/**
+* @brief  Returns number of frames waiting in RXQ.
+*/
+uint8_t ksz8851_get_rx_frame_count(KSZ8851_t *driver);
+
+/**
+* @brief  Programs a wake-up frame pattern into a free filter slot (WF0 .. WF3). Byte masks and CRC of the selected
+* 		  bytes are computed by driver. Matching frames set KSZ_FLAGS_INTERRUPTS_RX_WAKEUP_FRAME.
+* @param  driver: address of KSZ8851_t struct.
+* @param  pattern: pattern description.
+* @param  filter_no: used filter slot, can be NULL.
+* @retval KSZ_OK, KSZ_BUSY if all filters are used, KSZ_ERROR if pattern doesn't fit filter window
+*/
+KSZ8851_Status_t ksz8851_wakeup_set_filter(KSZ8851_t *driver, const KSZ8851_WakeUp_Pattern_t *pattern, uint8_t *filter_no);
+
+/**
+* @brief  Disables a wake-up frame filter slot, so it can be used again.
+*/
+KSZ8851_Status_t ksz8851_wakeup_clear_filter(KSZ8851_t *driver, uint8_t filter_no);
+
+/**
+* @brief  Enables or disables magic packet detection.
+*/
+KSZ8851_Status_t ksz8851_wakeup_set_magic_packet(KSZ8851_t *driver, bool enable);
+
+/**
+* @brief  Derives flow control watermarks from host RX drain rate. RXQ fills with the difference of line rate and drain rate
+* 		  while host is late (KSZ_FLOW_CONFIG_SERVICE_LATENCY_US), pause frames must start before that headroom is used.
+* @param  flow: watermarks, filled by function.
+* @param  drain_rate_kBps: rate which host reads RXQ in kbytes/s.
+*/
+void ksz8851_flow_control_defaults(KSZ8851_Flow_Control_t *flow, uint32_t drain_rate_kBps);
+
+/**
+* @brief  Writes flow control watermarks to FCLWR, FCHWR and FCOWR and sets backpressure marks.
+* @retval KSZ_OK, KSZ_ERROR if watermarks aren't ordered (overrun < high < low < RXQ size)
+*/
+KSZ8851_Status_t ksz8851_set_flow_control(KSZ8851_t *driver, const KSZ8851_Flow_Control_t *flow);
+
+/**
+* @brief  Selects SPI RX data burst length. Fifo reads are split into transactions of that size.
+* @param  driver: address of KSZ8851_t struct.
+* @param  burst: KSZ_CONFIG_RX_CTRL2_DATA_BURST_4BYTES/8BYTES/16BYTES/32BYTES or KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN
+* @retval KSZ_OK, KSZ_ERROR for unknown burst value
 */
-KSZ8851_Status_t ksz8851_init(KSZ8851_t *driver, uint32_t rst_port, uint16_t rst_pin, uint8_t *MAC_address, KSZ8851_Callbacks_t callbacks);
+KSZ8851_Status_t ksz8851_set_rx_burst(KSZ8851_t *driver, uint16_t burst);
+
+/**
+* @brief  Drains up to budget frames from RXQ in polling mode. When RXQ is empty, RX interrupt is enabled again and
+* 		  driver returns to interrupt mode. Must be called under the same serialization as ksz8851_irq_handler.
+* @param  driver: address of KSZ8851_t struct.
+* @param  budget: maximum number of frames handed over in this call.
+* @param  processed: number of frames taken from RXQ, can be NULL.
+* @retval status of process
+*/
+KSZ8851_Status_t ksz8851_poll(KSZ8851_t *driver, uint8_t budget, uint8_t *processed);
+
+/**
+* @brief  Returns true while RX is in polling mode.
+*/
+bool ksz8851_is_polling(KSZ8851_t *driver);
+
+/**
+* @brief  Allows polling mode without POLL_Schedule callback, for callers which check ksz8851_is_polling and call ksz8851_poll
+* 		  by themselves (e.g. ksz8851_service). Without it and POLL_Schedule, ksz8851_irq_handler never enters polling mode.
+* @param  driver: address of KSZ8851_t struct.
+*/
+void ksz8851_enable_polling(KSZ8851_t *driver);
+
+/**
+* @brief  Puts a frame into a strict priority TX queue and writes queued frames to TXQ while it has room. A frame is sent
+* 		  only when all higher priority queues are empty, so control and real-time frames pass bulk frames waiting in
+* 		  software. Buffer must stay valid until TX_BufferReleased callback. Must be called under the same serialization
+* 		  as ksz8851_irq_handler, which continues sending when TXQ memory becomes available.
+* @param  driver: address of KSZ8851_t struct.
+* @param  priority: 0 (highest) .. KSZ_TX_CONFIG_PRIORITIES - 1
+* @param  txBuffer: ethernet frame starting from destination MAC address.
+* @param  frame_length: frame length without CRC, KSZ_ETH_MIN_FRAME_SIZE .. KSZ_ETH_MAX_FRAME_SIZE.
+* @retval KSZ_OK, KSZ_BUSY if the queue is full, KSZ_ERROR for invalid priority or frame length
+*/
+KSZ8851_Status_t ksz8851_tx_enqueue(KSZ8851_t *driver, uint8_t priority, uint8_t *txBuffer, uint16_t frame_length);
+
+/**
+* @brief  Builds Ethernet / IPv4 / UDP headers of a flow once, so datagrams of it are sent by ksz8851_udp_send.
+* @param  driver: address of KSZ8851_t struct.
+* @param  flow: addresses and ports of the flow, source MAC is KSZ8851_Config_t.MAC_address.
+* @param  handle: flow handle, filled by function.
+* @retval KSZ_OK, KSZ_BUSY if all KSZ_UDP_CONFIG_MAX_FLOWS flows are used
+*/
+KSZ8851_Status_t ksz8851_udp_flow_register(KSZ8851_t *driver, const KSZ8851_UDP_Flow_Config_t *flow, uint8_t *handle);
+
+/**
+* @brief  Frees a flow handle.
+* @param  driver: address of KSZ8851_t struct.
+* @param  handle: handle from ksz8851_udp_flow_register.
+* @retval KSZ_OK, KSZ_ERROR for invalid handle
+*/
+KSZ8851_Status_t ksz8851_udp_flow_unregister(KSZ8851_t *driver, uint8_t handle);
+
+/**
+* @brief  Sends a UDP datagram on a registered flow. Length and ID fields of the template are patched, checksums are generated
+* 		  by TXQ (KSZ_CONFIG_TX_CTRL_IP_CHECKSUM / UDP_CHECKSUM set by ksz8851_init), and headers and payload are written in
+* 		  one fifo transfer. Payload is copied to TXQ before return.
+* @param  driver: address of KSZ8851_t struct.
+* @param  handle: handle from ksz8851_udp_flow_register.
+* @param  payload: UDP payload.
+* @param  payload_length: 0 .. KSZ_UDP_MAX_PAYLOAD.
+* @retval KSZ_OK, KSZ_BUSY if TXQ memory is not enough, KSZ_ERROR for invalid handle or length
+*/
+KSZ8851_Status_t ksz8851_udp_send(KSZ8851_t *driver, uint8_t handle, uint8_t *payload, uint16_t payload_length);
+
+#ifdef KSZ_HIST_CONFIG_LATENCY
+/**
+* @brief  Copies latency histograms. Must be called under the same serialization as ksz8851_irq_handler.
+* @param  driver: address of KSZ8851_t struct.
+* @param  snapshot: histograms, filled by function.
+* @param  reset: clears histograms after copying, so next snapshot covers a new interval.
+*/
+void ksz8851_latency_snapshot(KSZ8851_t *driver, KSZ8851_Latency_t *snapshot, bool reset);
+
+/**
+* @brief  Returns upper bound of the bucket that holds given percentile of recorded values, e.g. 99 for tail latency.
+* @retval latency in TIME_Timestamp units, 0 if histogram is empty
+*/
+uint32_t ksz8851_histogram_percentile(const KSZ8851_Histogram_t *histogram, uint8_t percent);
 #endif
 
+/**
+* @brief  Takes RX timestamp at interrupt entry. It can be called from INTRN falling edge interrupt, it doesn't touch spi.
+* 		  Without it, ksz8851_irq_handler takes the timestamp when it starts.
+* @param  driver: address of KSZ8851_t struct.
+*/
+void ksz8851_irq_timestamp(KSZ8851_t *driver);
+
+/**
+* @brief  Services KSZ8851 interrupt. Must be called from thread context (main loop or driver task) after INTRN pin goes low,
+* 		  since it performs spi transactions. Received frames are handed over by RX_GetBuffer / RX_FrameReceived callbacks.
+* @param  driver: address of KSZ8851_t struct.
+* @retval status of process
+*/
+KSZ8851_Status_t ksz8851_irq_handler(KSZ8851_t *driver);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,308 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851.hpp
+ * @description : 	Header only C++ interface of KSZ8851SNL driver. SPI, GPIO and tick access are resolved at
+ * 					compile time through policy classes so they can be inlined into register and fifo paths. Register,
+ * 					fifo and reset sequences are the routines of ksz8851_transport.h that C driver runs, Device adds no
+ * 					transport of its own. Frame send/receive, interrupts, bus arbiter and statistics are only in C driver.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_HPP
+#define __KSZ8851_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+#include "ksz8851_transport.h"
+
+namespace ksz8851
+{
+
+/* Constexpr helpers ---------------------------------------------------------*/
+
+/**
+* @brief  Register command frame (cmd, byte enable and address bits) of a 16 bit register access.
+*/
+constexpr uint16_t reg_frame(KSZ8851_Cmd cmd, KSZ8851_Registers_Addr_t registerAddr)
+{
+	return KSZ_REG_FRAME(cmd, registerAddr);
+}
+
+/**
+* @brief  Register command frame of a dword aligned register pair (32 bit) access.
+*/
+constexpr uint16_t reg32_frame(KSZ8851_Cmd cmd, KSZ8851_Registers_Addr_t registerAddr)
+{
+	return KSZ_REG32_FRAME(cmd, registerAddr);
+}
+
+/* Policies ------------------------------------------------------------------*/
+
+/*
+ * Policy requirements, functions may be static or non-static members:
+ *
+ * SpiPolicy:   KSZ8851_Status_t transmit(uint8_t *pTxBuffer, uint16_t dataLength)
+ *              KSZ8851_Status_t receive(uint8_t *pRxBuffer, uint16_t dataLength)
+ *              KSZ8851_Status_t transmitReceive(uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
+ * GpioPolicy:  void write(uint32_t port, uint16_t pin, uint8_t pinStatus)
+ * ClockPolicy: uint32_t tick()				(milliseconds)
+ */
+
+/**
+* @brief  Policies that forward to SPI, GPIO and tick callbacks of C API (KSZ8851_Callbacks_t), so a port written for the
+* 		  C driver can be reused. Policies share one callbacks pointer, bind it once with device.spi().bind(&callbacks)
+* 		  before reset().
+*/
+class CallbackPolicy
+{
+public:
+	void bind(const KSZ8851_Callbacks_t *callbacks) { callbacks_ = callbacks; }
+
+protected:
+	const KSZ8851_Callbacks_t *callbacks_ = nullptr;
+};
+
+class CallbackSpi : public virtual CallbackPolicy
+{
+public:
+	KSZ8851_Status_t transmit(uint8_t *pTxBuffer, uint16_t dataLength) { return callbacks_->SPI_TransmitData(callbacks_->user, pTxBuffer, dataLength); }
+	KSZ8851_Status_t receive(uint8_t *pRxBuffer, uint16_t dataLength) { return callbacks_->SPI_ReceiveData(callbacks_->user, pRxBuffer, dataLength); }
+	KSZ8851_Status_t transmitReceive(uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength) { return callbacks_->SPI_TransmitReceiveData(callbacks_->user, pTxBuffer, pRxBuffer, dataLength); }
+};
+
+class CallbackGpio : public virtual CallbackPolicy
+{
+public:
+	void write(uint32_t port, uint16_t pin, uint8_t pinStatus) { callbacks_->GPIO_Control(callbacks_->user, port, pin, pinStatus); }
+};
+
+class CallbackClock : public virtual CallbackPolicy
+{
+public:
+	uint32_t tick() { return callbacks_->TIME_GetTick(callbacks_->user); }
+};
+
+/* Device --------------------------------------------------------------------*/
+
+/**
+* @brief  Register, fifo and reset access of one chip. Every access runs the same routine as C driver (ksz8851_transport.h) on a
+* 		  constant transport table of the policies, so policy calls are resolved at compile time. Chained transfers aren't
+* 		  part of policies, fifo reads use separate transfers inside one chip select period.
+*/
+template <class SpiPolicy, class GpioPolicy, class ClockPolicy>
+class Device : private SpiPolicy, private GpioPolicy, private ClockPolicy
+{
+public:
+	/**
+	* @brief  Keeps gpio parameters of the device, chip is not accessed until reset().
+	* @param  cs_port: chip select (slave select) port, unused if KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER is defined.
+	* @param  cs_pin: chip select (slave select) pin number.
+	* @param  rst_port: KSZ8851 hardware reset control port.
+	* @param  rst_pin: KSZ8851 hardware reset control pin.
+	*/
+	Device(uint32_t cs_port, uint16_t cs_pin, uint32_t rst_port, uint16_t rst_pin)
+		: cs_port_(cs_port), rst_port_(rst_port), cs_pin_(cs_pin), rst_pin_(rst_pin)
+	{
+	}
+
+	SpiPolicy &spi() { return *this; }
+	GpioPolicy &gpio() { return *this; }
+	ClockPolicy &clock() { return *this; }
+
+	/**
+	* @brief  Performs hard reset, waits chip ID and performs global soft reset, same as first steps of ksz8851_init. It doesn't
+	* 		  configure MAC address, QMU or interrupts, that is ksz8851_init's job.
+	* @return KSZ_OK or KSZ_INIT_ERROR
+	*/
+	KSZ8851_Status_t reset()
+	{
+		uint16_t deviceID = 0;
+		uint32_t waited = 0;
+
+		ksz8851_transport_hard_reset(&transport_, this);
+
+		/* Chip ID is read once per ms until it is readable or KSZ_TIME_HARD_RESET_TIMEOUT_US passes */
+		while(readRegister(KSZ_REG_ADDR_CIDER0, deviceID) != KSZ_OK || (deviceID & KSZ_CHIP_ID_MASK) != KSZ_CHIP_ID)
+		{
+			if(waited >= KSZ_TIME_HARD_RESET_TIMEOUT_US)
+			{
+				return KSZ_INIT_ERROR;
+			}
+
+			delayUs(KSZ_TIME_US_PER_MS);
+			waited += KSZ_TIME_US_PER_MS;
+		}
+
+		return softReset(KSZ_CONFIG_GLOBAL_SOFT_RESET);
+	}
+
+	/**
+	* @brief  Reads internal I/O register. Command bytes are constants when registerAddr is constant.
+	*/
+	KSZ8851_Status_t readRegister(KSZ8851_Registers_Addr_t registerAddr, uint16_t &registerValue)
+	{
+		return ksz8851_transport_read_register(&transport_, this, registerAddr, &registerValue);
+	}
+
+	/**
+	* @brief  Writes internal I/O register. Value is written as it is, reserved bits are kept by the caller.
+	*/
+	KSZ8851_Status_t writeRegister(KSZ8851_Registers_Addr_t registerAddr, uint16_t registerValue)
+	{
+		return ksz8851_transport_write_register(&transport_, this, registerAddr, registerValue);
+	}
+
+	/**
+	* @brief  Reads dword aligned register pair in one transaction. Bit 15-0 is registerAddr, bit 31-16 is registerAddr + 2.
+	*/
+	KSZ8851_Status_t readRegister32(KSZ8851_Registers_Addr_t registerAddr, uint32_t &registerValue)
+	{
+		return ksz8851_transport_read_register32(&transport_, this, registerAddr, &registerValue);
+	}
+
+	/**
+	* @brief  Writes dword aligned register pair in one transaction.
+	*/
+	KSZ8851_Status_t writeRegister32(KSZ8851_Registers_Addr_t registerAddr, uint32_t registerValue)
+	{
+		return ksz8851_transport_write_register32(&transport_, this, registerAddr, registerValue);
+	}
+
+	/**
+	* @brief  Reads present frame from RXQ in one transaction, frame_length is receive byte count (RXFHBCR). rxBuffer needs
+	* 		  KSZ_RX_BUFFER_SIZE(frame_length - KSZ_ETH_CRC_SIZE) bytes since fifo reads are dword aligned (datasheet section 3.5.6).
+	*/
+	KSZ8851_Status_t readFifo(uint8_t *rxBuffer, uint16_t frame_length)
+	{
+		uint8_t  preamble[KSZ_RX_FIFO_PREAMBLE_SIZE];
+		KSZ8851_Status_t result;
+
+		result = ksz8851_transport_rx_dma_start(&transport_, this);
+		result |= ksz8851_transport_read_fifo_stream(&transport_, this, 0, preamble, rxBuffer, 0,
+				(uint16_t)(KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(frame_length - KSZ_ETH_CRC_SIZE)), nullptr);
+		result |= ksz8851_transport_dma(&transport_, this, false);
+
+		return result;
+	}
+
+	/**
+	* @brief  Performs KSZ8851 hardware reset over reset pin, chip ID isn't readable until recovery time passes.
+	*/
+	void hardReset()
+	{
+		ksz8851_transport_hard_reset(&transport_, this);
+	}
+
+	/**
+	* @brief  Performs KSZ8851 software reset, soft_reset_type is KSZ_CONFIG_GLOBAL_SOFT_RESET or KSZ_CONFIG_QMU_MODULE_SOFT_RESET.
+	*/
+	KSZ8851_Status_t softReset(uint16_t soft_reset_type)
+	{
+		return ksz8851_transport_soft_reset(&transport_, this, soft_reset_type);
+	}
+
+	/**
+	* @brief  Waits at least delay_time us with ms resolution of ClockPolicy.
+	*/
+	void delayUs(uint32_t delay_time)
+	{
+		uint32_t delayMs = (delay_time + KSZ_TIME_US_PER_MS - 1) / KSZ_TIME_US_PER_MS;
+		uint32_t tickStart = ClockPolicy::tick();
+
+		/* One more tick, first tick can come right after tickStart */
+		while(ClockPolicy::tick() - tickStart <= delayMs);
+	}
+
+private:
+	/* Transport table entries, context is the device */
+	static KSZ8851_Status_t transmit(void *context, uint8_t *pTxBuffer, uint16_t dataLength)
+	{
+		return static_cast<Device*>(context)->SpiPolicy::transmit(pTxBuffer, dataLength);
+	}
+
+	static KSZ8851_Status_t receive(void *context, uint8_t *pRxBuffer, uint16_t dataLength)
+	{
+		return static_cast<Device*>(context)->SpiPolicy::receive(pRxBuffer, dataLength);
+	}
+
+	static KSZ8851_Status_t transmitReceive(void *context, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
+	{
+		return static_cast<Device*>(context)->SpiPolicy::transmitReceive(pTxBuffer, pRxBuffer, dataLength);
+	}
+
+	static void select(void *context)
+	{
+#if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
+		Device *device = static_cast<Device*>(context);
+
+		device->GpioPolicy::write(device->cs_port_, device->cs_pin_, KSZ_GPIO_PIN_RESET);
+#else
+		(void)context;
+#endif
+	}
+
+	static void deselect(void *context)
+	{
+#if !defined(KSZ_SPI_CONFIG_CS_CONTROLING_BY_USER) && !defined(KSZ_SPI_CONFIG_USE_SPI_IN_NON_BLOCKING_MODE)
+		Device *device = static_cast<Device*>(context);
+
+		/* Blocking transfers are complete when spi policy returns, so chip select is released without waiting a tick */
+		device->GpioPolicy::write(device->cs_port_, device->cs_pin_, KSZ_GPIO_PIN_SET);
+#else
+		(void)context;
+#endif
+	}
+
+	static void resetPin(void *context, uint8_t pinStatus)
+	{
+		Device *device = static_cast<Device*>(context);
+
+		device->GpioPolicy::write(device->rst_port_, device->rst_pin_, pinStatus);
+	}
+
+	static void wait(void *context, uint32_t delay_time)
+	{
+		static_cast<Device*>(context)->delayUs(delay_time);
+	}
+
+	static const KSZ8851_Transport_t transport_;
+
+	uint32_t cs_port_;
+	uint32_t rst_port_;
+	uint16_t cs_pin_;
+	uint16_t rst_pin_;
+};
+
+template <class SpiPolicy, class GpioPolicy, class ClockPolicy>
+const KSZ8851_Transport_t Device<SpiPolicy, GpioPolicy, ClockPolicy>::transport_ =
+{
+	&Device::transmit,
+	&Device::receive,
+	&Device::transmitReceive,
+	nullptr,
+	nullptr,
+	&Device::select,
+	&Device::deselect,
+	&Device::resetPin,
+	&Device::wait,
+};
+
+/* Device on callbacks of C API. It runs the register, fifo and reset routines of C driver on the same callbacks, so a port
+ * written for ksz8851.c works unchanged; frame path, irq handling and bus arbiter stay with ksz8851.c */
+typedef Device<CallbackSpi, CallbackGpio, CallbackClock> CallbackDevice;
+
+} /* namespace ksz8851 */
+
+#endif /* __KSZ8851_HPP */
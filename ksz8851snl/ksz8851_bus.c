@@ -0,0 +1,189 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_bus.c
+ * @description : 	This file provides spi bus arbiter to share one spi bus between several KSZ8851SNL instances.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ksz8851_bus.h"
+
+/* Variables -----------------------------------------------------------------*/
+
+/* pending bit mask is 8 bits wide */
+KSZ_STATIC_ASSERT(KSZ_BUS_CONFIG_MAX_INSTANCES <= 8, bus_max_instances);
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static uint8_t ksz8851_bus_select_next(KSZ8851_Bus_t *bus);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize spi bus arbiter.
+* @param  bus: address of KSZ8851_Bus_t struct that defined by user.
+* @param  callbacks: lock/unlock/yield callbacks.
+*/
+void ksz8851_bus_init(KSZ8851_Bus_t *bus, KSZ8851_Bus_Callbacks_t callbacks)
+{
+	memset(bus, 0, sizeof(KSZ8851_Bus_t));
+
+	bus->functions	= callbacks;
+	bus->owner		= KSZ_BUS_OWNER_NONE;
+}
+
+/**
+* @brief  Attaches a KSZ8851 instance to shared spi bus. Must be called before ksz8851_init of the instance.
+* @param  bus: address of KSZ8851_Bus_t struct.
+* @param  driver: address of KSZ8851_t struct.
+* @param  priority: KSZ_BUS_PRIORITY_LOWEST .. KSZ_BUS_PRIORITY_HIGHEST
+* @retval KSZ_OK, or KSZ_ERROR if all slots are used or Lock / Unlock callback is missing
+*/
+KSZ8851_Status_t ksz8851_bus_attach(KSZ8851_Bus_t *bus, KSZ8851_t *driver, uint8_t priority)
+{
+	if(bus->count >= KSZ_BUS_CONFIG_MAX_INSTANCES || bus->functions.Lock == NULL || bus->functions.Unlock == NULL)
+	{
+		return KSZ_ERROR;
+	}
+
+	if(priority > KSZ_BUS_PRIORITY_HIGHEST)
+	{
+		priority = KSZ_BUS_PRIORITY_HIGHEST;
+	}
+
+	bus->functions.Lock(bus->functions.user);
+
+	driver->bus						= bus;
+	driver->bus_slot				= bus->count;
+	bus->priority[bus->count]		= priority;
+	bus->count++;
+
+	bus->functions.Unlock(bus->functions.user);
+
+	return KSZ_OK;
+}
+
+/**
+* @brief  Waits until bus is granted to the slot. It's called by driver before each spi transaction.
+* @param  bus: address of KSZ8851_Bus_t struct.
+* @param  slot: bus slot of the instance.
+*/
+void ksz8851_bus_acquire(KSZ8851_Bus_t *bus, uint8_t slot)
+{
+	bus->functions.Lock(bus->functions.user);
+
+	/* Idle bus is taken immediately, otherwise slot waits in pending mask until releasing slot grants it */
+	if(bus->owner == KSZ_BUS_OWNER_NONE)
+	{
+		bus->owner = slot;
+		bus->last_granted = slot;
+		bus->grants[slot]++;
+
+		bus->functions.Unlock(bus->functions.user);
+		return;
+	}
+
+	bus->pending |= (uint8_t)(1 << slot);
+	bus->waits[slot]++;
+
+	bus->functions.Unlock(bus->functions.user);
+
+	while(bus->owner != slot)
+	{
+		if(bus->functions.Yield != NULL)
+		{
+			bus->functions.Yield(bus->functions.user);
+		}
+	}
+}
+
+/**
+* @brief  Releases bus and grants it directly to next waiting slot, so bus doesn't stay idle between transactions.
+* @param  bus: address of KSZ8851_Bus_t struct.
+* @param  slot: bus slot of the instance.
+*/
+void ksz8851_bus_release(KSZ8851_Bus_t *bus, uint8_t slot)
+{
+	uint8_t next;
+
+	bus->functions.Lock(bus->functions.user);
+
+	if(bus->owner == slot)
+	{
+		next = ksz8851_bus_select_next(bus);
+
+		if(next != KSZ_BUS_OWNER_NONE)
+		{
+			bus->pending &= (uint8_t)~(1 << next);
+			bus->last_granted = next;
+			bus->grants[next]++;
+		}
+
+		bus->owner = next;
+	}
+
+	bus->functions.Unlock(bus->functions.user);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Selects waiting slot that has highest priority plus age. Same levels are served round robin starting after last granted slot.
+ * 		   Every slot that is skipped gets one level older, granted slot gets back to its base priority.
+ * @param  bus
+ * @return selected slot or KSZ_BUS_OWNER_NONE if no slot is waiting
+ */
+static uint8_t ksz8851_bus_select_next(KSZ8851_Bus_t *bus)
+{
+	uint8_t i, slot, level;
+	uint8_t selected = KSZ_BUS_OWNER_NONE, selectedLevel = 0;
+
+	if(bus->pending == 0)
+	{
+		return KSZ_BUS_OWNER_NONE;
+	}
+
+	for(i = 1; i <= bus->count; i++)
+	{
+		slot = (uint8_t)((bus->last_granted + i) % bus->count);
+
+		if((bus->pending & (1 << slot)) == 0)
+		{
+			continue;
+		}
+
+		level = bus->priority[slot] + bus->age[slot];
+
+		if(selected == KSZ_BUS_OWNER_NONE || level > selectedLevel)
+		{
+			selected = slot;
+			selectedLevel = level;
+		}
+	}
+
+	for(slot = 0; slot < bus->count; slot++)
+	{
+		if(slot == selected)
+		{
+			bus->age[slot] = 0;
+		}
+		else if((bus->pending & (1 << slot)) != 0 && bus->age[slot] < KSZ_BUS_CONFIG_AGING_LIMIT)
+		{
+			bus->age[slot]++;
+		}
+	}
+
+	return selected;
+}
@@ -0,0 +1,97 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_bus.h
+ * @description : 	This file provides spi bus arbiter to share one spi bus between several KSZ8851SNL instances.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_BUS_H
+#define __KSZ8851_BUS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_BUS_OWNER_NONE										0xFF		// spi bus is idle
+#define KSZ_BUS_PRIORITY_LOWEST									0
+#define KSZ_BUS_PRIORITY_HIGHEST								(0xFF - KSZ_BUS_CONFIG_AGING_LIMIT)
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	void (*Lock)(void *user);											// function pointer for user callback. Enters critical section that protects arbiter state (disable irq, take mutex...)
+	void (*Unlock)(void *user);											// function pointer for user callback. Leaves critical section.
+	void (*Yield)(void *user);											// function pointer for user callback. Called while an instance waits bus grant, can be NULL
+	void *user;															// user context passed as first argument to bus callbacks
+
+}KSZ8851_Bus_Callbacks_t;
+
+typedef struct KSZ8851_Bus
+{
+	KSZ8851_Bus_Callbacks_t functions;
+
+	volatile uint8_t	owner;											// slot which owns the bus or KSZ_BUS_OWNER_NONE
+	volatile uint8_t	pending;										// bit mask of slots waiting for bus
+	uint8_t				count;											// number of attached instances
+	uint8_t				last_granted;									// round robin start point between same priorities
+
+	uint8_t				priority[KSZ_BUS_CONFIG_MAX_INSTANCES];			// base priority of each slot, higher value is served first
+	uint8_t				age[KSZ_BUS_CONFIG_MAX_INSTANCES];				// priority levels gained while waiting
+
+	uint32_t			grants[KSZ_BUS_CONFIG_MAX_INSTANCES];			// number of transactions of each slot
+	uint32_t			waits[KSZ_BUS_CONFIG_MAX_INSTANCES];			// number of transactions that had to wait for another slot
+
+}KSZ8851_Bus_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize spi bus arbiter.
+* @param  bus: address of KSZ8851_Bus_t struct that defined by user.
+* @param  callbacks: lock/unlock/yield callbacks.
+*/
+void ksz8851_bus_init(KSZ8851_Bus_t *bus, KSZ8851_Bus_Callbacks_t callbacks);
+
+/**
+* @brief  Attaches a KSZ8851 instance to shared spi bus. Must be called before ksz8851_init of the instance.
+* @param  bus: address of KSZ8851_Bus_t struct.
+* @param  driver: address of KSZ8851_t struct.
+* @param  priority: KSZ_BUS_PRIORITY_LOWEST .. KSZ_BUS_PRIORITY_HIGHEST
+* @retval KSZ_OK, or KSZ_ERROR if all slots are used or Lock / Unlock callback is missing
+*/
+KSZ8851_Status_t ksz8851_bus_attach(KSZ8851_Bus_t *bus, KSZ8851_t *driver, uint8_t priority);
+
+/**
+* @brief  Waits until bus is granted to the slot. It's called by driver before each spi transaction.
+*/
+void ksz8851_bus_acquire(KSZ8851_Bus_t *bus, uint8_t slot);
+
+/**
+* @brief  Releases bus and grants it directly to next waiting slot, so bus doesn't stay idle between transactions.
+*/
+void ksz8851_bus_release(KSZ8851_Bus_t *bus, uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_BUS_H */
@@ -0,0 +1,312 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_classifier.c
+ * @description : 	This file provides EtherType/VLAN classifier with per-class bounded RX queues for KSZ8851SNL driver.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ksz8851_classifier.h"
+
+/* Variables -----------------------------------------------------------------*/
+
+/* queue indexes and counters are 8 bits wide */
+KSZ_STATIC_ASSERT(KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH <= 0xFF, class_queue_depth);
+KSZ_STATIC_ASSERT(KSZ_CLASS_CONFIG_MAX_CLASSES <= 0xFF, class_count);
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static bool ksz8851_classifier_match(const KSZ8851_Class_Rule_t *rule, uint16_t eth_type, uint16_t vlan_id, uint8_t pcp);
+static void ksz8851_classifier_enter(KSZ8851_Classifier_t *classifier);
+static void ksz8851_classifier_exit(KSZ8851_Classifier_t *classifier);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize classifier. All classes are disabled until ksz8851_classifier_set_queue is called.
+* 		  Without critical section callbacks enqueue and dispatch must be called from the same context (e.g. driver task)
+* 		  or under the same lock. Rules must be added before frames are enqueued.
+* @param  classifier: address of KSZ8851_Classifier_t struct that defined by user.
+* @param  default_class: class of frames which match no rule.
+* @param  FreeBuffer: callback that takes back buffers of dropped frames.
+* @param  ENTER_Critical: called around queue index updates, it must mask the context of enqueue (e.g. RX interrupt) when
+* 		  dispatch runs in another one. Handlers and FreeBuffer are called outside of it. Can be NULL.
+* @param  EXIT_Critical: undoes ENTER_Critical. Can be NULL.
+* @param  user: user context passed to FreeBuffer, class handlers and critical section callbacks.
+*/
+void ksz8851_classifier_init(KSZ8851_Classifier_t *classifier, uint8_t default_class, void (*FreeBuffer)(void *user, uint8_t *pRxBuffer),
+							 void (*ENTER_Critical)(void *user), void (*EXIT_Critical)(void *user), void *user)
+{
+	memset(classifier, 0, sizeof(KSZ8851_Classifier_t));
+
+	classifier->default_class	= (default_class < KSZ_CLASS_CONFIG_MAX_CLASSES) ? default_class : (KSZ_CLASS_CONFIG_MAX_CLASSES - 1);
+	classifier->FreeBuffer		= FreeBuffer;
+	classifier->ENTER_Critical	= ENTER_Critical;
+	classifier->EXIT_Critical	= EXIT_Critical;
+	classifier->user			= user;
+}
+
+/**
+* @brief  Configures a class queue.
+* @param  class_no: 0 (highest priority) .. KSZ_CLASS_CONFIG_MAX_CLASSES - 1
+* @param  depth: 1 .. KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH frames, 0 disables class.
+* @param  policy: drop policy of full queue.
+* @param  Handler: called by ksz8851_classifier_dispatch for each frame of the class.
+* @retval KSZ_OK, KSZ_ERROR for invalid arguments
+*/
+KSZ8851_Status_t ksz8851_classifier_set_queue(KSZ8851_Classifier_t *classifier, uint8_t class_no, uint8_t depth,
+											  KSZ8851_Class_Drop_Policy_t policy, void (*Handler)(void *user, uint8_t *pRxBuffer, uint16_t frameLength))
+{
+	KSZ8851_Class_Queue_t *queue;
+	uint8_t *tmpBuffer;
+
+	if(class_no >= KSZ_CLASS_CONFIG_MAX_CLASSES || depth > KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH || (depth != 0 && Handler == NULL))
+	{
+		return KSZ_ERROR;
+	}
+
+	queue = &classifier->queues[class_no];
+
+	/* Frames waiting in a reconfigured queue are dropped, one by one so that buffers are freed outside of critical section */
+	ksz8851_classifier_enter(classifier);
+
+	while(queue->count > 0)
+	{
+		tmpBuffer	= queue->entries[queue->head].buffer;
+		queue->head	= (queue->head + 1) % KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH;
+		queue->count--;
+		queue->dropped++;
+
+		ksz8851_classifier_exit(classifier);
+
+		if(classifier->FreeBuffer != NULL)
+		{
+			classifier->FreeBuffer(classifier->user, tmpBuffer);
+		}
+
+		ksz8851_classifier_enter(classifier);
+	}
+
+	queue->depth	= depth;
+	queue->head		= 0;
+	queue->policy	= policy;
+	queue->Handler	= Handler;
+
+	ksz8851_classifier_exit(classifier);
+
+	return KSZ_OK;
+}
+
+/**
+* @brief  Appends a rule. Rules are checked in the order they are added.
+* @retval KSZ_OK, KSZ_BUSY if rule table is full, KSZ_ERROR for invalid class
+*/
+KSZ8851_Status_t ksz8851_classifier_add_rule(KSZ8851_Classifier_t *classifier, const KSZ8851_Class_Rule_t *rule)
+{
+	if(rule->class_no >= KSZ_CLASS_CONFIG_MAX_CLASSES || rule->pcp_min > rule->pcp_max)
+	{
+		return KSZ_ERROR;
+	}
+
+	if(classifier->rule_count >= KSZ_CLASS_CONFIG_MAX_RULES)
+	{
+		return KSZ_BUSY;
+	}
+
+	classifier->rules[classifier->rule_count++] = *rule;
+
+	return KSZ_OK;
+}
+
+/**
+* @brief  Returns class of a frame by its EtherType, VLAN ID and priority.
+*/
+uint8_t ksz8851_classifier_classify(const KSZ8851_Classifier_t *classifier, const uint8_t *pRxBuffer, uint16_t frameLength)
+{
+	uint16_t tmpEthType, tmpTagControl, tmpVlanId = KSZ_CLASS_VLAN_UNTAGGED;
+	uint8_t  tmpPcp = KSZ_CLASS_PCP_NONE, i;
+
+	if(frameLength < KSZ_ETH_MIN_FRAME_SIZE)
+	{
+		return classifier->default_class;
+	}
+
+	/* Network byte order */
+	tmpEthType = (uint16_t)((pRxBuffer[KSZ_ETH_TYPE_OFFSET] << KSZ_1BYTE_SHIFTING_VALUE) | pRxBuffer[KSZ_ETH_TYPE_OFFSET + 1]);
+
+	if((tmpEthType == KSZ_ETH_TYPE_VLAN || tmpEthType == KSZ_ETH_TYPE_QINQ) && frameLength >= KSZ_ETH_MIN_FRAME_SIZE + KSZ_ETH_VLAN_TAG_SIZE)
+	{
+		tmpTagControl	= (uint16_t)((pRxBuffer[KSZ_ETH_TYPE_OFFSET + 2] << KSZ_1BYTE_SHIFTING_VALUE) | pRxBuffer[KSZ_ETH_TYPE_OFFSET + 3]);
+		tmpVlanId		= tmpTagControl & KSZ_ETH_VLAN_ID_MASK;
+		tmpPcp			= (uint8_t)(tmpTagControl >> KSZ_ETH_VLAN_PCP_SHIFT);
+		tmpEthType		= (uint16_t)((pRxBuffer[KSZ_ETH_TYPE_OFFSET + 4] << KSZ_1BYTE_SHIFTING_VALUE) | pRxBuffer[KSZ_ETH_TYPE_OFFSET + 5]);
+	}
+
+	for(i = 0; i < classifier->rule_count; i++)
+	{
+		if(ksz8851_classifier_match(&classifier->rules[i], tmpEthType, tmpVlanId, tmpPcp))
+		{
+			return classifier->rules[i].class_no;
+		}
+	}
+
+	return classifier->default_class;
+}
+
+/**
+* @brief  Classifies a received frame and puts it in its class queue. It can be used directly in RX_FrameReceived callback.
+* @retval KSZ_OK, KSZ_BUSY if a frame is dropped by queue policy
+*/
+KSZ8851_Status_t ksz8851_classifier_enqueue(KSZ8851_Classifier_t *classifier, uint8_t *pRxBuffer, uint16_t frameLength)
+{
+	KSZ8851_Class_Queue_t *queue = &classifier->queues[ksz8851_classifier_classify(classifier, pRxBuffer, frameLength)];
+	KSZ8851_Status_t result = KSZ_OK;
+	uint8_t *tmpDropped = NULL;
+	uint8_t tail;
+
+	ksz8851_classifier_enter(classifier);
+
+	if(queue->depth == 0 || (queue->count >= queue->depth && queue->policy == KSZ_CLASS_DROP_NEWEST))
+	{
+		queue->dropped++;
+		tmpDropped = pRxBuffer;
+		result = KSZ_BUSY;
+	}
+	else
+	{
+		if(queue->count >= queue->depth)
+		{
+			/* KSZ_CLASS_DROP_OLDEST */
+			tmpDropped	= queue->entries[queue->head].buffer;
+			queue->head	= (queue->head + 1) % KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH;
+			queue->count--;
+			queue->dropped++;
+			result = KSZ_BUSY;
+		}
+
+		tail = (queue->head + queue->count) % KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH;
+
+		queue->entries[tail].buffer = pRxBuffer;
+		queue->entries[tail].length = frameLength;
+		queue->count++;
+		queue->enqueued++;
+
+		if(queue->count > queue->high_water)
+		{
+			queue->high_water = queue->count;
+		}
+	}
+
+	ksz8851_classifier_exit(classifier);
+
+	if(tmpDropped != NULL && classifier->FreeBuffer != NULL)
+	{
+		classifier->FreeBuffer(classifier->user, tmpDropped);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Runs class handlers in priority order. Highest priority queue is checked again before each frame, so
+* 		  real-time classes never wait behind a backlog of lower classes.
+* @param  budget: maximum number of frames handled in this call.
+* @retval number of handled frames
+*/
+uint16_t ksz8851_classifier_dispatch(KSZ8851_Classifier_t *classifier, uint16_t budget)
+{
+	KSZ8851_Class_Queue_t *queue;
+	KSZ8851_Class_Entry_t entry;
+	void (*handler)(void *user, uint8_t *pRxBuffer, uint16_t frameLength);
+	uint16_t handled = 0;
+	uint8_t  class_no;
+
+	while(handled < budget)
+	{
+		ksz8851_classifier_enter(classifier);
+
+		for(class_no = 0; class_no < KSZ_CLASS_CONFIG_MAX_CLASSES; class_no++)
+		{
+			if(classifier->queues[class_no].count > 0)
+			{
+				break;
+			}
+		}
+
+		if(class_no == KSZ_CLASS_CONFIG_MAX_CLASSES)
+		{
+			ksz8851_classifier_exit(classifier);
+			break;
+		}
+
+		queue = &classifier->queues[class_no];
+
+		/* Entry is taken out before handler runs, so handler can enqueue or reconfigure safely */
+		entry		= queue->entries[queue->head];
+		handler		= queue->Handler;
+		queue->head	= (queue->head + 1) % KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH;
+		queue->count--;
+		queue->handled++;
+
+		ksz8851_classifier_exit(classifier);
+
+		handler(classifier->user, entry.buffer, entry.length);
+		handled++;
+	}
+
+	return handled;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Checks a frame against one rule.
+ */
+static bool ksz8851_classifier_match(const KSZ8851_Class_Rule_t *rule, uint16_t eth_type, uint16_t vlan_id, uint8_t pcp)
+{
+	if(rule->eth_type != KSZ_CLASS_ETH_TYPE_ANY && rule->eth_type != eth_type)
+	{
+		return false;
+	}
+
+	if(rule->vlan_id != KSZ_CLASS_VLAN_ANY && rule->vlan_id != vlan_id)
+	{
+		return false;
+	}
+
+	return (pcp >= rule->pcp_min && pcp <= rule->pcp_max);
+}
+
+/**
+ * @brief  Enters critical section of queue indexes if the user gave one.
+ */
+static void ksz8851_classifier_enter(KSZ8851_Classifier_t *classifier)
+{
+	if(classifier->ENTER_Critical != NULL)
+	{
+		classifier->ENTER_Critical(classifier->user);
+	}
+}
+
+/**
+ * @brief  Leaves critical section of queue indexes.
+ */
+static void ksz8851_classifier_exit(KSZ8851_Classifier_t *classifier)
+{
+	if(classifier->EXIT_Critical != NULL)
+	{
+		classifier->EXIT_Critical(classifier->user);
+	}
+}
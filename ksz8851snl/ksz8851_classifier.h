@@ -0,0 +1,160 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_classifier.h
+ * @description : 	This file provides EtherType/VLAN classifier with per-class bounded RX queues for KSZ8851SNL driver.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_CLASSIFIER_H
+#define __KSZ8851_CLASSIFIER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_ETH_TYPE_VLAN										0x8100		// 802.1Q tag protocol identifier
+#define KSZ_ETH_TYPE_QINQ										0x88A8		// 802.1ad service tag protocol identifier
+#define KSZ_ETH_TYPE_PROFINET									0x8892		// PROFINET real-time
+#define KSZ_ETH_VLAN_TAG_SIZE									4
+#define KSZ_ETH_VLAN_ID_MASK									0x0FFF
+#define KSZ_ETH_VLAN_PCP_SHIFT									13
+
+#define KSZ_CLASS_ETH_TYPE_ANY									0x0000		// rule matches every EtherType
+#define KSZ_CLASS_VLAN_ANY										0xFFFF		// rule matches tagged and untagged frames
+#define KSZ_CLASS_VLAN_UNTAGGED									0xFFFE		// rule matches only untagged frames
+#define KSZ_CLASS_PCP_NONE										0			// priority of untagged frames
+
+/* Enums ---------------------------------------------------------------------*/
+
+typedef enum
+{
+	KSZ_CLASS_DROP_NEWEST	= 0,									// full queue drops arriving frame
+	KSZ_CLASS_DROP_OLDEST											// full queue drops its oldest frame, so handler gets freshest data (real-time)
+
+}KSZ8851_Class_Drop_Policy_t;
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint16_t		eth_type;										// EtherType after VLAN tag, or KSZ_CLASS_ETH_TYPE_ANY
+	uint16_t		vlan_id;										// 802.1Q VLAN ID, KSZ_CLASS_VLAN_ANY or KSZ_CLASS_VLAN_UNTAGGED
+	uint8_t			pcp_min;										// 802.1Q priority range, untagged frames have KSZ_CLASS_PCP_NONE
+	uint8_t			pcp_max;
+	uint8_t			class_no;										// destination class
+
+}KSZ8851_Class_Rule_t;
+
+typedef struct
+{
+	uint8_t			*buffer;
+	uint16_t		length;
+
+}KSZ8851_Class_Entry_t;
+
+typedef struct
+{
+	KSZ8851_Class_Entry_t	entries[KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH];
+	uint8_t					depth;									// 0 means class is disabled and its frames are dropped
+	uint8_t					head;
+	uint8_t					count;
+	KSZ8851_Class_Drop_Policy_t	policy;
+	void	(*Handler)(void *user, uint8_t *pRxBuffer, uint16_t frameLength);	// takes ownership of buffer
+
+	uint32_t				enqueued;
+	uint32_t				dropped;
+	uint32_t				handled;
+	uint8_t					high_water;								// maximum count seen
+
+}KSZ8851_Class_Queue_t;
+
+typedef struct
+{
+	KSZ8851_Class_Rule_t	rules[KSZ_CLASS_CONFIG_MAX_RULES];		// first matching rule selects class
+	uint8_t					rule_count;
+	uint8_t					default_class;							// class of frames which match no rule
+	KSZ8851_Class_Queue_t	queues[KSZ_CLASS_CONFIG_MAX_CLASSES];	// index is priority, 0 is served first
+
+	void	(*FreeBuffer)(void *user, uint8_t *pRxBuffer);			// returns buffer of dropped frame to its owner
+	void	(*ENTER_Critical)(void *user);							// masks the context of enqueue while queue indexes change, NULL if enqueue and dispatch run in one context
+	void	(*EXIT_Critical)(void *user);
+	void	*user;
+
+}KSZ8851_Classifier_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize classifier. All classes are disabled until ksz8851_classifier_set_queue is called.
+* 		  Without critical section callbacks enqueue and dispatch must be called from the same context (e.g. driver task)
+* 		  or under the same lock. Rules must be added before frames are enqueued.
+* @param  classifier: address of KSZ8851_Classifier_t struct that defined by user.
+* @param  default_class: class of frames which match no rule.
+* @param  FreeBuffer: callback that takes back buffers of dropped frames.
+* @param  ENTER_Critical: called around queue index updates, it must mask the context of enqueue (e.g. RX interrupt) when
+* 		  dispatch runs in another one. Handlers and FreeBuffer are called outside of it. Can be NULL.
+* @param  EXIT_Critical: undoes ENTER_Critical. Can be NULL.
+* @param  user: user context passed to FreeBuffer, class handlers and critical section callbacks.
+*/
+void ksz8851_classifier_init(KSZ8851_Classifier_t *classifier, uint8_t default_class, void (*FreeBuffer)(void *user, uint8_t *pRxBuffer),
+							 void (*ENTER_Critical)(void *user), void (*EXIT_Critical)(void *user), void *user);
+
+/**
+* @brief  Configures a class queue.
+* @param  class_no: 0 (highest priority) .. KSZ_CLASS_CONFIG_MAX_CLASSES - 1
+* @param  depth: 1 .. KSZ_CLASS_CONFIG_MAX_QUEUE_DEPTH frames, 0 disables class.
+* @param  policy: drop policy of full queue.
+* @param  Handler: called by ksz8851_classifier_dispatch for each frame of the class.
+* @retval KSZ_OK, KSZ_ERROR for invalid arguments
+*/
+KSZ8851_Status_t ksz8851_classifier_set_queue(KSZ8851_Classifier_t *classifier, uint8_t class_no, uint8_t depth,
+											  KSZ8851_Class_Drop_Policy_t policy, void (*Handler)(void *user, uint8_t *pRxBuffer, uint16_t frameLength));
+
+/**
+* @brief  Appends a rule. Rules are checked in the order they are added.
+* @retval KSZ_OK, KSZ_BUSY if rule table is full, KSZ_ERROR for invalid class
+*/
+KSZ8851_Status_t ksz8851_classifier_add_rule(KSZ8851_Classifier_t *classifier, const KSZ8851_Class_Rule_t *rule);
+
+/**
+* @brief  Returns class of a frame by its EtherType, VLAN ID and priority.
+*/
+uint8_t ksz8851_classifier_classify(const KSZ8851_Classifier_t *classifier, const uint8_t *pRxBuffer, uint16_t frameLength);
+
+/**
+* @brief  Classifies a received frame and puts it in its class queue. It can be used directly in RX_FrameReceived callback.
+* @retval KSZ_OK, KSZ_BUSY if a frame is dropped by queue policy
+*/
+KSZ8851_Status_t ksz8851_classifier_enqueue(KSZ8851_Classifier_t *classifier, uint8_t *pRxBuffer, uint16_t frameLength);
+
+/**
+* @brief  Runs class handlers in priority order. Highest priority queue is checked again before each frame, so
+* 		  real-time classes never wait behind a backlog of lower classes.
+* @param  budget: maximum number of frames handled in this call.
+* @retval number of handled frames
+*/
+uint16_t ksz8851_classifier_dispatch(KSZ8851_Classifier_t *classifier, uint16_t budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_CLASSIFIER_H */
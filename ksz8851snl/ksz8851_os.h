@@ -0,0 +1,60 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_os.h
+ * @description : 	This file provides operating system abstraction used by threaded KSZ8851SNL driver service.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_OS_H
+#define __KSZ8851_OS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_OS_WAIT_FOREVER										0xFFFFFFFF	// timeout value to wait semaphore without limit
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef void* KSZ8851_OS_Handle_t;													// mutex, semaphore or task object of the OS port
+
+typedef struct
+{
+	KSZ8851_OS_Handle_t (*MUTEX_Create)(void *user);																		// function pointer for user callback. Creates a mutex, returns NULL on failure.
+	void	 (*MUTEX_Lock)(void *user, KSZ8851_OS_Handle_t mutex);															// function pointer for user callback. Takes mutex, waits without limit.
+	void	 (*MUTEX_Unlock)(void *user, KSZ8851_OS_Handle_t mutex);														// function pointer for user callback. Gives mutex.
+
+	KSZ8851_OS_Handle_t (*SEM_Create)(void *user);																			// function pointer for user callback. Creates a binary/counting semaphore with zero initial count, returns NULL on failure.
+	void	 (*SEM_Give)(void *user, KSZ8851_OS_Handle_t sem);																// function pointer for user callback. Gives semaphore from task context.
+	void	 (*SEM_GiveFromISR)(void *user, KSZ8851_OS_Handle_t sem);														// function pointer for user callback. Gives semaphore from interrupt context (INTRN isr).
+	bool	 (*SEM_Take)(void *user, KSZ8851_OS_Handle_t sem, uint32_t timeout_ms);										// function pointer for user callback. Takes semaphore, returns false on timeout.
+
+	KSZ8851_Status_t (*TASK_Create)(void *user, void (*entry)(void *arg), void *arg, const char *name,
+									uint32_t stack_size, uint32_t priority);												// function pointer for user callback. Creates and starts a task running entry(arg).
+	void	*user;																											// user context passed as first argument to OS callbacks
+
+}KSZ8851_OS_Callbacks_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_OS_H */
@@ -0,0 +1,265 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_pool.c
+ * @description : 	This file provides fixed-size packet buffer pools in size classes for KSZ8851SNL driver.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ksz8851_pool.h"
+
+/* Variables -----------------------------------------------------------------*/
+
+/* Classes are ordered by size, large buffers hold any frame which RX path reads */
+KSZ_STATIC_ASSERT(KSZ_POOL_CONFIG_SMALL_SIZE < KSZ_POOL_CONFIG_MEDIUM_SIZE && KSZ_POOL_CONFIG_MEDIUM_SIZE < KSZ_POOL_CONFIG_LARGE_SIZE &&
+				  KSZ_POOL_CONFIG_LARGE_SIZE >= KSZ_POOL_RX_LENGTH(KSZ_ETH_MAX_FRAME_SIZE), pool_sizes);
+
+/* Block indexes are 16 bits wide, KSZ_POOL_NONE ends free list, link fits into headroom */
+KSZ_STATIC_ASSERT(KSZ_POOL_CONFIG_SMALL_COUNT > 0 && KSZ_POOL_CONFIG_SMALL_COUNT < KSZ_POOL_NONE &&
+				  KSZ_POOL_CONFIG_MEDIUM_COUNT > 0 && KSZ_POOL_CONFIG_MEDIUM_COUNT < KSZ_POOL_NONE &&
+				  KSZ_POOL_CONFIG_LARGE_COUNT > 0 && KSZ_POOL_CONFIG_LARGE_COUNT < KSZ_POOL_NONE &&
+				  KSZ_POOL_HEADROOM >= sizeof(uint16_t), pool_counts);
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static void ksz8851_pool_class_init(KSZ8851_Pool_Class_t *pool_class, uint32_t *storage, uint32_t *allocated, uint16_t size, uint16_t count);
+static KSZ8851_Pool_Class_t *ksz8851_pool_find(const KSZ8851_Pool_t *pool, const uint8_t *buffer, uint16_t *index);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize pool. Storage is part of KSZ8851_Pool_t, so a static pool needs no heap.
+* @param  pool: address of KSZ8851_Pool_t struct that defined by user.
+* @param  ENTER_Critical: called around free list updates, it must mask interrupts which use the pool. Can be NULL.
+* @param  EXIT_Critical: undoes ENTER_Critical. Can be NULL.
+* @param  user: user context passed to critical section callbacks.
+*/
+void ksz8851_pool_init(KSZ8851_Pool_t *pool, void (*ENTER_Critical)(void *user), void (*EXIT_Critical)(void *user), void *user)
+{
+	pool->failures			= 0;
+	pool->invalid_frees		= 0;
+	pool->ENTER_Critical	= ENTER_Critical;
+	pool->EXIT_Critical		= EXIT_Critical;
+	pool->user				= user;
+
+	ksz8851_pool_class_init(&pool->classes[0], pool->small, pool->small_allocated, KSZ_POOL_CONFIG_SMALL_SIZE, KSZ_POOL_CONFIG_SMALL_COUNT);
+	ksz8851_pool_class_init(&pool->classes[1], pool->medium, pool->medium_allocated, KSZ_POOL_CONFIG_MEDIUM_SIZE, KSZ_POOL_CONFIG_MEDIUM_COUNT);
+	ksz8851_pool_class_init(&pool->classes[2], pool->large, pool->large_allocated, KSZ_POOL_CONFIG_LARGE_SIZE, KSZ_POOL_CONFIG_LARGE_COUNT);
+}
+
+/**
+* @brief  Takes a buffer from the smallest class which fits, or from a larger class if it is empty. O(1), it can be called
+* 		  from interrupt context.
+* @param  length: bytes which will be written to buffer.
+* @retval buffer with KSZ_POOL_HEADROOM bytes before it, NULL if no class has a free buffer large enough
+*/
+uint8_t *ksz8851_pool_alloc(KSZ8851_Pool_t *pool, uint16_t length)
+{
+	KSZ8851_Pool_Class_t *pool_class;
+	KSZ8851_Pool_Class_t *fitting_class = NULL;
+	uint8_t *block = NULL;
+	uint8_t i;
+
+	if(pool->ENTER_Critical != NULL)
+	{
+		pool->ENTER_Critical(pool->user);
+	}
+
+	for(i = 0; i < KSZ_POOL_CLASSES; i++)
+	{
+		pool_class = &pool->classes[i];
+
+		if(length > pool_class->size)
+		{
+			continue;
+		}
+
+		/* A request which doesn't get its smallest fitting class is counted once, on that class */
+		if(fitting_class == NULL)
+		{
+			fitting_class = pool_class;
+		}
+
+		if(pool_class->free_head == KSZ_POOL_NONE)
+		{
+			continue;
+		}
+
+		/* Pop first free block, its first bytes hold index of next free block */
+		block = pool_class->storage + (uint32_t)pool_class->free_head * pool_class->block_size;
+		pool_class->allocated[pool_class->free_head / 32] |= (1UL << (pool_class->free_head % 32));
+		memcpy(&pool_class->free_head, block, sizeof(uint16_t));
+
+		pool_class->allocs++;
+		pool_class->in_use++;
+
+		if(pool_class->in_use > pool_class->high_water)
+		{
+			pool_class->high_water = pool_class->in_use;
+		}
+
+		break;
+	}
+
+	if(fitting_class != NULL && (block == NULL || fitting_class != pool_class))
+	{
+		fitting_class->fallbacks++;
+	}
+
+	if(block == NULL)
+	{
+		pool->failures++;
+	}
+
+	if(pool->EXIT_Critical != NULL)
+	{
+		pool->EXIT_Critical(pool->user);
+	}
+
+	return (block != NULL) ? (block + KSZ_POOL_HEADROOM) : NULL;
+}
+
+/**
+* @brief  Takes a buffer for a received frame, it can be used in RX_GetBuffer callback.
+* @param  frame_length: frame length without CRC.
+* @retval buffer of at least KSZ_POOL_RX_LENGTH(frame_length) bytes, NULL to drop frame
+*/
+uint8_t *ksz8851_pool_rx_buffer(KSZ8851_Pool_t *pool, uint16_t frame_length)
+{
+	return ksz8851_pool_alloc(pool, KSZ_POOL_RX_LENGTH(frame_length));
+}
+
+/**
+* @brief  Returns a buffer to its class. O(1), it can be called from interrupt context, e.g. in TX_BufferReleased callback.
+* @retval KSZ_OK, KSZ_ERROR if buffer doesn't belong to pool or its class has no buffer in use
+*/
+KSZ8851_Status_t ksz8851_pool_free(KSZ8851_Pool_t *pool, uint8_t *buffer)
+{
+	KSZ8851_Pool_Class_t *pool_class;
+	uint16_t index;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	pool_class = ksz8851_pool_find(pool, buffer, &index);
+
+	if(pool->ENTER_Critical != NULL)
+	{
+		pool->ENTER_Critical(pool->user);
+	}
+
+	/* A block which isn't allocated is already in free list, pushing it again would make the list a cycle */
+	if(pool_class == NULL || (pool_class->allocated[index / 32] & (1UL << (index % 32))) == 0)
+	{
+		pool->invalid_frees++;
+		result = KSZ_ERROR;
+	}
+	else
+	{
+		/* Push block to front of free list */
+		memcpy(buffer - KSZ_POOL_HEADROOM, &pool_class->free_head, sizeof(uint16_t));
+		pool_class->free_head = index;
+		pool_class->allocated[index / 32] &= ~(1UL << (index % 32));
+		pool_class->in_use--;
+	}
+
+	if(pool->EXIT_Critical != NULL)
+	{
+		pool->EXIT_Critical(pool->user);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Returns data size of a pool buffer.
+* @retval size in bytes, 0 if buffer doesn't belong to pool
+*/
+uint16_t ksz8851_pool_buffer_size(const KSZ8851_Pool_t *pool, const uint8_t *buffer)
+{
+	uint16_t index;
+	KSZ8851_Pool_Class_t *pool_class = ksz8851_pool_find(pool, buffer, &index);
+
+	return (pool_class != NULL) ? pool_class->size : 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Links all blocks of a class into its free list.
+ * @param  pool_class
+ * @param  storage: dword aligned storage of count blocks
+ * @param  allocated: KSZ_POOL_BITMAP_WORDS(count) words of allocated bits
+ * @param  size: data bytes of each buffer
+ * @param  count: number of buffers
+ */
+static void ksz8851_pool_class_init(KSZ8851_Pool_Class_t *pool_class, uint32_t *storage, uint32_t *allocated, uint16_t size, uint16_t count)
+{
+	uint16_t i, next;
+
+	pool_class->storage		= (uint8_t *)storage;
+	pool_class->block_size	= KSZ_POOL_BLOCK_SIZE(size);
+	pool_class->size		= pool_class->block_size - KSZ_POOL_HEADROOM;
+	pool_class->count		= count;
+	pool_class->free_head	= 0;
+	pool_class->allocated	= allocated;
+	pool_class->in_use		= 0;
+	pool_class->high_water	= 0;
+	pool_class->allocs		= 0;
+	pool_class->fallbacks	= 0;
+
+	memset(allocated, 0, KSZ_POOL_BITMAP_WORDS(count) * sizeof(uint32_t));
+
+	for(i = 0; i < count; i++)
+	{
+		next = (i + 1 < count) ? (i + 1) : KSZ_POOL_NONE;
+		memcpy(pool_class->storage + (uint32_t)i * pool_class->block_size, &next, sizeof(uint16_t));
+	}
+}
+
+/**
+ * @brief  Finds class and block index of a buffer by address range of class storage.
+ * @param  pool
+ * @param  buffer: pointer returned by ksz8851_pool_alloc
+ * @param  index: block index, filled by function
+ * @return class of buffer, NULL if buffer isn't a block of pool
+ */
+static KSZ8851_Pool_Class_t *ksz8851_pool_find(const KSZ8851_Pool_t *pool, const uint8_t *buffer, uint16_t *index)
+{
+	const KSZ8851_Pool_Class_t *pool_class;
+	uint32_t offset;
+	uint8_t i;
+
+	for(i = 0; i < KSZ_POOL_CLASSES; i++)
+	{
+		pool_class = &pool->classes[i];
+
+		if(buffer < pool_class->storage + KSZ_POOL_HEADROOM || buffer >= pool_class->storage + (uint32_t)pool_class->count * pool_class->block_size)
+		{
+			continue;
+		}
+
+		offset = (uint32_t)(buffer - KSZ_POOL_HEADROOM - pool_class->storage);
+
+		if((offset % pool_class->block_size) != 0)
+		{
+			return NULL;
+		}
+
+		*index = (uint16_t)(offset / pool_class->block_size);
+
+		return (KSZ8851_Pool_Class_t *)pool_class;
+	}
+
+	return NULL;
+}
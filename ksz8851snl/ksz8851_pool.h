@@ -0,0 +1,120 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_pool.h
+ * @description : 	This file provides fixed-size packet buffer pools in size classes for KSZ8851SNL driver.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_POOL_H
+#define __KSZ8851_POOL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_POOL_CLASSES										3			// small, medium and large buffers
+#define KSZ_POOL_HEADROOM										(KSZ_RX_FIFO_HEADER_SIZE + KSZ_RX_IP_OFFSET_SIZE)	// room for RX status / byte count and 2 bytes IP offset before frame, IP header is dword aligned
+#define KSZ_POOL_BLOCK_SIZE(size)								KSZ_DWORD_ALIGN(KSZ_POOL_HEADROOM + (size))
+#define KSZ_POOL_BLOCK_WORDS(size, count)						(((count) * KSZ_POOL_BLOCK_SIZE(size)) / sizeof(uint32_t))
+#define KSZ_POOL_BITMAP_WORDS(count)							(((count) + 31) / 32)	// one allocated bit per block
+#define KSZ_POOL_RX_LENGTH(frame_length)						KSZ_RX_BUFFER_SIZE(frame_length)	// buffer bytes RX_GetBuffer must provide for a frame
+#define KSZ_POOL_NONE											0xFFFF		// end of free list
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint8_t			*storage;										// first block, blocks are headroom + data
+	uint16_t		block_size;
+	uint16_t		size;											// data bytes of each buffer
+	uint16_t		count;
+	uint16_t		free_head;										// index of first free block, next index is kept in the block
+	uint32_t		*allocated;										// bit of each block is set while it is allocated, frees of clear blocks are rejected
+
+	uint16_t		in_use;
+	uint16_t		high_water;										// maximum in_use seen
+	uint32_t		allocs;
+	uint32_t		fallbacks;										// requests which found this class empty as smallest fitting class, they took a larger class or failed
+
+}KSZ8851_Pool_Class_t;
+
+typedef struct
+{
+	KSZ8851_Pool_Class_t	classes[KSZ_POOL_CLASSES];				// ascending size, a request takes the smallest free class which fits
+	uint32_t				failures;								// requests which got no buffer
+	uint32_t				invalid_frees;							// pointers which don't belong to pool or aren't allocated (double free)
+
+	void	(*ENTER_Critical)(void *user);							// masks interrupts which allocate or free buffers, NULL if pool is used from one context
+	void	(*EXIT_Critical)(void *user);
+	void	*user;
+
+	uint32_t				small[KSZ_POOL_BLOCK_WORDS(KSZ_POOL_CONFIG_SMALL_SIZE, KSZ_POOL_CONFIG_SMALL_COUNT)];
+	uint32_t				medium[KSZ_POOL_BLOCK_WORDS(KSZ_POOL_CONFIG_MEDIUM_SIZE, KSZ_POOL_CONFIG_MEDIUM_COUNT)];
+	uint32_t				large[KSZ_POOL_BLOCK_WORDS(KSZ_POOL_CONFIG_LARGE_SIZE, KSZ_POOL_CONFIG_LARGE_COUNT)];
+	uint32_t				small_allocated[KSZ_POOL_BITMAP_WORDS(KSZ_POOL_CONFIG_SMALL_COUNT)];
+	uint32_t				medium_allocated[KSZ_POOL_BITMAP_WORDS(KSZ_POOL_CONFIG_MEDIUM_COUNT)];
+	uint32_t				large_allocated[KSZ_POOL_BITMAP_WORDS(KSZ_POOL_CONFIG_LARGE_COUNT)];
+
+}KSZ8851_Pool_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Initialize pool. Storage is part of KSZ8851_Pool_t, so a static pool needs no heap.
+* @param  pool: address of KSZ8851_Pool_t struct that defined by user.
+* @param  ENTER_Critical: called around free list updates, it must mask interrupts which use the pool. Can be NULL.
+* @param  EXIT_Critical: undoes ENTER_Critical. Can be NULL.
+* @param  user: user context passed to critical section callbacks.
+*/
+void ksz8851_pool_init(KSZ8851_Pool_t *pool, void (*ENTER_Critical)(void *user), void (*EXIT_Critical)(void *user), void *user);
+
+/**
+* @brief  Takes a buffer from the smallest class which fits, or from a larger class if it is empty. O(1), it can be called
+* 		  from interrupt context.
+* @param  length: bytes which will be written to buffer.
+* @retval buffer with KSZ_POOL_HEADROOM bytes before it, NULL if no class has a free buffer large enough
+*/
+uint8_t *ksz8851_pool_alloc(KSZ8851_Pool_t *pool, uint16_t length);
+
+/**
+* @brief  Takes a buffer for a received frame, it can be used in RX_GetBuffer callback.
+* @param  frame_length: frame length without CRC.
+* @retval buffer of at least KSZ_POOL_RX_LENGTH(frame_length) bytes, NULL to drop frame
+*/
+uint8_t *ksz8851_pool_rx_buffer(KSZ8851_Pool_t *pool, uint16_t frame_length);
+
+/**
+* @brief  Returns a buffer to its class. O(1), it can be called from interrupt context, e.g. in TX_BufferReleased callback.
+* @retval KSZ_OK, KSZ_ERROR if buffer doesn't belong to pool or isn't allocated, e.g. it is freed twice
+*/
+KSZ8851_Status_t ksz8851_pool_free(KSZ8851_Pool_t *pool, uint8_t *buffer);
+
+/**
+* @brief  Returns data size of a pool buffer.
+* @retval size in bytes, 0 if buffer doesn't belong to pool
+*/
+uint16_t ksz8851_pool_buffer_size(const KSZ8851_Pool_t *pool, const uint8_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_POOL_H */
@@ -0,0 +1,190 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_service.c
+ * @description : 	This file provides threaded KSZ8851SNL driver service. INTRN isr only signals, driver task does spi work.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ksz8851_service.h"
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static void ksz8851_service_task(void *arg);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Creates driver lock, interrupt semaphore and driver task. ksz8851_init must be called before, and INTRN
+* 		  interrupt must call ksz8851_service_isr. After this call the driver must be used only through service functions.
+* @param  service: address of KSZ8851_Service_t struct that defined by user.
+* @param  driver: initialized driver.
+* @param  os: OS port callbacks.
+* @retval KSZ_OK, or KSZ_ERROR if an OS object can't be created
+*/
+KSZ8851_Status_t ksz8851_service_init(KSZ8851_Service_t *service, KSZ8851_t *driver, KSZ8851_OS_Callbacks_t os)
+{
+	memset(service, 0, sizeof(KSZ8851_Service_t));
+
+	service->driver		= driver;
+	service->os			= os;
+
+	service->lock		= os.MUTEX_Create(os.user);
+	service->irq_signal	= os.SEM_Create(os.user);
+
+	if(service->lock == NULL || service->irq_signal == NULL)
+	{
+		return KSZ_ERROR;
+	}
+
+	service->running	= true;
+
+	/* Driver task checks polling mode and calls ksz8851_poll */
+	ksz8851_enable_polling(driver);
+
+	if(os.TASK_Create(os.user, ksz8851_service_task, service, "ksz8851",
+			KSZ_SERVICE_CONFIG_TASK_STACK_SIZE, KSZ_SERVICE_CONFIG_TASK_PRIORITY) != KSZ_OK)
+	{
+		service->running = false;
+		return KSZ_ERROR;
+	}
+
+	return KSZ_OK;
+}
+
+/**
+* @brief  Signals driver task. Must be called from INTRN falling edge interrupt, it doesn't touch spi.
+*/
+void ksz8851_service_isr(KSZ8851_Service_t *service)
+{
+	ksz8851_irq_timestamp(service->driver);
+	service->irq_count++;
+	service->os.SEM_GiveFromISR(service->os.user, service->irq_signal);
+}
+
+/**
+* @brief  Sends a frame. It can be called from several tasks at the same time.
+* @retval status of ksz8851_send_frame
+*/
+KSZ8851_Status_t ksz8851_service_send(KSZ8851_Service_t *service, uint8_t *txBuffer, uint16_t frame_length)
+{
+	KSZ8851_Status_t result;
+
+	ksz8851_service_lock(service);
+	result = ksz8851_send_frame(service->driver, txBuffer, frame_length);
+	ksz8851_service_unlock(service);
+
+	return result;
+}
+
+/**
+* @brief  Puts a frame into a strict priority TX queue. It can be called from several tasks at the same time.
+* @retval status of ksz8851_tx_enqueue
+*/
+KSZ8851_Status_t ksz8851_service_enqueue(KSZ8851_Service_t *service, uint8_t priority, uint8_t *txBuffer, uint16_t frame_length)
+{
+	KSZ8851_Status_t result;
+
+	ksz8851_service_lock(service);
+	result = ksz8851_tx_enqueue(service->driver, priority, txBuffer, frame_length);
+	ksz8851_service_unlock(service);
+
+	return result;
+}
+
+/**
+* @brief  Takes driver lock, so other driver functions can be called from application tasks between lock and unlock.
+*/
+void ksz8851_service_lock(KSZ8851_Service_t *service)
+{
+	service->os.MUTEX_Lock(service->os.user, service->lock);
+}
+
+/**
+* @brief  Gives driver lock.
+*/
+void ksz8851_service_unlock(KSZ8851_Service_t *service)
+{
+	service->os.MUTEX_Unlock(service->os.user, service->lock);
+}
+
+/**
+* @brief  Stops driver task after its current service. OS objects belong to the port and aren't deleted.
+*/
+void ksz8851_service_stop(KSZ8851_Service_t *service)
+{
+	service->running = false;
+	service->os.SEM_Give(service->os.user, service->irq_signal);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Driver task. Waits INTRN signal and services the chip under driver lock, received frames are
+ * 		   handed over by RX_GetBuffer / RX_FrameReceived callbacks in this task's context. Lock is given
+ * 		   between polls, so senders aren't starved under heavy RX load.
+ * @param  arg: address of KSZ8851_Service_t struct
+ */
+static void ksz8851_service_task(void *arg)
+{
+	KSZ8851_Service_t *service = (KSZ8851_Service_t*)arg;
+	bool signalled, polling;
+	uint8_t processed = 1;
+	uint32_t timeout;
+
+	while(service->running)
+	{
+		/* In polling mode RXQ is drained without waiting INTRN, other interrupts are still checked between polls. A poll round
+		 * which found no frame is followed by a short wait, so an idle polling task doesn't spin */
+		polling = ksz8851_is_polling(service->driver);
+
+		if(!polling)
+		{
+			timeout = KSZ_SERVICE_CONFIG_IRQ_TIMEOUT_MS;
+			processed = 1;
+		}
+		else
+		{
+			timeout = (processed == 0) ? KSZ_SERVICE_CONFIG_POLL_IDLE_MS : 0;
+		}
+
+		signalled = service->os.SEM_Take(service->os.user, service->irq_signal, timeout);
+
+		if(!service->running)
+		{
+			break;
+		}
+
+		ksz8851_service_lock(service);
+
+		if(polling)
+		{
+			ksz8851_poll(service->driver, KSZ_POLL_CONFIG_BUDGET, &processed);
+		}
+
+		if(signalled || !polling)
+		{
+			if(!signalled)
+			{
+				service->timeout_count++;
+			}
+
+			ksz8851_irq_handler(service->driver);
+			service->service_count++;
+		}
+
+		ksz8851_service_unlock(service);
+	}
+}
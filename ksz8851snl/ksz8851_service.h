@@ -0,0 +1,97 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_service.h
+ * @description : 	This file provides threaded KSZ8851SNL driver service. INTRN isr only signals, driver task does spi work.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_SERVICE_H
+#define __KSZ8851_SERVICE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ksz8851.h"
+#include "ksz8851_os.h"
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	KSZ8851_t				*driver;
+	KSZ8851_OS_Callbacks_t	os;
+
+	KSZ8851_OS_Handle_t		lock;							// serializes all driver calls (driver task and senders)
+	KSZ8851_OS_Handle_t		irq_signal;						// given by INTRN isr, taken by driver task
+
+	volatile bool			running;						// driver task exits when it is cleared
+	volatile uint32_t		irq_count;						// number of INTRN signals
+	uint32_t				service_count;					// number of ksz8851_irq_handler calls
+	uint32_t				timeout_count;					// number of services started by KSZ_SERVICE_CONFIG_IRQ_TIMEOUT_MS
+
+}KSZ8851_Service_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Creates driver lock, interrupt semaphore and driver task. ksz8851_init must be called before, and INTRN
+* 		  interrupt must call ksz8851_service_isr. After this call the driver must be used only through service functions.
+* @param  service: address of KSZ8851_Service_t struct that defined by user.
+* @param  driver: initialized driver.
+* @param  os: OS port callbacks.
+* @retval KSZ_OK, or KSZ_ERROR if an OS object can't be created
+*/
+KSZ8851_Status_t ksz8851_service_init(KSZ8851_Service_t *service, KSZ8851_t *driver, KSZ8851_OS_Callbacks_t os);
+
+/**
+* @brief  Signals driver task. Must be called from INTRN falling edge interrupt, it doesn't touch spi.
+*/
+void ksz8851_service_isr(KSZ8851_Service_t *service);
+
+/**
+* @brief  Sends a frame. It can be called from several tasks at the same time.
+* @retval status of ksz8851_send_frame
+*/
+KSZ8851_Status_t ksz8851_service_send(KSZ8851_Service_t *service, uint8_t *txBuffer, uint16_t frame_length);
+
+/**
+* @brief  Puts a frame into a strict priority TX queue. It can be called from several tasks at the same time.
+* @retval status of ksz8851_tx_enqueue
+*/
+KSZ8851_Status_t ksz8851_service_enqueue(KSZ8851_Service_t *service, uint8_t priority, uint8_t *txBuffer, uint16_t frame_length);
+
+/**
+* @brief  Takes driver lock, so other driver functions can be called from application tasks between lock and unlock.
+*/
+void ksz8851_service_lock(KSZ8851_Service_t *service);
+
+/**
+* @brief  Gives driver lock.
+*/
+void ksz8851_service_unlock(KSZ8851_Service_t *service);
+
+/**
+* @brief  Stops driver task after its current service. OS objects belong to the port and aren't deleted.
+*/
+void ksz8851_service_stop(KSZ8851_Service_t *service);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_SERVICE_H */
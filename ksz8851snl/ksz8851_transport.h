@@ -0,0 +1,420 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_transport.h
+ * @description : 	This file provides register, fifo and reset access routines of KSZ8851SNL over a spi transport table. They are
+ * 					shared by C driver (ksz8851.c) and C++ Device template (ksz8851.hpp).
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_TRANSPORT_H
+#define __KSZ8851_TRANSPORT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "ksz8851.h"
+
+/* Structs -------------------------------------------------------------------*/
+
+/* Transport of one chip. Routines below get it as a const table with a context pointer, when the table is a constant object
+ * the compiler can resolve and inline its functions */
+typedef struct
+{
+	KSZ8851_Status_t  (*Transmit)(void *context, uint8_t *pTxBuffer, uint16_t dataLength);					// transmits data (simplex)
+	KSZ8851_Status_t  (*Receive)(void *context, uint8_t *pRxBuffer, uint16_t dataLength);						// receives data (simplex)
+	KSZ8851_Status_t  (*TransmitReceive)(void *context, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);	// transmits and receives (full duplex)
+	KSZ8851_Status_t  (*TransmitThenReceive)(void *context, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength, uint8_t *pRxBuffer, uint16_t rxLength);	// one chained transfer, can be NULL
+	KSZ8851_Status_t  (*TransmitThenTransmit)(void *context, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength, uint8_t paddingLength);			// one chained transfer, can be NULL
+	void  	 (*Begin)(void *context);																				// starts spi transaction (bus grant, chip select low)
+	void  	 (*End)(void *context);																					// ends spi transaction (chip select high, bus release)
+	void  	 (*ResetPin)(void *context, uint8_t pinStatus);														// drives RSTN pin, KSZ_GPIO_PIN_RESET or KSZ_GPIO_PIN_SET
+	void  	 (*DelayUs)(void *context, uint32_t delay_time);														// waits at least delay_time us
+
+}KSZ8851_Transport_t;
+
+/* Inline functions ----------------------------------------------------------*/
+
+/**
+* @brief  Transmits then receives into two buffers by separate transfers, for transports without chained transfer.
+* @param  transport, context
+* @param  pTxBuffer: command bytes
+* @param  txLength
+* @param  pRxHeader: first received bytes (e.g. fifo preamble)
+* @param  rxHeaderLength: can be 0
+* @param  pRxBuffer: rest of received bytes (e.g. frame data)
+* @param  rxLength: can be 0
+* @return result
+*/
+static inline KSZ8851_Status_t ksz8851_transport_split_receive(const KSZ8851_Transport_t *transport, void *context, uint8_t *pTxBuffer, uint16_t txLength,
+		uint8_t *pRxHeader, uint16_t rxHeaderLength, uint8_t *pRxBuffer, uint16_t rxLength)
+{
+	KSZ8851_Status_t result;
+
+	result = transport->Transmit(context, pTxBuffer, txLength);
+
+	if(rxHeaderLength != 0)
+	{
+		result |= transport->Receive(context, pRxHeader, rxHeaderLength);
+	}
+
+	if(rxLength != 0)
+	{
+		result |= transport->Receive(context, pRxBuffer, rxLength);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Transmits two buffers and dword padding by separate transfers, for transports without chained transfer.
+* @param  transport, context
+* @param  pHeader: command and header bytes
+* @param  headerLength
+* @param  pTxBuffer: data bytes
+* @param  dataLength
+* @param  paddingLength: 0 .. KSZ_DWORD_VALUE - 1 bytes sent after data, their content doesn't matter
+* @return result
+*/
+static inline KSZ8851_Status_t ksz8851_transport_split_transmit(const KSZ8851_Transport_t *transport, void *context, uint8_t *pHeader, uint16_t headerLength,
+		uint8_t *pTxBuffer, uint16_t dataLength, uint8_t paddingLength)
+{
+	uint8_t  paddingBuff[KSZ_DWORD_VALUE] = {0};
+	KSZ8851_Status_t result;
+
+	result = transport->Transmit(context, pHeader, headerLength);
+
+	if(dataLength != 0)
+	{
+		result |= transport->Transmit(context, pTxBuffer, dataLength);
+	}
+
+	if(paddingLength != 0)
+	{
+		result |= transport->Transmit(context, paddingBuff, paddingLength);
+	}
+
+	return result;
+}
+
+/**
+* @brief  Transmits then receives into two buffers inside one chip select period, as one chained transfer if transport has it.
+*/
+static inline KSZ8851_Status_t ksz8851_transport_transmit_then_receive(const KSZ8851_Transport_t *transport, void *context, uint8_t *pTxBuffer,
+		uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength, uint8_t *pRxBuffer, uint16_t rxLength)
+{
+	if(transport->TransmitThenReceive != NULL)
+	{
+		return transport->TransmitThenReceive(context, pTxBuffer, txLength, pRxHeader, rxHeaderLength, pRxBuffer, rxLength);
+	}
+
+	return ksz8851_transport_split_receive(transport, context, pTxBuffer, txLength, pRxHeader, rxHeaderLength, pRxBuffer, rxLength);
+}
+
+/**
+* @brief  Transmits two buffers and dword padding inside one chip select period, as one chained transfer if transport has it.
+*/
+static inline KSZ8851_Status_t ksz8851_transport_transmit_then_transmit(const KSZ8851_Transport_t *transport, void *context, uint8_t *pHeader,
+		uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength, uint8_t paddingLength)
+{
+	if(transport->TransmitThenTransmit != NULL)
+	{
+		return transport->TransmitThenTransmit(context, pHeader, headerLength, pTxBuffer, dataLength, paddingLength);
+	}
+
+	return ksz8851_transport_split_transmit(transport, context, pHeader, headerLength, pTxBuffer, dataLength, paddingLength);
+}
+
+/**
+* @brief  Reads internal I/O register in one spi transaction.
+* @param  transport, context
+* @param  registerAddr: address of internal register.
+* @param  registerValue
+* @return status of process
+*/
+static inline KSZ8851_Status_t ksz8851_transport_read_register(const KSZ8851_Transport_t *transport, void *context, KSZ8851_Registers_Addr_t registerAddr,
+		uint16_t *registerValue)
+{
+	uint8_t  cmdBuff[KSZ_REG_CMD_BUFF_SIZE] = {0};
+	uint8_t  dataBuff[KSZ_REG_DATA_BUFF_SIZE] = {0};
+	KSZ8851_Status_t result;
+
+	/* Copy the read register frame (cmd, byte enable and address bits) to buffer, it's resolved at compile time for constant addresses */
+	ksz8851_make_reg_cmd(cmdBuff, KSZ8851_READ_REG, registerAddr);
+
+	transport->Begin(context);
+	result = transport->TransmitReceive(context, cmdBuff, dataBuff, KSZ_REG_CMD_BUFF_SIZE);
+	transport->End(context);
+
+	/*Order data. While data is transferred in the MSB first mode in the SPI cycle, byte0 is the first byte to appear and the byte 3 is the last byte for the data phase.*/
+	*registerValue = (uint16_t)((dataBuff[KSZ_REG_BUFF_BYTE3] << KSZ_1BYTE_SHIFTING_VALUE) | dataBuff[KSZ_REG_BUFF_BYTE2]);
+
+	return result;
+}
+
+/**
+* @brief  Writes internal I/O register in one spi transaction. Value is written as it is, reserved bits are caller's job.
+* @param  transport, context
+* @param  registerAddr: address of internal register.
+* @param  registerValue
+* @return status of process
+*/
+static inline KSZ8851_Status_t ksz8851_transport_write_register(const KSZ8851_Transport_t *transport, void *context, KSZ8851_Registers_Addr_t registerAddr,
+		uint16_t registerValue)
+{
+	uint8_t  cmdBuff[KSZ_REG_CMD_BUFF_SIZE];
+	KSZ8851_Status_t result;
+
+	/* Copy the write register frame (cmd, byte enable and address bits) and data bytes to buffer */
+	ksz8851_make_reg_cmd(cmdBuff, KSZ8851_WRITE_REG, registerAddr);
+	cmdBuff[KSZ_REG_BUFF_BYTE2] = (uint8_t)(registerValue & KSZ_REG_CMD_BYTE1_MASK);									//fit LSB byte of data (16 bit) variable to one byte
+	cmdBuff[KSZ_REG_BUFF_BYTE3] = (uint8_t)((registerValue & KSZ_REG_CMD_BYTE0_MASK) >> KSZ_1BYTE_SHIFTING_VALUE);		//fit MSB byte of data (16 bit) variable to one byte
+
+	transport->Begin(context);
+	result = transport->Transmit(context, cmdBuff, KSZ_REG_CMD_BUFF_SIZE);
+	transport->End(context);
+
+	return result;
+}
+
+/**
+* @brief  Reads dword aligned register pair in one spi transaction by setting all 4 byte enable bits.
+* @param  transport, context
+* @param  registerAddr: dword aligned address of lower register of the pair.
+* @param  registerValue: bit 15-0 is the register on registerAddr, bit 31-16 is the register on registerAddr + 2.
+* @return status of process
+*/
+static inline KSZ8851_Status_t ksz8851_transport_read_register32(const KSZ8851_Transport_t *transport, void *context, KSZ8851_Registers_Addr_t registerAddr,
+		uint32_t *registerValue)
+{
+	uint8_t  cmdBuff[KSZ_REG32_CMD_BUFF_SIZE] = {0};
+	uint8_t  dataBuff[KSZ_REG32_CMD_BUFF_SIZE] = {0};
+	KSZ8851_Status_t result;
+
+	ksz8851_make_reg32_cmd(cmdBuff, KSZ8851_READ_REG, registerAddr);
+
+	transport->Begin(context);
+	result = transport->TransmitReceive(context, cmdBuff, dataBuff, KSZ_REG32_CMD_BUFF_SIZE);
+	transport->End(context);
+
+	/* Data bytes come in byte0..byte3 order of the dword after 2 bytes command */
+	*registerValue = ((uint32_t)dataBuff[KSZ_REG_BUFF_BYTE5] << (3 * KSZ_1BYTE_SHIFTING_VALUE)) |
+					 ((uint32_t)dataBuff[KSZ_REG_BUFF_BYTE4] << (2 * KSZ_1BYTE_SHIFTING_VALUE)) |
+					 ((uint32_t)dataBuff[KSZ_REG_BUFF_BYTE3] << KSZ_1BYTE_SHIFTING_VALUE) |
+					 (uint32_t)dataBuff[KSZ_REG_BUFF_BYTE2];
+
+	return result;
+}
+
+/**
+* @brief  Writes dword aligned register pair in one spi transaction by setting all 4 byte enable bits.
+* @param  transport, context
+* @param  registerAddr: dword aligned address of lower register of the pair.
+* @param  registerValue: bit 15-0 is written to registerAddr, bit 31-16 is written to registerAddr + 2.
+* @return status of process
+*/
+static inline KSZ8851_Status_t ksz8851_transport_write_register32(const KSZ8851_Transport_t *transport, void *context, KSZ8851_Registers_Addr_t registerAddr,
+		uint32_t registerValue)
+{
+	uint8_t  cmdBuff[KSZ_REG32_CMD_BUFF_SIZE];
+	KSZ8851_Status_t result;
+
+	/* Copy the write register pair frame and data bytes (byte0 first) to buffer */
+	ksz8851_make_reg32_cmd(cmdBuff, KSZ8851_WRITE_REG, registerAddr);
+	cmdBuff[KSZ_REG_BUFF_BYTE2] = (uint8_t)(registerValue);
+	cmdBuff[KSZ_REG_BUFF_BYTE3] = (uint8_t)(registerValue >> KSZ_1BYTE_SHIFTING_VALUE);
+	cmdBuff[KSZ_REG_BUFF_BYTE4] = (uint8_t)(registerValue >> (2 * KSZ_1BYTE_SHIFTING_VALUE));
+	cmdBuff[KSZ_REG_BUFF_BYTE5] = (uint8_t)(registerValue >> (3 * KSZ_1BYTE_SHIFTING_VALUE));
+
+	transport->Begin(context);
+	result = transport->Transmit(context, cmdBuff, KSZ_REG32_CMD_BUFF_SIZE);
+	transport->End(context);
+
+	return result;
+}
+
+/**
+* @brief  Sets or clears QMU DMA access bit of RXQCR by read-modify-write. RXQCR is volatile, so it is always read before writing.
+* @param  transport, context
+* @param  start: true starts DMA transfer (fifo read or write), false stops it
+* @return result
+*/
+static inline KSZ8851_Status_t ksz8851_transport_dma(const KSZ8851_Transport_t *transport, void *context, bool start)
+{
+	uint16_t tmpCurrentRegValue = 0;
+	KSZ8851_Status_t result;
+
+	result = ksz8851_transport_read_register(transport, context, KSZ_REG_ADDR_RXQCR0, &tmpCurrentRegValue);
+
+	if(start)
+	{
+		tmpCurrentRegValue |= KSZ_CONFIG_RX_CMD_START_DMA_ACCESS;
+	}
+	else
+	{
+		tmpCurrentRegValue &= (uint16_t)~KSZ_CONFIG_RX_CMD_START_DMA_ACCESS;
+	}
+
+	result |= ksz8851_transport_write_register(transport, context, KSZ_REG_ADDR_RXQCR0, tmpCurrentRegValue);
+
+	return result;
+}
+
+/**
+* @brief  Resets RX frame data pointer to the beginning of the present frame and starts QMU DMA transfer to host CPU.
+*/
+static inline KSZ8851_Status_t ksz8851_transport_rx_dma_start(const KSZ8851_Transport_t *transport, void *context)
+{
+	KSZ8851_Status_t result;
+
+	result = ksz8851_transport_write_register(transport, context, KSZ_REG_ADDR_RXFDPR0, KSZ_CONFIG_RX_FR_DPOINTER_AUTO_INC);
+	result |= ksz8851_transport_dma(transport, context, true);
+
+	return result;
+}
+
+/**
+* @brief  Reads part of RXQ fifo stream of present frame during DMA transfer. Stream position 0 is first dummy byte, frame data
+* 		  starts at KSZ_RX_FIFO_PREAMBLE_SIZE (ref: KSZ datasheet section 3.5.6). Stream is read in transactions of burst_length bytes.
+* @param  transport, context
+* @param  burst_length: bytes of one transaction, 0 reads the whole part in one transaction (single frame burst)
+* @param  pPreamble: KSZ_RX_FIFO_PREAMBLE_SIZE bytes for dummy bytes, frame status, byte count and IP header offset
+* @param  rxBuffer: frame data, first byte is frame byte 0
+* @param  from: first stream position, dword aligned
+* @param  to: stream position after last byte, dword aligned
+* @param  bursts: incremented for each transaction, can be NULL
+* @return result
+*/
+static inline KSZ8851_Status_t ksz8851_transport_read_fifo_stream(const KSZ8851_Transport_t *transport, void *context, uint16_t burst_length,
+		uint8_t *pPreamble, uint8_t *rxBuffer, uint16_t from, uint16_t to, uint32_t *bursts)
+{
+	uint8_t  cmdBuff[KSZ_FIFO_CMD_SIZE] = {KSZ_FIFO_CMD_READ};
+	uint16_t tmpBurstLength, tmpChunkLength, tmpPreamblePart;
+	uint8_t  *tmpPreamble, *tmpData;
+	KSZ8851_Status_t result = KSZ_OK;
+
+	tmpBurstLength = (burst_length == 0) ? (uint16_t)(to - from) : burst_length;
+
+	while(from < to)
+	{
+		tmpChunkLength = (uint16_t)(to - from);
+
+		if(tmpChunkLength > tmpBurstLength)
+		{
+			tmpChunkLength = tmpBurstLength;
+		}
+
+		/* A burst can cover the end of preamble and the beginning of frame data. Both parts are received in one chained transfer
+		 * with the read fifo command */
+		tmpPreamblePart = 0;
+		tmpPreamble = pPreamble;
+		tmpData = rxBuffer;
+
+		if(from < KSZ_RX_FIFO_PREAMBLE_SIZE)
+		{
+			tmpPreamblePart = (uint16_t)(KSZ_RX_FIFO_PREAMBLE_SIZE - from);
+			tmpPreamble = &pPreamble[from];
+
+			if(tmpPreamblePart > tmpChunkLength)
+			{
+				tmpPreamblePart = tmpChunkLength;
+			}
+		}
+		else
+		{
+			tmpData = &rxBuffer[from - KSZ_RX_FIFO_PREAMBLE_SIZE];
+		}
+
+		transport->Begin(context);
+		result |= ksz8851_transport_transmit_then_receive(transport, context, cmdBuff, KSZ_FIFO_CMD_SIZE, tmpPreamble, tmpPreamblePart, tmpData,
+				(uint16_t)(tmpChunkLength - tmpPreamblePart));
+		transport->End(context);
+
+		from += tmpChunkLength;
+
+		if(bursts != NULL)
+		{
+			(*bursts)++;
+		}
+	}
+
+	return result;
+}
+
+/**
+* @brief  Writes command, frame header and frame data to TXQ fifo in one transaction during DMA transfer. The data length written
+* 		  to KSZ must be DWORD aligned, padding is the tail of the same chained transfer.
+* @param  transport, context
+* @param  pHeader: write fifo command, frame header and optional frame bytes
+* @param  headerLength
+* @param  txBuffer: rest of frame
+* @param  dataLength
+* @param  frame_length: frame length without CRC, including frame bytes of header
+* @return result
+*/
+static inline KSZ8851_Status_t ksz8851_transport_write_fifo(const KSZ8851_Transport_t *transport, void *context, uint8_t *pHeader, uint16_t headerLength,
+		uint8_t *txBuffer, uint16_t dataLength, uint16_t frame_length)
+{
+	KSZ8851_Status_t result;
+
+	transport->Begin(context);
+	result = ksz8851_transport_transmit_then_transmit(transport, context, pHeader, headerLength, txBuffer, dataLength,
+			(uint8_t)(KSZ_DWORD_ALIGN(frame_length) - frame_length));
+	transport->End(context);
+
+	return result;
+}
+
+/**
+* @brief  Pulls RSTN low as long as datasheet requires and releases it. Recovery is waited by reading chip ID.
+*/
+static inline void ksz8851_transport_hard_reset(const KSZ8851_Transport_t *transport, void *context)
+{
+	/*Pull reset output of mcu LOW state. KSZ reset input is active low logic*/
+	transport->ResetPin(context, KSZ_GPIO_PIN_RESET);
+	transport->DelayUs(context, KSZ_TIME_HARD_RESET_PULSE_US);
+	transport->ResetPin(context, KSZ_GPIO_PIN_SET);
+}
+
+/**
+* @brief  Performs software reset by setting soft_reset_type bits of GRR, holding and clearing them.
+* @param  transport, context
+* @param  soft_reset_type: KSZ_CONFIG_GLOBAL_SOFT_RESET or KSZ_CONFIG_QMU_MODULE_SOFT_RESET
+* @return process status
+*/
+static inline KSZ8851_Status_t ksz8851_transport_soft_reset(const KSZ8851_Transport_t *transport, void *context, uint16_t soft_reset_type)
+{
+	uint16_t tmpCurrentRegValue = 0;
+	KSZ8851_Status_t result;
+
+	result = ksz8851_transport_read_register(transport, context, KSZ_REG_ADDR_GRR0, &tmpCurrentRegValue);
+
+	/* Set bits of global reset register according to soft_reset_type and than reset to terminate reset status */
+	result |= ksz8851_transport_write_register(transport, context, KSZ_REG_ADDR_GRR0, (uint16_t)(soft_reset_type | tmpCurrentRegValue));
+	transport->DelayUs(context, KSZ_TIME_SOFT_RESET_US);
+	result |= ksz8851_transport_write_register(transport, context, KSZ_REG_ADDR_GRR0, tmpCurrentRegValue);
+	transport->DelayUs(context, KSZ_TIME_SOFT_RESET_US);
+
+	return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_TRANSPORT_H */
@@ -0,0 +1,190 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_os_posix.c
+ * @description : 	This file provides POSIX (pthreads) port of KSZ8851SNL OS abstraction to run driver service on Linux hosts.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* clock_gettime, CLOCK_MONOTONIC and sem_timedwait aren't declared in strict ISO C modes without it */
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ksz8851_os_posix.h"
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	void (*entry)(void *arg);
+	void *arg;
+
+}KSZ8851_OS_Posix_Task_t;
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static KSZ8851_OS_Handle_t ksz8851_os_posix_mutex_create(void *user);
+static void ksz8851_os_posix_mutex_lock(void *user, KSZ8851_OS_Handle_t mutex);
+static void ksz8851_os_posix_mutex_unlock(void *user, KSZ8851_OS_Handle_t mutex);
+static KSZ8851_OS_Handle_t ksz8851_os_posix_sem_create(void *user);
+static void ksz8851_os_posix_sem_give(void *user, KSZ8851_OS_Handle_t sem);
+static bool ksz8851_os_posix_sem_take(void *user, KSZ8851_OS_Handle_t sem, uint32_t timeout_ms);
+static KSZ8851_Status_t ksz8851_os_posix_task_create(void *user, void (*entry)(void *arg), void *arg, const char *name,
+													 uint32_t stack_size, uint32_t priority);
+static void* ksz8851_os_posix_task_entry(void *arg);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Returns OS callbacks implemented with pthread mutex, POSIX semaphore and pthread. Tasks are created detached,
+* 		  stack size and priority arguments are ignored. INTRN "isr" can be a signal handler or a simulator thread.
+*/
+KSZ8851_OS_Callbacks_t ksz8851_os_posix_callbacks(void)
+{
+	KSZ8851_OS_Callbacks_t os;
+
+	os.MUTEX_Create		= ksz8851_os_posix_mutex_create;
+	os.MUTEX_Lock		= ksz8851_os_posix_mutex_lock;
+	os.MUTEX_Unlock		= ksz8851_os_posix_mutex_unlock;
+	os.SEM_Create		= ksz8851_os_posix_sem_create;
+	os.SEM_Give			= ksz8851_os_posix_sem_give;
+	os.SEM_GiveFromISR	= ksz8851_os_posix_sem_give;		// sem_post is async-signal-safe
+	os.SEM_Take			= ksz8851_os_posix_sem_take;
+	os.TASK_Create		= ksz8851_os_posix_task_create;
+	os.user				= NULL;
+
+	return os;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+static KSZ8851_OS_Handle_t ksz8851_os_posix_mutex_create(void *user)
+{
+	pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+
+	(void)user;
+
+	if(mutex != NULL && pthread_mutex_init(mutex, NULL) != 0)
+	{
+		free(mutex);
+		mutex = NULL;
+	}
+
+	return mutex;
+}
+
+static void ksz8851_os_posix_mutex_lock(void *user, KSZ8851_OS_Handle_t mutex)
+{
+	(void)user;
+	pthread_mutex_lock((pthread_mutex_t*)mutex);
+}
+
+static void ksz8851_os_posix_mutex_unlock(void *user, KSZ8851_OS_Handle_t mutex)
+{
+	(void)user;
+	pthread_mutex_unlock((pthread_mutex_t*)mutex);
+}
+
+static KSZ8851_OS_Handle_t ksz8851_os_posix_sem_create(void *user)
+{
+	sem_t *sem = malloc(sizeof(sem_t));
+
+	(void)user;
+
+	if(sem != NULL && sem_init(sem, 0, 0) != 0)
+	{
+		free(sem);
+		sem = NULL;
+	}
+
+	return sem;
+}
+
+static void ksz8851_os_posix_sem_give(void *user, KSZ8851_OS_Handle_t sem)
+{
+	(void)user;
+	sem_post((sem_t*)sem);
+}
+
+static bool ksz8851_os_posix_sem_take(void *user, KSZ8851_OS_Handle_t sem, uint32_t timeout_ms)
+{
+	struct timespec deadline;
+	int ret;
+
+	(void)user;
+
+	if(timeout_ms == KSZ_OS_WAIT_FOREVER)
+	{
+		while((ret = sem_wait((sem_t*)sem)) != 0 && errno == EINTR);
+		return ret == 0;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec  += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+
+	if(deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	while((ret = sem_timedwait((sem_t*)sem, &deadline)) != 0 && errno == EINTR);
+
+	return ret == 0;
+}
+
+static KSZ8851_Status_t ksz8851_os_posix_task_create(void *user, void (*entry)(void *arg), void *arg, const char *name,
+													 uint32_t stack_size, uint32_t priority)
+{
+	pthread_t thread;
+	KSZ8851_OS_Posix_Task_t *task = malloc(sizeof(KSZ8851_OS_Posix_Task_t));
+
+	(void)user;
+	(void)name;
+	(void)stack_size;
+	(void)priority;
+
+	if(task == NULL)
+	{
+		return KSZ_ERROR;
+	}
+
+	task->entry	= entry;
+	task->arg	= arg;
+
+	if(pthread_create(&thread, NULL, ksz8851_os_posix_task_entry, task) != 0)
+	{
+		free(task);
+		return KSZ_ERROR;
+	}
+
+	pthread_detach(thread);
+
+	return KSZ_OK;
+}
+
+static void* ksz8851_os_posix_task_entry(void *arg)
+{
+	KSZ8851_OS_Posix_Task_t task = *(KSZ8851_OS_Posix_Task_t*)arg;
+
+	free(arg);
+	task.entry(task.arg);
+
+	return NULL;
+}
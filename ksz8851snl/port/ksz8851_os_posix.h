@@ -0,0 +1,43 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_os_posix.h
+ * @description : 	This file provides POSIX (pthreads) port of KSZ8851SNL OS abstraction to run driver service on Linux hosts.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_OS_POSIX_H
+#define __KSZ8851_OS_POSIX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "../ksz8851_os.h"
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Returns OS callbacks implemented with pthread mutex, POSIX semaphore and pthread. Tasks are created detached,
+* 		  stack size and priority arguments are ignored. INTRN "isr" can be a signal handler or a simulator thread.
+*/
+KSZ8851_OS_Callbacks_t ksz8851_os_posix_callbacks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_OS_POSIX_H */
@@ -0,0 +1,1040 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_sim_posix.c
+ * @description : 	This file provides threaded KSZ8851SNL chip simulator to run the driver against on Linux hosts.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* clock_gettime and CLOCK_MONOTONIC aren't declared in strict ISO C modes without it */
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ------------------------------------------------------------------*/
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include "ksz8851_sim_posix.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_SIM_US_PER_SEC										1000000UL
+#define KSZ_SIM_NS_PER_US										1000L
+#define KSZ_SIM_NS_PER_SEC										1000000000L
+#define KSZ_SIM_RXQ_FRAME_SIZE(byte_count)						(KSZ_DWORD_ALIGN(byte_count) + KSZ_DWORD_VALUE)	//RXQ memory taken by a frame and its header
+#define KSZ_SIM_TXQ_FRAME_SIZE(length)							(KSZ_DWORD_ALIGN(length) + KSZ_DWORD_VALUE)	//TXQ memory taken by a frame and its control words
+#define KSZ_SIM_CRC_SIZE										4
+#define KSZ_SIM_FIFO_OPCODE_SHIFT								6			//bit 7-6 of first command byte
+#define KSZ_SIM_RX_FDP_MASK										0x07FF		//RXFDPR frame data pointer
+
+/* Enums ---------------------------------------------------------------------*/
+
+typedef enum
+{
+	KSZ_SIM_PHASE_IDLE = 0,			// chip select is high
+	KSZ_SIM_PHASE_CMD,				// waiting first command byte
+	KSZ_SIM_PHASE_REG_CMD,			// waiting second byte of register command
+	KSZ_SIM_PHASE_REG_DATA,			// register data bytes
+	KSZ_SIM_PHASE_FIFO_READ,		// RXQ stream bytes
+	KSZ_SIM_PHASE_FIFO_WRITE		// TXQ control word, byte count and frame bytes
+
+}KSZ8851_Sim_Phase_t;
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static uint32_t ksz8851_sim_now_us(void);
+static void* ksz8851_sim_thread(void *arg);
+static void ksz8851_sim_reset(KSZ8851_Sim_t *sim);
+static void ksz8851_sim_update_intrn(KSZ8851_Sim_t *sim, uint32_t now);
+static void ksz8851_sim_generate(KSZ8851_Sim_t *sim, uint32_t now);
+static void ksz8851_sim_rx_frame(KSZ8851_Sim_t *sim);
+static void ksz8851_sim_rx_dequeue(KSZ8851_Sim_t *sim);
+static void ksz8851_sim_transmit(KSZ8851_Sim_t *sim, uint32_t now);
+static void ksz8851_sim_tx_enqueue(KSZ8851_Sim_t *sim, uint32_t now);
+static void ksz8851_sim_tx_space(KSZ8851_Sim_t *sim);
+static uint16_t ksz8851_sim_read16(KSZ8851_Sim_t *sim, uint8_t addr);
+static void ksz8851_sim_write16(KSZ8851_Sim_t *sim, uint8_t addr, uint16_t value);
+static int8_t ksz8851_sim_enabled_byte(uint8_t byte_enables, uint8_t n);
+static uint8_t ksz8851_sim_spi_byte(KSZ8851_Sim_t *sim, uint8_t tx);
+static void ksz8851_sim_spi_end(KSZ8851_Sim_t *sim);
+static void ksz8851_sim_spi_transfer(KSZ8851_Sim_t *sim, const uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_sim_spi_transmit(void *user, uint8_t *pTxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_sim_spi_receive(void *user, uint8_t *pRxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_receive(void *user, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength);
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_then_receive(void *user, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength,
+		uint8_t *pRxBuffer, uint16_t rxLength);
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_then_transmit(void *user, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength,
+		uint8_t paddingLength);
+static void ksz8851_sim_gpio_control(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus);
+static uint32_t ksz8851_sim_get_tick(void *user);
+static uint32_t ksz8851_sim_get_tick_us(void *user);
+static void ksz8851_sim_yield(void *user);
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Resets simulated chip and starts simulator thread. Thread generates RX frames at config->rx_rate_fps in real time, transmits
+* 		  enqueued TX frames at wire rate and calls INTRN_Falling while (ISR & IER) goes non-zero, so the driver "isr" preempts
+* 		  application thread like on target. Driver must control chip select (KSZ8851_Interface_t) to frame SPI transactions.
+* @param  sim
+* @param  config: copied into sim
+* @return KSZ_OK, KSZ_ERROR if thread can't be created
+*/
+KSZ8851_Status_t ksz8851_sim_posix_start(KSZ8851_Sim_t *sim, const KSZ8851_Sim_Config_t *config)
+{
+	pthread_condattr_t condAttr;
+
+	memset(sim, 0, sizeof(KSZ8851_Sim_t));
+	sim->config = *config;
+
+	if(sim->config.rx_frame_length < KSZ_SIM_MIN_RX_FRAME_SIZE)
+	{
+		sim->config.rx_frame_length = KSZ_SIM_MIN_RX_FRAME_SIZE;
+	}
+	else if(sim->config.rx_frame_length > KSZ_ETH_MAX_FRAME_SIZE)
+	{
+		sim->config.rx_frame_length = KSZ_ETH_MAX_FRAME_SIZE;
+	}
+
+	if(sim->config.link_rate_Mbps == 0)
+	{
+		sim->config.link_rate_Mbps = KSZ_SIM_LINK_MBPS;
+	}
+
+	if(sim->config.tick_us == 0)
+	{
+		sim->config.tick_us = KSZ_SIM_TICK_US;
+	}
+
+	ksz8851_sim_reset(sim);
+
+	/* Thread sleeps on monotonic clock, frame arrival times are monotonic too */
+	pthread_condattr_init(&condAttr);
+	pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sim->wakeup, &condAttr);
+	pthread_condattr_destroy(&condAttr);
+	pthread_mutex_init(&sim->lock, NULL);
+
+	sim->running = true;
+	sim->rx_next_us = ksz8851_sim_now_us();
+
+	if(pthread_create(&sim->thread, NULL, ksz8851_sim_thread, sim) != 0)
+	{
+		sim->running = false;
+		pthread_mutex_destroy(&sim->lock);
+		pthread_cond_destroy(&sim->wakeup);
+		return KSZ_ERROR;
+	}
+
+	return KSZ_OK;
+}
+
+/**
+* @brief  Stops simulator thread, INTRN_Falling isn't called after it returns.
+* @param  sim
+*/
+void ksz8851_sim_posix_stop(KSZ8851_Sim_t *sim)
+{
+	pthread_mutex_lock(&sim->lock);
+	sim->running = false;
+	pthread_cond_signal(&sim->wakeup);
+	pthread_mutex_unlock(&sim->lock);
+
+	pthread_join(sim->thread, NULL);
+
+	pthread_mutex_destroy(&sim->lock);
+	pthread_cond_destroy(&sim->wakeup);
+}
+
+/**
+* @brief  Fills SPI, GPIO and TIME callbacks of driver with the simulator and sets functions->user to sim. Other callbacks are left
+* 		  untouched, they get the simulator as user too, application context is given by ksz8851_sim_posix_app.
+* @param  sim
+* @param  functions: callbacks of KSZ8851_Config_t
+*/
+void ksz8851_sim_posix_callbacks(KSZ8851_Sim_t *sim, KSZ8851_Callbacks_t *functions)
+{
+	functions->TIME_GetTick				= ksz8851_sim_get_tick;
+	functions->SPI_TransmitData			= ksz8851_sim_spi_transmit;
+	functions->SPI_ReceiveData			= ksz8851_sim_spi_receive;
+	functions->SPI_TransmitReceiveData	= ksz8851_sim_spi_transmit_receive;
+	functions->GPIO_Control				= ksz8851_sim_gpio_control;
+	functions->TIME_GetTickUs			= ksz8851_sim_get_tick_us;
+	functions->TIME_Yield				= ksz8851_sim_yield;
+	functions->TIME_Timestamp			= ksz8851_sim_get_tick_us;
+	functions->SPI_TransmitThenReceive	= ksz8851_sim_spi_transmit_then_receive;
+	functions->SPI_TransmitThenTransmit	= ksz8851_sim_spi_transmit_then_transmit;
+	functions->user						= sim;
+}
+
+/**
+* @brief  Returns config->app of the simulator given to driver callbacks as user.
+* @param  user
+* @retval application context
+*/
+void* ksz8851_sim_posix_app(void *user)
+{
+	return ((KSZ8851_Sim_t*)user)->config.app;
+}
+
+/**
+* @brief  Changes frames per second of generated RX traffic, e.g. to find throughput limit of the driver.
+* @param  sim
+* @param  rx_rate_fps
+*/
+void ksz8851_sim_posix_set_rx_rate(KSZ8851_Sim_t *sim, uint32_t rx_rate_fps)
+{
+	pthread_mutex_lock(&sim->lock);
+
+	/* New rate starts from now, frames of old rate aren't generated in a burst */
+	if(sim->config.rx_rate_fps == 0)
+	{
+		sim->rx_next_us = ksz8851_sim_now_us();
+		sim->rx_next_fraction = 0;
+	}
+
+	sim->config.rx_rate_fps = rx_rate_fps;
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/**
+* @brief  Changes wire rate of transmitted frames, e.g. to make the wire and not the spi bus the TX limit of an instance.
+* @param  sim
+* @param  link_rate_Mbps: 0 is KSZ_SIM_LINK_MBPS
+*/
+void ksz8851_sim_posix_set_link_rate(KSZ8851_Sim_t *sim, uint32_t link_rate_Mbps)
+{
+	pthread_mutex_lock(&sim->lock);
+
+	/* Frames already on the wire keep their done time */
+	sim->config.link_rate_Mbps = (link_rate_Mbps == 0) ? KSZ_SIM_LINK_MBPS : link_rate_Mbps;
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/**
+* @brief  Copies simulator statistics. Non-zero cs_overlaps, spi_foreign, dma_register_access, fifo_without_dma or fifo_overreads
+* 		  counters are races between interrupt and application context, rx_overruns and intrn_low_max_us show throughput losses.
+* @param  sim
+* @param  statistics
+*/
+void ksz8851_sim_posix_statistics(KSZ8851_Sim_t *sim, KSZ8851_Sim_Statistics_t *statistics)
+{
+	pthread_mutex_lock(&sim->lock);
+	*statistics = sim->Statistics;
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t ksz8851_sim_now_us(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)((uint64_t)now.tv_sec * KSZ_SIM_US_PER_SEC + (uint64_t)(now.tv_nsec / KSZ_SIM_NS_PER_US));
+}
+
+/**
+ * @brief  Simulator thread. Plays the wire side of the chip and the INTRN line, INTRN_Falling runs without simulator lock
+ * 		   so driver "isr" can access the chip like an interrupt preempting the application.
+ * @param  arg: simulator
+ */
+static void* ksz8851_sim_thread(void *arg)
+{
+	KSZ8851_Sim_t *sim = (KSZ8851_Sim_t*)arg;
+	struct timespec deadline;
+	uint32_t now;
+
+	pthread_mutex_lock(&sim->lock);
+
+	while(sim->running)
+	{
+		now = ksz8851_sim_now_us();
+
+		ksz8851_sim_generate(sim, now);
+		ksz8851_sim_transmit(sim, now);
+		ksz8851_sim_update_intrn(sim, now);
+
+		/* An assertion that is never served is a hang, it is measured while it lasts */
+		if(sim->intrn_low && (now - sim->intrn_low_us) > sim->Statistics.intrn_low_max_us)
+		{
+			sim->Statistics.intrn_low_max_us = now - sim->intrn_low_us;
+		}
+
+		if(sim->intrn_edge)
+		{
+			sim->intrn_edge = false;
+
+			if(sim->config.INTRN_Falling != NULL)
+			{
+				pthread_mutex_unlock(&sim->lock);
+				sim->config.INTRN_Falling(sim->config.intrn_arg);
+				pthread_mutex_lock(&sim->lock);
+			}
+
+			continue;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_nsec += (long)sim->config.tick_us * KSZ_SIM_NS_PER_US;
+
+		while(deadline.tv_nsec >= KSZ_SIM_NS_PER_SEC)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= KSZ_SIM_NS_PER_SEC;
+		}
+
+		/* Register writes re-raising INTRN wake the thread before the tick ends */
+		if(!sim->intrn_edge && sim->running)
+		{
+			pthread_cond_timedwait(&sim->wakeup, &sim->lock, &deadline);
+		}
+	}
+
+	pthread_mutex_unlock(&sim->lock);
+
+	return NULL;
+}
+
+/**
+ * @brief  Hard / soft reset. Registers get reset values, queues are emptied. Statistics and spi transaction state are kept.
+ * @param  sim
+ */
+static void ksz8851_sim_reset(KSZ8851_Sim_t *sim)
+{
+	memset(sim->regs, 0, sizeof(sim->regs));
+
+	sim->isr			= 0;
+	sim->ier			= 0;
+	sim->txsr			= 0;
+	sim->dma			= false;
+	sim->fifo_pos		= 0;
+	sim->rxq_head		= 0;
+	sim->rxq_count		= 0;
+	sim->rxq_bytes		= 0;
+	sim->txq_head		= 0;
+	sim->txq_count		= 0;
+	sim->txq_enqueued	= 0;
+	sim->txq_bytes		= 0;
+}
+
+/**
+ * @brief  INTRN is low while any enabled interrupt is pending. Falling edge wakes simulator thread to report it.
+ * @param  sim
+ * @param  now: us
+ */
+static void ksz8851_sim_update_intrn(KSZ8851_Sim_t *sim, uint32_t now)
+{
+	bool tmpLow = (sim->isr & sim->ier) != 0;
+
+	if(tmpLow && !sim->intrn_low)
+	{
+		sim->intrn_low		= true;
+		sim->intrn_low_us	= now;
+		sim->intrn_edge		= true;
+		sim->Statistics.interrupts++;
+		pthread_cond_signal(&sim->wakeup);
+	}
+	else if(!tmpLow && sim->intrn_low)
+	{
+		sim->intrn_low = false;
+
+		if((now - sim->intrn_low_us) > sim->Statistics.intrn_low_max_us)
+		{
+			sim->Statistics.intrn_low_max_us = now - sim->intrn_low_us;
+		}
+	}
+}
+
+/**
+ * @brief  Generates frames due until now. A thread delayed by the host catches up, so arrivals keep real time rate.
+ * @param  sim
+ * @param  now: us
+ */
+static void ksz8851_sim_generate(KSZ8851_Sim_t *sim, uint32_t now)
+{
+	uint32_t tmpPeriod, tmpRemainder;
+
+	if(sim->config.rx_rate_fps == 0)
+	{
+		return;
+	}
+
+	/* Remainder of the period is accumulated, so generated rate is exact when period isn't a whole us */
+	tmpPeriod = KSZ_SIM_US_PER_SEC / sim->config.rx_rate_fps;
+	tmpRemainder = KSZ_SIM_US_PER_SEC % sim->config.rx_rate_fps;
+
+	while((int32_t)(now - sim->rx_next_us) >= 0)
+	{
+		sim->rx_next_us += tmpPeriod;
+		sim->rx_next_fraction += tmpRemainder;
+
+		if(sim->rx_next_fraction >= sim->config.rx_rate_fps)
+		{
+			sim->rx_next_fraction -= sim->config.rx_rate_fps;
+			sim->rx_next_us++;
+		}
+
+		ksz8851_sim_rx_frame(sim);
+	}
+}
+
+/**
+ * @brief  A frame arrives from wire. It is put into RXQ or dropped with RX overrun interrupt if RXQ is full.
+ * @param  sim
+ */
+static void ksz8851_sim_rx_frame(KSZ8851_Sim_t *sim)
+{
+	static const uint8_t srcMAC[KSZ_MAC_ADDRR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x88, 0x51};
+	KSZ8851_Sim_Frame_t *frame;
+	uint16_t tmpSize = KSZ_SIM_RXQ_FRAME_SIZE(sim->config.rx_frame_length + KSZ_SIM_CRC_SIZE);
+	uint16_t i;
+
+	sim->Statistics.rx_generated++;
+
+	if(sim->rxq_count == KSZ_SIM_RXQ_SLOTS || sim->rxq_bytes + tmpSize > KSZ_SIM_RXQ_SIZE)
+	{
+		sim->Statistics.rx_overruns++;
+		sim->isr |= KSZ_FLAGS_INTERRUPTS_RX_OVERRUN;
+		return;
+	}
+
+	frame = &sim->rxq[(sim->rxq_head + sim->rxq_count) % KSZ_SIM_RXQ_SLOTS];
+	frame->length = sim->config.rx_frame_length;
+	frame->status = KSZ_STATUS_RX_FRAME_VALID;
+
+	memcpy(&frame->data[0], sim->config.MAC_address, KSZ_MAC_ADDRR_LEN);
+	memcpy(&frame->data[KSZ_MAC_ADDRR_LEN], srcMAC, KSZ_MAC_ADDRR_LEN);
+	frame->data[KSZ_ETH_TYPE_OFFSET]		= (uint8_t)(KSZ_SIM_ETHERTYPE >> KSZ_1BYTE_SHIFTING_VALUE);
+	frame->data[KSZ_ETH_TYPE_OFFSET + 1]	= (uint8_t)KSZ_SIM_ETHERTYPE;
+	frame->data[KSZ_SIM_SEQUENCE_OFFSET]	= (uint8_t)(sim->rx_sequence >> (3 * KSZ_1BYTE_SHIFTING_VALUE));
+	frame->data[KSZ_SIM_SEQUENCE_OFFSET + 1]= (uint8_t)(sim->rx_sequence >> (2 * KSZ_1BYTE_SHIFTING_VALUE));
+	frame->data[KSZ_SIM_SEQUENCE_OFFSET + 2]= (uint8_t)(sim->rx_sequence >> KSZ_1BYTE_SHIFTING_VALUE);
+	frame->data[KSZ_SIM_SEQUENCE_OFFSET + 3]= (uint8_t)sim->rx_sequence;
+
+	for(i = KSZ_SIM_SEQUENCE_OFFSET + 4; i < frame->length; i++)
+	{
+		frame->data[i] = (uint8_t)i;
+	}
+
+	sim->rx_sequence++;
+	sim->rxq_count++;
+	sim->rxq_bytes += tmpSize;
+	sim->isr |= KSZ_FLAGS_INTERRUPTS_RX;
+}
+
+/**
+ * @brief  Removes present frame from RXQ, next frame's stream starts from position 0.
+ * @param  sim
+ */
+static void ksz8851_sim_rx_dequeue(KSZ8851_Sim_t *sim)
+{
+	if(sim->rxq_count == 0)
+	{
+		return;
+	}
+
+	sim->rxq_bytes -= KSZ_SIM_RXQ_FRAME_SIZE(sim->rxq[sim->rxq_head].length + KSZ_SIM_CRC_SIZE);
+	sim->rxq_head = (sim->rxq_head + 1) % KSZ_SIM_RXQ_SLOTS;
+	sim->rxq_count--;
+	sim->fifo_pos = 0;
+}
+
+/**
+ * @brief  Completes enqueued frames whose wire time is over. TXSR gets frame ID of the last one, TX interrupt is raised for
+ * 		   frames written with KSZ_TX_CTRL_INT_ON_COMPLETION.
+ * @param  sim
+ * @param  now: us
+ */
+static void ksz8851_sim_transmit(KSZ8851_Sim_t *sim, uint32_t now)
+{
+	KSZ8851_Sim_Frame_t *frame;
+
+	while(sim->txq_enqueued != 0)
+	{
+		frame = &sim->txq[sim->txq_head];
+
+		if((int32_t)(now - frame->done_us) < 0)
+		{
+			break;
+		}
+
+		sim->txsr = frame->status & KSZ_TX_CTRL_FRAME_ID_MASK;
+
+		if(frame->status & KSZ_TX_CTRL_INT_ON_COMPLETION)
+		{
+			sim->isr |= KSZ_FLAGS_INTERRUPTS_TX;
+		}
+
+		sim->Statistics.tx_frames++;
+		sim->Statistics.tx_bytes += frame->length;
+		sim->txq_bytes -= KSZ_SIM_TXQ_FRAME_SIZE(frame->length);
+		sim->txq_head = (sim->txq_head + 1) % KSZ_SIM_TXQ_SLOTS;
+		sim->txq_count--;
+		sim->txq_enqueued--;
+	}
+
+	ksz8851_sim_tx_space(sim);
+}
+
+/**
+ * @brief  Manual enqueue. Written frames are queued for wire one after the other.
+ * @param  sim
+ * @param  now: us
+ */
+static void ksz8851_sim_tx_enqueue(KSZ8851_Sim_t *sim, uint32_t now)
+{
+	KSZ8851_Sim_Frame_t *frame;
+
+	if(sim->txq_enqueued == 0 || (int32_t)(now - sim->tx_wire_us) > 0)
+	{
+		sim->tx_wire_us = now;
+	}
+
+	while(sim->txq_enqueued < sim->txq_count)
+	{
+		frame = &sim->txq[(sim->txq_head + sim->txq_enqueued) % KSZ_SIM_TXQ_SLOTS];
+
+		sim->tx_wire_us += ((uint32_t)(frame->length + KSZ_SIM_WIRE_OVERHEAD) * 8) / sim->config.link_rate_Mbps;
+		frame->done_us = sim->tx_wire_us;
+		sim->txq_enqueued++;
+	}
+}
+
+/**
+ * @brief  TXQ memory available monitor. Raises interrupt once free memory reaches TXNTFSR, monitor bit clears itself.
+ * @param  sim
+ */
+static void ksz8851_sim_tx_space(KSZ8851_Sim_t *sim)
+{
+	uint16_t *txqcr = &sim->regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_TXQCR0)];
+
+	if((*txqcr & KSZ_CONFIG_TXQ_MEMORY_AVAILABLE_MONITOR) &&
+	   (KSZ_SIM_TXQ_SIZE - sim->txq_bytes) >= sim->regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_TXNTFSR0)])
+	{
+		*txqcr &= (uint16_t)~KSZ_CONFIG_TXQ_MEMORY_AVAILABLE_MONITOR;
+		sim->isr |= KSZ_FLAGS_INTERRUPTS_TX_SPACE_AVAILABLE;
+	}
+}
+
+/**
+ * @brief  Register read. Status registers are derived from simulator state, others return last written value.
+ * @param  sim
+ * @param  addr: even register address
+ * @retval register value
+ */
+static uint16_t ksz8851_sim_read16(KSZ8851_Sim_t *sim, uint8_t addr)
+{
+	KSZ8851_Sim_Frame_t *frame = &sim->rxq[sim->rxq_head];
+
+	switch(addr)
+	{
+		case KSZ_REG_ADDR_ISR0:
+			return sim->isr;
+
+		case KSZ_REG_ADDR_IER0:
+			return sim->ier;
+
+		case KSZ_REG_ADDR_TXSR0:
+			return sim->txsr;
+
+		case KSZ_REG_ADDR_TXMIR0:
+			return (uint16_t)(KSZ_SIM_TXQ_SIZE - sim->txq_bytes);
+
+		case KSZ_REG_ADDR_RXFHSR0:
+			return (sim->rxq_count != 0) ? frame->status : 0;
+
+		case KSZ_REG_ADDR_RXFHBCR0:
+			return (sim->rxq_count != 0) ? (uint16_t)(frame->length + KSZ_SIM_CRC_SIZE) : 0;
+
+		case KSZ_REG_ADDR_RXFCTR0:
+			return (uint16_t)(((uint16_t)sim->rxq_count << KSZ_RXFCTR_FRAME_COUNT_SHIFT) |
+							  (sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] & KSZ_REG_CMD_BYTE1_MASK));
+
+		case KSZ_REG_ADDR_CIDER0:
+			return KSZ_SIM_CHIP_ID;
+
+		case KSZ_REG_ADDR_P1SR0:
+			return KSZ_P1SR_LINK_GOOD_MASK;
+
+		case KSZ_REG_ADDR_P1MBSR0:
+			return KSZ_P1MBSR_LINK_MASK | KSZ_P1MBSR_AN_COMPLETE_MASK;
+
+		default:
+			return sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)];
+	}
+}
+
+/**
+ * @brief  Register write with the side effects of QMU command, interrupt and reset registers.
+ * @param  sim
+ * @param  addr: even register address
+ * @param  value
+ */
+static void ksz8851_sim_write16(KSZ8851_Sim_t *sim, uint8_t addr, uint16_t value)
+{
+	switch(addr)
+	{
+		case KSZ_REG_ADDR_ISR0:
+			sim->isr &= (uint16_t)~value;					// write 1 to clear
+			break;
+
+		case KSZ_REG_ADDR_IER0:
+			sim->ier = value;
+			break;
+
+		case KSZ_REG_ADDR_GRR0:
+			if(value & KSZ_CONFIG_GLOBAL_SOFT_RESET)
+			{
+				ksz8851_sim_reset(sim);
+			}
+			sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] = value;
+			break;
+
+		case KSZ_REG_ADDR_RXFDPR0:
+			if(value & KSZ_CONFIG_RX_FR_DPOINTER_AUTO_INC)
+			{
+				sim->fifo_pos = value & KSZ_SIM_RX_FDP_MASK;
+			}
+			sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] = value;
+			break;
+
+		case KSZ_REG_ADDR_RXQCR0:
+			if((value & KSZ_CONFIG_RX_CMD_START_DMA_ACCESS) == 0 && sim->dma)
+			{
+				/* Frame read completely is dequeued when DMA stops */
+				if(sim->rxq_count != 0 &&
+				   sim->fifo_pos >= KSZ_RX_FIFO_PREAMBLE_SIZE + sim->rxq[sim->rxq_head].length + KSZ_SIM_CRC_SIZE)
+				{
+					sim->Statistics.rx_delivered++;
+					ksz8851_sim_rx_dequeue(sim);
+				}
+			}
+
+			if(value & KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR)
+			{
+				if(sim->rxq_count != 0)
+				{
+					sim->Statistics.rx_released++;
+				}
+
+				ksz8851_sim_rx_dequeue(sim);
+			}
+
+			sim->dma = (value & KSZ_CONFIG_RX_CMD_START_DMA_ACCESS) != 0;
+			sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] = value & (uint16_t)~KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR;	// self clearing
+			break;
+
+		case KSZ_REG_ADDR_TXQCR0:
+			sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] = value & (uint16_t)~KSZ_CONFIG_TXQ_MANUAL_ENQUEUE;		// self clearing
+
+			if(value & KSZ_CONFIG_TXQ_MANUAL_ENQUEUE)
+			{
+				ksz8851_sim_tx_enqueue(sim, ksz8851_sim_now_us());
+			}
+
+			ksz8851_sim_tx_space(sim);
+			break;
+
+		default:
+			sim->regs[KSZ_REG_DESCRIPTOR_INDEX(addr)] = value;
+			break;
+	}
+}
+
+/**
+ * @brief  Returns index of n th enabled byte of the dword, data phase carries enabled bytes only in byte0..byte3 order.
+ * @param  byte_enables: bit 13-10 of register command
+ * @param  n
+ * @retval byte index, -1 if less than n + 1 bytes are enabled
+ */
+static int8_t ksz8851_sim_enabled_byte(uint8_t byte_enables, uint8_t n)
+{
+	int8_t i;
+
+	for(i = 0; i < KSZ_DWORD_VALUE; i++)
+	{
+		if((byte_enables & (1 << i)) && n-- == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  One SPI byte of current transaction, MSB first on the wire. Returns the byte chip drives on MISO.
+ * @param  sim
+ * @param  tx: byte on MOSI
+ * @retval byte on MISO
+ */
+static uint8_t ksz8851_sim_spi_byte(KSZ8851_Sim_t *sim, uint8_t tx)
+{
+	KSZ8851_Sim_Frame_t *frame = &sim->rxq[sim->rxq_head];
+	uint16_t tmpFrame, tmpPos, tmpByteCount;
+	int8_t tmpIndex;
+
+	switch(sim->phase)
+	{
+		case KSZ_SIM_PHASE_CMD:
+			sim->cmd = tx;
+
+			switch(tx >> KSZ_SIM_FIFO_OPCODE_SHIFT)
+			{
+				case KSZ8851_READ_RX_FIFO:
+					sim->fifo_fault = false;
+					sim->phase = KSZ_SIM_PHASE_FIFO_READ;
+					break;
+
+				case KSZ8851_WRITE_TX_FIFO:
+					sim->tx_pos = 0;
+					sim->phase = KSZ_SIM_PHASE_FIFO_WRITE;
+					break;
+
+				default:
+					sim->phase = KSZ_SIM_PHASE_REG_CMD;
+					return 0;
+			}
+
+			if(!sim->dma)
+			{
+				sim->Statistics.fifo_without_dma++;
+			}
+			return 0;
+
+		case KSZ_SIM_PHASE_REG_CMD:
+			tmpFrame = (uint16_t)((sim->cmd << KSZ_1BYTE_SHIFTING_VALUE) | tx);
+			sim->byte_enables = (uint8_t)((tmpFrame >> KSZ_REG_BYTES_SELECT_BIT_SHIFT_VALUE) & KSZ_REG_BYTES_SELECT_ALL_MASK_VALUE);
+			sim->dword_addr = (uint8_t)((tmpFrame & KSZ_REG_ADDR_MASK_VALUE) >> KSZ_REG_ADDR_BIT_SHIFT_VALUE);
+			sim->data_index = 0;
+			sim->write_mask = 0;
+			sim->phase = KSZ_SIM_PHASE_REG_DATA;
+
+			/* Only RXQCR may be accessed during DMA, it is how the session is stopped */
+			tmpIndex = ksz8851_sim_enabled_byte(sim->byte_enables, 0);
+
+			if(sim->dma && (tmpIndex < 0 || ((sim->dword_addr + tmpIndex) & ~1) != KSZ_REG_ADDR_RXQCR0))
+			{
+				sim->Statistics.dma_register_access++;
+			}
+
+			/* Read data is latched when address is complete */
+			if((sim->cmd >> KSZ_SIM_FIFO_OPCODE_SHIFT) == KSZ8851_READ_REG)
+			{
+				tmpFrame = ksz8851_sim_read16(sim, sim->dword_addr);
+				sim->data[KSZ_REG_BUFF_BYTE0] = (uint8_t)tmpFrame;
+				sim->data[KSZ_REG_BUFF_BYTE1] = (uint8_t)(tmpFrame >> KSZ_1BYTE_SHIFTING_VALUE);
+				tmpFrame = ksz8851_sim_read16(sim, sim->dword_addr + 2);
+				sim->data[KSZ_REG_BUFF_BYTE2] = (uint8_t)tmpFrame;
+				sim->data[KSZ_REG_BUFF_BYTE3] = (uint8_t)(tmpFrame >> KSZ_1BYTE_SHIFTING_VALUE);
+			}
+			return 0;
+
+		case KSZ_SIM_PHASE_REG_DATA:
+			tmpIndex = ksz8851_sim_enabled_byte(sim->byte_enables, sim->data_index++);
+
+			if(tmpIndex < 0)
+			{
+				return 0;
+			}
+
+			if((sim->cmd >> KSZ_SIM_FIFO_OPCODE_SHIFT) == KSZ8851_READ_REG)
+			{
+				return sim->data[tmpIndex];
+			}
+
+			sim->data[tmpIndex] = tx;
+			sim->write_mask |= (uint8_t)(1 << tmpIndex);
+			return 0;
+
+		case KSZ_SIM_PHASE_FIFO_READ:
+			/* Stream: dummy bytes, status, byte count, IP header offset, frame with CRC, dword padding */
+			tmpPos = sim->fifo_pos++;
+			tmpByteCount = frame->length + KSZ_SIM_CRC_SIZE;
+
+			if(sim->rxq_count == 0 ||
+			   tmpPos >= KSZ_RX_FIFO_DUMMY_SIZE + KSZ_RX_FIFO_HEADER_SIZE + KSZ_DWORD_ALIGN(tmpByteCount + KSZ_RX_IP_OFFSET_SIZE))
+			{
+				if(!sim->fifo_fault)
+				{
+					sim->fifo_fault = true;
+					sim->Statistics.fifo_overreads++;
+				}
+				return 0;
+			}
+
+			switch(tmpPos)
+			{
+				case KSZ_RX_FIFO_DUMMY_SIZE:		return (uint8_t)frame->status;
+				case KSZ_RX_FIFO_DUMMY_SIZE + 1:	return (uint8_t)(frame->status >> KSZ_1BYTE_SHIFTING_VALUE);
+				case KSZ_RX_FIFO_DUMMY_SIZE + 2:	return (uint8_t)tmpByteCount;
+				case KSZ_RX_FIFO_DUMMY_SIZE + 3:	return (uint8_t)(tmpByteCount >> KSZ_1BYTE_SHIFTING_VALUE);
+				default:							break;
+			}
+
+			if(tmpPos >= KSZ_RX_FIFO_PREAMBLE_SIZE && tmpPos < KSZ_RX_FIFO_PREAMBLE_SIZE + frame->length)
+			{
+				return frame->data[tmpPos - KSZ_RX_FIFO_PREAMBLE_SIZE];
+			}
+			return 0;
+
+		case KSZ_SIM_PHASE_FIFO_WRITE:
+			/* Control word and byte count are little endian, frame data follows them */
+			tmpPos = sim->tx_pos++;
+
+			switch(tmpPos)
+			{
+				case 0:	sim->tx_frame.status = tx;												break;
+				case 1:	sim->tx_frame.status |= (uint16_t)(tx << KSZ_1BYTE_SHIFTING_VALUE);	break;
+				case 2:	sim->tx_frame.length = tx;												break;
+				case 3:	sim->tx_frame.length |= (uint16_t)(tx << KSZ_1BYTE_SHIFTING_VALUE);	break;
+				default:
+					if(tmpPos - KSZ_DWORD_VALUE < KSZ_ETH_MAX_FRAME_SIZE)
+					{
+						sim->tx_frame.data[tmpPos - KSZ_DWORD_VALUE] = tx;
+					}
+					break;
+			}
+			return 0;
+
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief  Chip select goes high. Register writes take effect and written TX frame is put into TXQ.
+ * @param  sim
+ */
+static void ksz8851_sim_spi_end(KSZ8851_Sim_t *sim)
+{
+	uint8_t i;
+
+	switch(sim->phase)
+	{
+		case KSZ_SIM_PHASE_REG_CMD:
+			sim->Statistics.protocol_errors++;
+			break;
+
+		case KSZ_SIM_PHASE_REG_DATA:
+			if((sim->cmd >> KSZ_SIM_FIFO_OPCODE_SHIFT) != KSZ8851_WRITE_REG)
+			{
+				break;
+			}
+
+			if(sim->write_mask != sim->byte_enables)
+			{
+				sim->Statistics.protocol_errors++;
+			}
+
+			/* Each register of the dword is written if any of its bytes is received */
+			for(i = 0; i < KSZ_DWORD_VALUE; i += 2)
+			{
+				if(sim->write_mask & (KSZ_REG_BYTES_SELECT_0_1_MASK_VALUE << i))
+				{
+					uint16_t tmpValue = sim->regs[KSZ_REG_DESCRIPTOR_INDEX(sim->dword_addr + i)];
+
+					if(sim->write_mask & (1 << i))
+					{
+						tmpValue = (tmpValue & KSZ_REG_CMD_BYTE0_MASK) | sim->data[i];
+					}
+
+					if(sim->write_mask & (1 << (i + 1)))
+					{
+						tmpValue = (tmpValue & KSZ_REG_CMD_BYTE1_MASK) | (uint16_t)(sim->data[i + 1] << KSZ_1BYTE_SHIFTING_VALUE);
+					}
+
+					ksz8851_sim_write16(sim, sim->dword_addr + i, tmpValue);
+				}
+			}
+			break;
+
+		case KSZ_SIM_PHASE_FIFO_WRITE:
+			if(sim->tx_pos < KSZ_DWORD_VALUE || sim->tx_frame.length == 0 || sim->tx_frame.length > KSZ_ETH_MAX_FRAME_SIZE ||
+			   sim->tx_pos < KSZ_DWORD_VALUE + sim->tx_frame.length)
+			{
+				sim->Statistics.protocol_errors++;
+			}
+			else if(sim->txq_count == KSZ_SIM_TXQ_SLOTS ||
+					sim->txq_bytes + KSZ_SIM_TXQ_FRAME_SIZE(sim->tx_frame.length) > KSZ_SIM_TXQ_SIZE)
+			{
+				sim->Statistics.tx_overflows++;
+			}
+			else
+			{
+				sim->txq[(sim->txq_head + sim->txq_count) % KSZ_SIM_TXQ_SLOTS] = sim->tx_frame;
+				sim->txq_count++;
+				sim->txq_bytes += KSZ_SIM_TXQ_FRAME_SIZE(sim->tx_frame.length);
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	sim->phase = KSZ_SIM_PHASE_IDLE;
+}
+
+/**
+ * @brief  Full duplex transfer inside current transaction, either buffer can be NULL. Transfers of a thread that doesn't own
+ * 		   the transaction are counted, their bytes are still mixed into it like on a real bus.
+ * @param  sim
+ * @param  pTxBuffer
+ * @param  pRxBuffer
+ * @param  dataLength
+ */
+static void ksz8851_sim_spi_transfer(KSZ8851_Sim_t *sim, const uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
+{
+	uint8_t tmpByte;
+	uint16_t i;
+
+	pthread_mutex_lock(&sim->lock);
+
+	if(sim->cs_depth == 0)
+	{
+		sim->Statistics.spi_without_cs++;
+	}
+	else if(!pthread_equal(sim->cs_owner, pthread_self()))
+	{
+		sim->Statistics.spi_foreign++;
+	}
+
+	for(i = 0; i < dataLength; i++)
+	{
+		tmpByte = ksz8851_sim_spi_byte(sim, (pTxBuffer != NULL) ? pTxBuffer[i] : 0);
+
+		if(pRxBuffer != NULL)
+		{
+			pRxBuffer[i] = tmpByte;
+		}
+	}
+
+	pthread_mutex_unlock(&sim->lock);
+
+	if(sim->config.spi_yield)
+	{
+		sched_yield();
+	}
+}
+
+static KSZ8851_Status_t ksz8851_sim_spi_transmit(void *user, uint8_t *pTxBuffer, uint16_t dataLength)
+{
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, pTxBuffer, NULL, dataLength);
+
+	return KSZ_OK;
+}
+
+static KSZ8851_Status_t ksz8851_sim_spi_receive(void *user, uint8_t *pRxBuffer, uint16_t dataLength)
+{
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, NULL, pRxBuffer, dataLength);
+
+	return KSZ_OK;
+}
+
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_receive(void *user, uint8_t *pTxBuffer, uint8_t *pRxBuffer, uint16_t dataLength)
+{
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, pTxBuffer, pRxBuffer, dataLength);
+
+	return KSZ_OK;
+}
+
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_then_receive(void *user, uint8_t *pTxBuffer, uint16_t txLength, uint8_t *pRxHeader, uint16_t rxHeaderLength,
+		uint8_t *pRxBuffer, uint16_t rxLength)
+{
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, pTxBuffer, NULL, txLength);
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, NULL, pRxHeader, rxHeaderLength);
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, NULL, pRxBuffer, rxLength);
+
+	return KSZ_OK;
+}
+
+static KSZ8851_Status_t ksz8851_sim_spi_transmit_then_transmit(void *user, uint8_t *pHeader, uint16_t headerLength, uint8_t *pTxBuffer, uint16_t dataLength,
+		uint8_t paddingLength)
+{
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, pHeader, NULL, headerLength);
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, pTxBuffer, NULL, dataLength);
+	ksz8851_sim_spi_transfer((KSZ8851_Sim_t*)user, NULL, NULL, paddingLength);
+
+	return KSZ_OK;
+}
+
+/**
+ * @brief  Chip select and hard reset pins. Chip select going low while a transaction is running is an overlap of two contexts.
+ * @param  user: simulator
+ * @param  port
+ * @param  pin
+ * @param  pinStatus
+ */
+static void ksz8851_sim_gpio_control(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus)
+{
+	KSZ8851_Sim_t *sim = (KSZ8851_Sim_t*)user;
+
+	pthread_mutex_lock(&sim->lock);
+
+	if(port == sim->config.cs_port && pin == sim->config.cs_pin)
+	{
+		if(pinStatus == KSZ_GPIO_PIN_RESET)
+		{
+			if(sim->cs_depth != 0)
+			{
+				sim->Statistics.cs_overlaps++;
+			}
+			else
+			{
+				sim->cs_owner = pthread_self();
+				sim->phase = KSZ_SIM_PHASE_CMD;
+			}
+
+			sim->cs_depth++;
+		}
+		else if(sim->cs_depth != 0 && --sim->cs_depth == 0)
+		{
+			ksz8851_sim_spi_end(sim);
+		}
+	}
+	else if(port == sim->config.rst_port && pin == sim->config.rst_pin && pinStatus == KSZ_GPIO_PIN_RESET)
+	{
+		ksz8851_sim_reset(sim);
+	}
+
+	ksz8851_sim_update_intrn(sim, ksz8851_sim_now_us());
+
+	pthread_mutex_unlock(&sim->lock);
+}
+
+static uint32_t ksz8851_sim_get_tick(void *user)
+{
+	struct timespec now;
+
+	(void)user;
+
+	/* Own conversion, ms tick mustn't jump when the 32 bit us counter wraps */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)((uint64_t)now.tv_sec * KSZ_TIME_US_PER_MS + (uint64_t)(now.tv_nsec / (KSZ_SIM_NS_PER_US * KSZ_TIME_US_PER_MS)));
+}
+
+static uint32_t ksz8851_sim_get_tick_us(void *user)
+{
+	(void)user;
+
+	return ksz8851_sim_now_us();
+}
+
+static void ksz8851_sim_yield(void *user)
+{
+	(void)user;
+
+	sched_yield();
+}
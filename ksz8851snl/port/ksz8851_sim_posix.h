@@ -0,0 +1,206 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_sim_posix.h
+ * @description : 	This file provides threaded KSZ8851SNL chip simulator to run the driver against on Linux hosts.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_SIM_POSIX_H
+#define __KSZ8851_SIM_POSIX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include "../ksz8851.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_SIM_RXQ_SIZE										12288		//bytes of RXQ memory, a frame takes KSZ_DWORD_ALIGN(byte count) + KSZ_DWORD_VALUE
+#define KSZ_SIM_TXQ_SIZE										6144		//bytes of TXQ memory reported by TXMIR, a frame takes KSZ_DWORD_ALIGN(length) + KSZ_DWORD_VALUE
+#define KSZ_SIM_RXQ_SLOTS										64			//frames kept in simulated RXQ, RXFCTR frame count is 8 bit
+#define KSZ_SIM_TXQ_SLOTS										32			//frames written to simulated TXQ and not transmitted yet
+#define KSZ_SIM_CHIP_ID											0x8872		//CIDER value, KSZ8851SNL revision 1
+#define KSZ_SIM_ETHERTYPE										0x88B5		//EtherType of generated frames (local experimental), big endian sequence number follows it
+#define KSZ_SIM_SEQUENCE_OFFSET									14			//offset of 32 bit sequence number in generated frames
+#define KSZ_SIM_MIN_FRAME_SIZE									60			//minimum ethernet frame without CRC
+#define KSZ_SIM_MIN_RX_FRAME_SIZE								(KSZ_SIM_SEQUENCE_OFFSET + 4)	//generated frames are at least this long (ethernet header and sequence number), minimum ethernet frame isn't enforced
+#define KSZ_SIM_TICK_US											100			//default period of simulator thread
+#define KSZ_SIM_LINK_MBPS										100			//default wire rate of transmitted frames
+#define KSZ_SIM_WIRE_OVERHEAD									24			//preamble, SFD, CRC and inter frame gap bytes of each transmitted frame
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint32_t		cs_port;										// chip select pin the driver toggles (KSZ8851_Interface_t), SPI transactions are framed by it
+	uint16_t		cs_pin;
+	uint32_t		rst_port;										// hard reset pin, chip is reset while it is low
+	uint16_t		rst_pin;
+	uint8_t			MAC_address[KSZ_MAC_ADDRR_LEN];					// destination MAC of generated frames
+	uint32_t		rx_rate_fps;									// generated frames per second, 0 generates nothing
+	uint16_t		rx_frame_length;								// length of generated frames without CRC, KSZ_SIM_MIN_RX_FRAME_SIZE .. KSZ_ETH_MAX_FRAME_SIZE
+	uint32_t		link_rate_Mbps;									// wire rate of transmitted frames, 0 is KSZ_SIM_LINK_MBPS
+	uint32_t		tick_us;										// period of simulator thread, 0 is KSZ_SIM_TICK_US
+	bool			spi_yield;										// spi transfers give CPU away when they finish, like a blocking port of an RTOS which sleeps while DMA runs. Unserialized contexts then meet inside transactions
+	void			(*INTRN_Falling)(void *arg);					// called from simulator thread when INTRN goes low, e.g. calls ksz8851_service_isr. ksz8851_init enables interrupts, ignore edges until service is ready
+	void			*intrn_arg;
+	void			*app;											// application context, callbacks get the simulator as user (ksz8851_sim_posix_app)
+
+}KSZ8851_Sim_Config_t;
+
+typedef struct
+{
+	uint32_t		rx_generated;									// frames arrived from wire
+	uint32_t		rx_overruns;									// frames dropped because RXQ was full (KSZ_FLAGS_INTERRUPTS_RX_OVERRUN)
+	uint32_t		rx_delivered;									// frames read completely by fifo and dequeued
+	uint32_t		rx_released;									// frames dropped by KSZ_CONFIG_RX_CMD_RELEASE_ERROR_FR
+	uint32_t		tx_frames;										// frames transmitted to wire
+	uint32_t		tx_bytes;
+	uint32_t		tx_overflows;									// frames written to TXQ without free memory, they are lost
+	uint32_t		interrupts;										// INTRN falling edges
+	uint32_t		intrn_low_max_us;								// longest INTRN assertion, interrupts pending and not served
+	uint32_t		cs_overlaps;									// chip select driven low while another transaction is running
+	uint32_t		spi_foreign;									// spi transfers from a thread which doesn't own current transaction
+	uint32_t		spi_without_cs;									// spi transfers while chip select is high
+	uint32_t		dma_register_access;							// register access other than RXQCR during QMU DMA session
+	uint32_t		fifo_without_dma;								// fifo command while QMU DMA is not started
+	uint32_t		fifo_overreads;									// RXQ fifo read beyond present frame or with empty RXQ
+	uint32_t		protocol_errors;								// malformed TX fifo writes and unfinished register commands
+
+}KSZ8851_Sim_Statistics_t;
+
+typedef struct
+{
+	uint16_t		length;											// frame length without CRC
+	uint16_t		status;											// RXFHSR value, TXQ control word
+	uint32_t		done_us;										// TXQ: time the frame leaves the wire
+	uint8_t			data[KSZ_ETH_MAX_FRAME_SIZE];
+
+}KSZ8851_Sim_Frame_t;
+
+typedef struct
+{
+	KSZ8851_Sim_Config_t		config;
+	KSZ8851_Sim_Statistics_t	Statistics;
+
+	pthread_mutex_t				lock;								// guards all members below, spi and register callbacks run under it
+	pthread_cond_t				wakeup;								// wakes simulator thread for INTRN edges and stop
+	pthread_t					thread;
+	bool						running;
+
+	uint16_t					regs[KSZ_REG_DESCRIPTOR_COUNT];		// plain register content, index is (address >> 1)
+	uint16_t					isr;
+	uint16_t					ier;
+	uint16_t					txsr;
+	bool						dma;								// QMU DMA session is started (KSZ_CONFIG_RX_CMD_START_DMA_ACCESS)
+	bool						intrn_low;
+	bool						intrn_edge;							// falling edge not reported to INTRN_Falling yet
+	uint32_t					intrn_low_us;
+
+	uint8_t						cs_depth;							// chip select low count, more than 1 is an overlap
+	pthread_t					cs_owner;
+	uint8_t						phase;								// spi transaction phase
+	uint8_t						cmd;								// first byte of register command
+	uint8_t						write_mask;							// byte enables received by register write
+	uint8_t						byte_enables;
+	uint8_t						dword_addr;
+	uint8_t						data_index;
+	uint8_t						data[KSZ_DWORD_VALUE];
+	bool						fifo_fault;							// fifo overread is counted once per transaction
+	uint16_t					fifo_pos;							// RXQ stream position of present frame
+	uint16_t					tx_pos;								// TXQ write position of current transaction
+	KSZ8851_Sim_Frame_t			tx_frame;							// frame written by current transaction
+
+	KSZ8851_Sim_Frame_t			rxq[KSZ_SIM_RXQ_SLOTS];
+	uint8_t						rxq_head;
+	uint8_t						rxq_count;
+	uint16_t					rxq_bytes;
+	uint32_t					rx_sequence;
+	uint32_t					rx_next_us;							// arrival time of next generated frame
+	uint32_t					rx_next_fraction;					// fraction of us behind rx_next_us, in 1 / rx_rate_fps us
+
+	KSZ8851_Sim_Frame_t			txq[KSZ_SIM_TXQ_SLOTS];
+	uint8_t						txq_head;
+	uint8_t						txq_count;							// enqueued and written frames
+	uint8_t						txq_enqueued;						// first txq_enqueued frames are waiting for wire
+	uint16_t					txq_bytes;
+	uint32_t					tx_wire_us;							// time the wire is free
+
+}KSZ8851_Sim_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Resets simulated chip and starts simulator thread. Thread generates RX frames at config->rx_rate_fps in real time, transmits
+* 		  enqueued TX frames at wire rate and calls INTRN_Falling while (ISR & IER) goes non-zero, so the driver "isr" preempts
+* 		  application thread like on target. Driver must control chip select (KSZ8851_Interface_t) to frame SPI transactions.
+* @param  sim
+* @param  config: copied into sim
+* @return KSZ_OK, KSZ_ERROR if thread can't be created
+*/
+KSZ8851_Status_t ksz8851_sim_posix_start(KSZ8851_Sim_t *sim, const KSZ8851_Sim_Config_t *config);
+
+/**
+* @brief  Stops simulator thread, INTRN_Falling isn't called after it returns.
+* @param  sim
+*/
+void ksz8851_sim_posix_stop(KSZ8851_Sim_t *sim);
+
+/**
+* @brief  Fills SPI, GPIO and TIME callbacks of driver with the simulator and sets functions->user to sim. Other callbacks are left
+* 		  untouched, they get the simulator as user too, application context is given by ksz8851_sim_posix_app.
+* @param  sim
+* @param  functions: callbacks of KSZ8851_Config_t
+*/
+void ksz8851_sim_posix_callbacks(KSZ8851_Sim_t *sim, KSZ8851_Callbacks_t *functions);
+
+/**
+* @brief  Returns config->app of the simulator given to driver callbacks as user.
+* @param  user
+* @retval application context
+*/
+void* ksz8851_sim_posix_app(void *user);
+
+/**
+* @brief  Changes frames per second of generated RX traffic, e.g. to find throughput limit of the driver.
+* @param  sim
+* @param  rx_rate_fps
+*/
+void ksz8851_sim_posix_set_rx_rate(KSZ8851_Sim_t *sim, uint32_t rx_rate_fps);
+
+/**
+* @brief  Changes wire rate of transmitted frames, e.g. to make the wire and not the spi bus the TX limit of an instance.
+* @param  sim
+* @param  link_rate_Mbps: 0 is KSZ_SIM_LINK_MBPS
+*/
+void ksz8851_sim_posix_set_link_rate(KSZ8851_Sim_t *sim, uint32_t link_rate_Mbps);
+
+/**
+* @brief  Copies simulator statistics. Non-zero cs_overlaps, spi_foreign, dma_register_access, fifo_without_dma or fifo_overreads
+* 		  counters are races between interrupt and application context, rx_overruns and intrn_low_max_us show throughput losses.
+* @param  sim
+* @param  statistics
+*/
+void ksz8851_sim_posix_statistics(KSZ8851_Sim_t *sim, KSZ8851_Sim_Statistics_t *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KSZ8851_SIM_POSIX_H */
@@ -0,0 +1,138 @@
+ /******************************************************************************
+ * @filename	: 	bench_rx_burst.c
+ * @description : 	This file reports RXQ fifo spi bursts, receive throughput and CPU cost per frame of each SPI RX data burst setting
+ * 					against KSZ8851SNL simulator.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* clock_gettime and CLOCK_THREAD_CPUTIME_ID are POSIX, not part of ISO C */
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ------------------------------------------------------------------*/
+#include <time.h>
+#include "ksz8851_test.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define BENCH_WIRE_FPS(length)									(KSZ_SIM_LINK_MBPS * 1000000UL / (((length) + KSZ_SIM_WIRE_OVERHEAD) * 8))
+#define BENCH_RUN_MS											1000
+#define BENCH_DRAIN_MS											200
+#define BENCH_US_PER_SEC										1000000ULL
+#define BENCH_NS_PER_US											1000
+#define BENCH_INTRN_LOW_MAX_US									100000		//INTRN is served again long before this, even when RXQ overruns
+
+/* Private variables ---------------------------------------------------------*/
+static KSZ8851_Test_Chip_t bench_chip;
+
+static const struct
+{
+	uint16_t		burst;
+	const char		*name;
+
+}bench_bursts[] =
+{
+	{ KSZ_CONFIG_RX_CTRL2_DATA_BURST_4BYTES,	"4 bytes" },
+	{ KSZ_CONFIG_RX_CTRL2_DATA_BURST_8BYTES,	"8 bytes" },
+	{ KSZ_CONFIG_RX_CTRL2_DATA_BURST_16BYTES,	"16 bytes" },
+	{ KSZ_CONFIG_RX_CTRL2_DATA_BURST_32BYTES,	"32 bytes" },
+	{ KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN,	"frame" },
+};
+
+static const uint16_t bench_frame_lengths[] = { KSZ_SIM_MIN_FRAME_SIZE, 512, KSZ_ETH_MAX_FRAME_SIZE };
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Returns microseconds of a clock, CLOCK_MONOTONIC for wall time, CLOCK_THREAD_CPUTIME_ID for CPU time of calling thread */
+static uint64_t bench_clock_us(clockid_t clock)
+{
+	struct timespec tmpNow;
+
+	clock_gettime(clock, &tmpNow);
+
+	return (uint64_t)tmpNow.tv_sec * BENCH_US_PER_SEC + (uint64_t)tmpNow.tv_nsec / BENCH_NS_PER_US;
+}
+
+/* Receives frames of one length with one burst setting, driver is served in this thread like a bare metal main loop. Frames
+ * arrive at wire rate, frames/s is what the driver reads of them. CPU time is the serving thread's, simulated spi transfers run
+ * in it too */
+static void bench_run(uint8_t setting, uint16_t frame_length)
+{
+	uint16_t tmpStream = KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(frame_length);
+	uint16_t tmpBurstLength = (bench_bursts[setting].burst == KSZ_CONFIG_RX_CTRL2_DATA_BURST_FR_LEN) ? tmpStream :
+							  (uint16_t)(KSZ_DWORD_VALUE << (bench_bursts[setting].burst >> KSZ_CONFIG_RX_CTRL2_DATA_BURST_SHIFT));
+	KSZ8851_Statistics_t *stats = &bench_chip.driver.Statistics;
+	KSZ8851_Sim_Statistics_t tmpSimStats;
+	uint64_t tmpWallUs, tmpCpuUs;
+	uint32_t tmpFrames;
+	uint32_t tmpStart;
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&bench_chip, 0, 0, frame_length, false, NULL) == KSZ_OK);
+	KSZ_TEST_CHECK(ksz8851_set_rx_burst(&bench_chip.driver, bench_bursts[setting].burst) == KSZ_OK);
+
+	ksz8851_sim_posix_set_rx_rate(&bench_chip.sim, BENCH_WIRE_FPS(frame_length));
+	tmpStart = ksz8851_test_ms();
+	tmpWallUs = bench_clock_us(CLOCK_MONOTONIC);
+	tmpCpuUs = bench_clock_us(CLOCK_THREAD_CPUTIME_ID);
+	tmpFrames = stats->rx_frames;
+
+	while(ksz8851_test_ms() - tmpStart < BENCH_RUN_MS)
+		ksz8851_test_chip_irq(&bench_chip, 10);
+
+	tmpFrames = stats->rx_frames - tmpFrames;
+	tmpCpuUs = bench_clock_us(CLOCK_THREAD_CPUTIME_ID) - tmpCpuUs;
+	tmpWallUs = bench_clock_us(CLOCK_MONOTONIC) - tmpWallUs;
+
+	ksz8851_sim_posix_set_rx_rate(&bench_chip.sim, 0);
+	tmpStart = ksz8851_test_ms();
+
+	while(ksz8851_test_ms() - tmpStart < BENCH_DRAIN_MS)
+		ksz8851_test_chip_irq(&bench_chip, 10);
+
+	ksz8851_test_chip_stop(&bench_chip);
+	ksz8851_sim_posix_statistics(&bench_chip.sim, &tmpSimStats);
+
+	printf("  %-8s | %6u | %10u | %12u | %11u | %8llu | %8.2f\n", bench_bursts[setting].name, stats->rx_frames, stats->rx_spi_bursts,
+		   (stats->rx_frames != 0) ? stats->rx_spi_bursts / stats->rx_frames : 0,
+		   (stats->rx_spi_bursts != 0) ? stats->rx_bytes / stats->rx_spi_bursts : 0,
+		   (tmpWallUs != 0) ? (unsigned long long)(tmpFrames * BENCH_US_PER_SEC / tmpWallUs) : 0ULL,
+		   (tmpFrames != 0) ? (double)tmpCpuUs / tmpFrames : 0.0);
+
+	/* Each frame is read as one stream of DWORD aligned bursts, the last burst takes the rest */
+	KSZ_TEST_CHECK(tmpFrames > 0);
+	KSZ_TEST_CHECK(tmpSimStats.intrn_low_max_us < BENCH_INTRN_LOW_MAX_US);
+	KSZ_TEST_CHECK(bench_chip.rx_frames == stats->rx_frames);
+	KSZ_TEST_CHECK(bench_chip.rx_gaps == 0 && bench_chip.rx_bad == 0 && bench_chip.rx_overwrites == 0);
+	KSZ_TEST_CHECK(stats->rx_bytes == stats->rx_frames * tmpStream);
+	KSZ_TEST_CHECK(stats->rx_spi_bursts == stats->rx_frames * ((tmpStream + tmpBurstLength - 1) / tmpBurstLength));
+}
+
+/* Main ----------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint8_t i, j;
+
+	for(i = 0; i < sizeof(bench_frame_lengths) / sizeof(bench_frame_lengths[0]); i++)
+	{
+		printf("%u byte frames, %u byte fifo stream, %lu frames/s wire rate:\n", bench_frame_lengths[i],
+			   KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(bench_frame_lengths[i]), BENCH_WIRE_FPS(bench_frame_lengths[i]));
+		printf("  burst    | frames | spi bursts | bursts/frame | bytes/burst | frames/s | cpu us/frame\n");
+
+		for(j = 0; j < sizeof(bench_bursts) / sizeof(bench_bursts[0]); j++)
+			bench_run(j, bench_frame_lengths[i]);
+	}
+
+	return ksz8851_test_result("bench_rx_burst");
+}
@@ -0,0 +1,273 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_test.c
+ * @description : 	This file provides common fixture of host tests which run the driver against KSZ8851SNL simulator.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* sem_timedwait, clock_gettime and nanosleep are POSIX, not part of ISO C */
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "ksz8851_test.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t ksz8851_test_failures;
+static void (*ksz8851_test_sim_gpio)(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus);
+static uint32_t ksz8851_test_bus_cs;									// chip selects of bus instances driven low
+static uint32_t ksz8851_test_bus_overlap_count;							// chip select driven low while another bus instance owns the bus
+
+static const uint8_t ksz8851_test_mac[KSZ_MAC_ADDRR_LEN] = {0x02, 0x00, 0x88, 0x51, 0x00, 0x00};
+
+/* Private functions ---------------------------------------------------------*/
+
+static KSZ8851_Test_Chip_t* ksz8851_test_chip(void *user)
+{
+	return (KSZ8851_Test_Chip_t*)ksz8851_sim_posix_app(user);
+}
+
+static void ksz8851_test_intrn(void *arg)
+{
+	KSZ8851_Test_Chip_t *chip = (KSZ8851_Test_Chip_t*)arg;
+
+	if(!chip->ready)
+		return;
+
+	if(chip->use_service)
+		ksz8851_service_isr(&chip->service);
+	else
+		sem_post(&chip->intrn);
+}
+
+/* Wraps chip select of the simulator to find transactions of different instances overlapping on the shared bus */
+static void ksz8851_test_gpio_control(void *user, uint32_t port, uint16_t pin, uint8_t pinStatus)
+{
+	KSZ8851_Test_Chip_t *chip = ksz8851_test_chip(user);
+	bool tmpChipSelect = (chip->driver.bus != NULL && port == chip->config.interface.cs_port && pin == chip->config.interface.cs_pin);
+
+	if(tmpChipSelect && pinStatus == KSZ_GPIO_PIN_RESET)
+	{
+		if(__atomic_fetch_add(&ksz8851_test_bus_cs, 1, __ATOMIC_SEQ_CST) != 0)
+			__atomic_fetch_add(&ksz8851_test_bus_overlap_count, 1, __ATOMIC_SEQ_CST);
+	}
+
+	ksz8851_test_sim_gpio(user, port, pin, pinStatus);
+
+	if(tmpChipSelect && pinStatus == KSZ_GPIO_PIN_SET)
+		__atomic_fetch_sub(&ksz8851_test_bus_cs, 1, __ATOMIC_SEQ_CST);
+}
+
+static uint8_t* ksz8851_test_rx_get_buffer(void *user, uint16_t frameLength)
+{
+	KSZ8851_Test_Chip_t *chip = ksz8851_test_chip(user);
+
+	chip->rx_length = frameLength;
+	memset(&chip->rx_buffer[KSZ_RX_BUFFER_SIZE(frameLength)], KSZ_TEST_CANARY_VALUE, KSZ_TEST_CANARY_SIZE);
+
+	return chip->rx_buffer;
+}
+
+static void ksz8851_test_rx_frame_received(void *user, uint8_t *pRxBuffer, uint16_t frameLength)
+{
+	KSZ8851_Test_Chip_t *chip = ksz8851_test_chip(user);
+	uint32_t tmpSequence;
+	uint16_t i;
+
+	for(i = 0; i < KSZ_TEST_CANARY_SIZE; i++)
+	{
+		if(pRxBuffer[KSZ_RX_BUFFER_SIZE(chip->rx_length) + i] != KSZ_TEST_CANARY_VALUE)
+		{
+			chip->rx_overwrites++;
+			break;
+		}
+	}
+
+	if(frameLength != chip->rx_length || frameLength < KSZ_SIM_SEQUENCE_OFFSET + 4 ||
+	   memcmp(pRxBuffer, chip->config.MAC_address, KSZ_MAC_ADDRR_LEN) != 0 ||
+	   ((pRxBuffer[12] << 8) | pRxBuffer[13]) != KSZ_SIM_ETHERTYPE)
+	{
+		chip->rx_bad++;
+		return;
+	}
+
+	tmpSequence = ((uint32_t)pRxBuffer[KSZ_SIM_SEQUENCE_OFFSET] << 24) | ((uint32_t)pRxBuffer[KSZ_SIM_SEQUENCE_OFFSET + 1] << 16) |
+				  ((uint32_t)pRxBuffer[KSZ_SIM_SEQUENCE_OFFSET + 2] << 8) | pRxBuffer[KSZ_SIM_SEQUENCE_OFFSET + 3];
+
+	if(chip->rx_started && tmpSequence != chip->rx_next_sequence)
+		chip->rx_gaps += tmpSequence - chip->rx_next_sequence;
+
+	chip->rx_started = true;
+	chip->rx_next_sequence = tmpSequence + 1;
+	chip->rx_frames++;
+}
+
+static void ksz8851_test_tx_frame_done(void *user, const KSZ8851_Frame_Info_t *info)
+{
+	(void)info;
+
+	ksz8851_test_chip(user)->tx_done++;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+KSZ8851_Status_t ksz8851_test_chip_start(KSZ8851_Test_Chip_t *chip, uint8_t index, uint32_t rx_rate_fps, uint16_t rx_frame_length,
+										 bool use_service, KSZ8851_Bus_t *bus)
+{
+	KSZ8851_Sim_Config_t tmpSimConfig;
+	KSZ8851_Config_t tmpConfig = { KSZ_CONFIG_PROFILE_DEFAULT };
+	KSZ8851_Status_t result = KSZ_OK;
+
+	memset(chip, 0, sizeof(KSZ8851_Test_Chip_t));
+	chip->use_service = use_service;
+	sem_init(&chip->intrn, 0, 0);
+
+	tmpConfig.interface.cs_port = KSZ_TEST_CS_PORT;
+	tmpConfig.interface.cs_pin = KSZ_TEST_CS_PIN + index;
+	tmpConfig.interface.rst_port = KSZ_TEST_RST_PORT;
+	tmpConfig.interface.rst_pin = KSZ_TEST_RST_PIN + index;
+	tmpConfig.interrupts |= KSZ_FLAGS_INTERRUPTS_TX;
+	memcpy(tmpConfig.MAC_address, ksz8851_test_mac, KSZ_MAC_ADDRR_LEN);
+	tmpConfig.MAC_address[KSZ_MAC_ADDRR_LEN - 1] = index;
+
+	memset(&tmpSimConfig, 0, sizeof(tmpSimConfig));
+	tmpSimConfig.cs_port = tmpConfig.interface.cs_port;
+	tmpSimConfig.cs_pin = tmpConfig.interface.cs_pin;
+	tmpSimConfig.rst_port = tmpConfig.interface.rst_port;
+	tmpSimConfig.rst_pin = tmpConfig.interface.rst_pin;
+	memcpy(tmpSimConfig.MAC_address, tmpConfig.MAC_address, KSZ_MAC_ADDRR_LEN);
+	tmpSimConfig.rx_rate_fps = rx_rate_fps;
+	tmpSimConfig.rx_frame_length = rx_frame_length;
+	tmpSimConfig.spi_yield = true;										//host threads meet inside transactions as tasks of an RTOS do, not only on time slice ends
+	tmpSimConfig.INTRN_Falling = ksz8851_test_intrn;
+	tmpSimConfig.intrn_arg = chip;
+	tmpSimConfig.app = chip;
+
+	ksz8851_sim_posix_callbacks(&chip->sim, &tmpConfig.functions);
+	ksz8851_test_sim_gpio = tmpConfig.functions.GPIO_Control;
+	tmpConfig.functions.GPIO_Control = ksz8851_test_gpio_control;
+	tmpConfig.functions.RX_GetBuffer = ksz8851_test_rx_get_buffer;
+	tmpConfig.functions.RX_FrameReceived = ksz8851_test_rx_frame_received;
+	tmpConfig.functions.TX_FrameDone = ksz8851_test_tx_frame_done;
+	chip->config = tmpConfig;
+
+	result |= ksz8851_sim_posix_start(&chip->sim, &tmpSimConfig);
+
+	if(result == KSZ_OK && bus != NULL)
+		result |= ksz8851_bus_attach(bus, &chip->driver, KSZ_BUS_PRIORITY_LOWEST);
+
+	if(result == KSZ_OK)
+		result |= ksz8851_init(&chip->driver, &chip->config);
+
+	if(result == KSZ_OK && use_service)
+		result |= ksz8851_service_init(&chip->service, &chip->driver, ksz8851_os_posix_callbacks());
+
+	chip->ready = (result == KSZ_OK);
+
+	return result;
+}
+
+bool ksz8851_test_chip_irq(KSZ8851_Test_Chip_t *chip, uint32_t timeout_ms)
+{
+	struct timespec tmpDeadline;
+
+	clock_gettime(CLOCK_REALTIME, &tmpDeadline);
+	tmpDeadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+	tmpDeadline.tv_sec += timeout_ms / 1000 + tmpDeadline.tv_nsec / 1000000000L;
+	tmpDeadline.tv_nsec %= 1000000000L;
+
+	while(sem_timedwait(&chip->intrn, &tmpDeadline) != 0)
+	{
+		if(errno != EINTR)
+			return false;
+	}
+
+	ksz8851_irq_handler(&chip->driver);
+
+	return true;
+}
+
+void ksz8851_test_chip_stop(KSZ8851_Test_Chip_t *chip)
+{
+	chip->ready = false;
+
+	if(chip->use_service)
+	{
+		ksz8851_service_stop(&chip->service);
+		ksz8851_service_lock(&chip->service);
+	}
+
+	ksz8851_sim_posix_stop(&chip->sim);
+}
+
+uint32_t ksz8851_test_violations(const KSZ8851_Sim_Statistics_t *statistics)
+{
+	return statistics->cs_overlaps + statistics->spi_foreign + statistics->spi_without_cs + statistics->dma_register_access +
+		   statistics->fifo_without_dma + statistics->fifo_overreads + statistics->protocol_errors +
+		   __atomic_load_n(&ksz8851_test_bus_overlap_count, __ATOMIC_SEQ_CST);
+}
+
+void ksz8851_test_print_sim(const char *name, const KSZ8851_Sim_Statistics_t *statistics)
+{
+	printf("  %s: rx generated %u overruns %u delivered %u released %u | tx %u overflows %u | irq %u intrn low max %u us\n",
+		   name, statistics->rx_generated, statistics->rx_overruns, statistics->rx_delivered, statistics->rx_released, statistics->tx_frames,
+		   statistics->tx_overflows, statistics->interrupts, statistics->intrn_low_max_us);
+	printf("  %s: cs overlaps %u spi foreign %u spi without cs %u dma register %u fifo without dma %u fifo overreads %u"
+		   " protocol %u bus overlaps %u\n", name, statistics->cs_overlaps, statistics->spi_foreign, statistics->spi_without_cs,
+		   statistics->dma_register_access, statistics->fifo_without_dma, statistics->fifo_overreads, statistics->protocol_errors,
+		   __atomic_load_n(&ksz8851_test_bus_overlap_count, __ATOMIC_SEQ_CST));
+}
+
+void ksz8851_test_tx_frame(uint8_t *frame, const uint8_t *source)
+{
+	memset(frame, 0, KSZ_TEST_TX_FRAME_SIZE);
+	memset(frame, 0xFF, KSZ_MAC_ADDRR_LEN);
+	memcpy(&frame[KSZ_MAC_ADDRR_LEN], source, KSZ_MAC_ADDRR_LEN);
+	frame[12] = (uint8_t)(KSZ_SIM_ETHERTYPE >> 8);
+	frame[13] = (uint8_t)KSZ_SIM_ETHERTYPE;
+}
+
+uint32_t ksz8851_test_ms(void)
+{
+	struct timespec tmpNow;
+
+	clock_gettime(CLOCK_MONOTONIC, &tmpNow);
+
+	return (uint32_t)(tmpNow.tv_sec * 1000 + tmpNow.tv_nsec / 1000000L);
+}
+
+void ksz8851_test_sleep_ms(uint32_t ms)
+{
+	struct timespec tmpDelay;
+
+	tmpDelay.tv_sec = ms / 1000;
+	tmpDelay.tv_nsec = (long)(ms % 1000) * 1000000L;
+
+	while(nanosleep(&tmpDelay, &tmpDelay) != 0 && errno == EINTR);
+}
+
+void ksz8851_test_fail(const char *file, int line, const char *condition)
+{
+	ksz8851_test_failures++;
+	printf("FAIL %s:%d: %s\n", file, line, condition);
+}
+
+int ksz8851_test_result(const char *name)
+{
+	printf("%s: %s\n", name, ksz8851_test_failures == 0 ? "PASS" : "FAIL");
+
+	return ksz8851_test_failures == 0 ? 0 : 1;
+}
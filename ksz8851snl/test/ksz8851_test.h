@@ -0,0 +1,134 @@
+ /******************************************************************************
+ * @filename	: 	ksz8851_test.h
+ * @description : 	This file provides common fixture of host tests which run the driver against KSZ8851SNL simulator.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KSZ8851_TEST_H
+#define __KSZ8851_TEST_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <semaphore.h>
+#include <stdio.h>
+#include "../ksz8851.h"
+#include "../ksz8851_bus.h"
+#include "../ksz8851_service.h"
+#include "../port/ksz8851_os_posix.h"
+#include "../port/ksz8851_sim_posix.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define KSZ_TEST_CANARY_SIZE									16			//bytes checked behind KSZ_RX_BUFFER_SIZE of each RX buffer
+#define KSZ_TEST_CANARY_VALUE									0xA5
+#define KSZ_TEST_TX_FRAME_SIZE									60			//length of frames sent by tests
+#define KSZ_TEST_CS_PORT										1			//simulated pins, chip select pin of instance n is KSZ_TEST_CS_PIN + n
+#define KSZ_TEST_CS_PIN											1
+#define KSZ_TEST_RST_PORT										2
+#define KSZ_TEST_RST_PIN										1
+
+/* Test fails but keeps running, so one run reports all broken checks */
+#define KSZ_TEST_CHECK(condition)								do { if(!(condition)) ksz8851_test_fail(__FILE__, __LINE__, #condition); } while(0)
+
+/* Structs -------------------------------------------------------------------*/
+
+typedef struct
+{
+	KSZ8851_Sim_t				sim;
+	KSZ8851_Config_t			config;
+	KSZ8851_t					driver;
+	KSZ8851_Service_t			service;
+	bool						use_service;						// driver is served by ksz8851_service task, otherwise by ksz8851_test_chip_irq
+	volatile bool				ready;								// INTRN edges are ignored until driver can serve them
+	sem_t						intrn;								// INTRN edges of ksz8851_test_chip_irq
+
+	/* counters below are written only by driver context (service task or ksz8851_test_chip_irq caller) */
+	uint8_t						rx_buffer[KSZ_RX_BUFFER_SIZE(KSZ_ETH_MAX_FRAME_SIZE) + KSZ_TEST_CANARY_SIZE];
+	uint16_t					rx_length;							// frame length given to RX_GetBuffer
+	bool						rx_started;
+	uint32_t					rx_next_sequence;					// sequence number expected in next generated frame
+	volatile uint32_t			rx_frames;							// frames of RX_FrameReceived
+	volatile uint32_t			rx_bad;								// frames which aren't generated by the simulator or don't match RX_GetBuffer length
+	volatile uint32_t			rx_gaps;							// frames lost between simulated RXQ and application
+	volatile uint32_t			rx_overwrites;						// RX buffers written behind KSZ_RX_BUFFER_SIZE
+	volatile uint32_t			tx_done;							// frames of TX_FrameDone
+
+}KSZ8851_Test_Chip_t;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+* @brief  Starts simulator of an instance, attaches it to bus and initializes driver. With use_service driver is served by
+* 		  ksz8851_service task, otherwise caller serves interrupts by ksz8851_test_chip_irq.
+* @param  chip: instance, it must stay valid until process exits if use_service is set
+* @param  index: instance number, selects chip select pin
+* @param  rx_rate_fps: generated RX frames per second
+* @param  rx_frame_length: length of generated frames without CRC
+* @param  use_service
+* @param  bus: shared spi bus or NULL
+* @retval KSZ_OK, or the first failing status
+*/
+KSZ8851_Status_t ksz8851_test_chip_start(KSZ8851_Test_Chip_t *chip, uint8_t index, uint32_t rx_rate_fps, uint16_t rx_frame_length,
+										 bool use_service, KSZ8851_Bus_t *bus);
+
+/**
+* @brief  Waits an INTRN edge up to timeout_ms and calls ksz8851_irq_handler, like INTRN isr of bare metal applications.
+* @retval true if an edge was served
+*/
+bool ksz8851_test_chip_irq(KSZ8851_Test_Chip_t *chip, uint32_t timeout_ms);
+
+/**
+* @brief  Stops simulator. Driver task of a service has no join, so it's parked on the driver lock and never touches the
+* 		  simulator again.
+*/
+void ksz8851_test_chip_stop(KSZ8851_Test_Chip_t *chip);
+
+/**
+* @brief  Returns sum of simulator counters which are races between interrupt and application context.
+*/
+uint32_t ksz8851_test_violations(const KSZ8851_Sim_Statistics_t *statistics);
+
+/**
+* @brief  Prints simulator statistics of an instance.
+*/
+void ksz8851_test_print_sim(const char *name, const KSZ8851_Sim_Statistics_t *statistics);
+
+/**
+* @brief  Fills a broadcast frame of KSZ_TEST_TX_FRAME_SIZE bytes.
+*/
+void ksz8851_test_tx_frame(uint8_t *frame, const uint8_t *source);
+
+/**
+* @brief  Returns milliseconds of a monotonic clock.
+*/
+uint32_t ksz8851_test_ms(void);
+
+/**
+* @brief  Sleeps ms milliseconds.
+*/
+void ksz8851_test_sleep_ms(uint32_t ms);
+
+/**
+* @brief  Reports a failed KSZ_TEST_CHECK.
+*/
+void ksz8851_test_fail(const char *file, int line, const char *condition);
+
+/**
+* @brief  Prints result of a test program.
+* @retval exit code of main, 0 if no check failed
+*/
+int ksz8851_test_result(const char *name);
+
+#endif /* __KSZ8851_TEST_H */
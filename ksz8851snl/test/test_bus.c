@@ -0,0 +1,185 @@
+ /******************************************************************************
+ * @filename	: 	test_bus.c
+ * @description : 	This file measures TX throughput of 1..n KSZ8851 instances sharing one spi bus, up to KSZ_BUS_CONFIG_MAX_INSTANCES.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* sched_yield is POSIX, not part of ISO C */
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "ksz8851_test.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define TEST_RUN_MS												1000		//send time of each instance count
+#define TEST_DRAIN_MS											500			//time to collect TX done interrupts after sending
+#define TEST_LINK_MBPS											2			//wire of each chip is slower than its share of the spi bus
+#define TEST_WIRE_FPS											(TEST_LINK_MBPS * 1000000UL / ((KSZ_TEST_TX_FRAME_SIZE + KSZ_SIM_WIRE_OVERHEAD) * 8))
+
+/* Private variables ---------------------------------------------------------*/
+static pthread_mutex_t test_bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static KSZ8851_Test_Chip_t test_chips[KSZ_BUS_CONFIG_MAX_INSTANCES];
+
+/* Private functions ---------------------------------------------------------*/
+
+static void test_bus_lock(void *user)
+{
+	(void)user;
+
+	pthread_mutex_lock(&test_bus_mutex);
+}
+
+static void test_bus_unlock(void *user)
+{
+	(void)user;
+
+	pthread_mutex_unlock(&test_bus_mutex);
+}
+
+static void test_bus_yield(void *user)
+{
+	(void)user;
+
+	sched_yield();
+}
+
+/* Application of one instance: sends as fast as TXQ accepts and serves its INTRN in the same thread, like a bare metal main loop */
+static void* test_instance(void *arg)
+{
+	KSZ8851_Test_Chip_t *chip = (KSZ8851_Test_Chip_t*)arg;
+	uint8_t tmpFrame[KSZ_TEST_TX_FRAME_SIZE];
+	uint32_t tmpStart = ksz8851_test_ms();
+
+	ksz8851_test_tx_frame(tmpFrame, chip->config.MAC_address);
+
+	while(ksz8851_test_ms() - tmpStart < TEST_RUN_MS)
+	{
+		if(ksz8851_send_frame(&chip->driver, tmpFrame, sizeof(tmpFrame)) == KSZ_OK)
+			ksz8851_test_chip_irq(chip, 0);
+		else
+			ksz8851_test_chip_irq(chip, 1);
+	}
+
+	tmpStart = ksz8851_test_ms();
+
+	while(chip->tx_done < chip->driver.Statistics.tx_frames && ksz8851_test_ms() - tmpStart < TEST_DRAIN_MS)
+		ksz8851_test_chip_irq(chip, 10);
+
+	return NULL;
+}
+
+static void test_attach_rejects_missing_lock(void)
+{
+	KSZ8851_Bus_t tmpBus;
+	KSZ8851_t tmpDriver;
+	KSZ8851_Bus_Callbacks_t tmpCallbacks = { test_bus_lock, test_bus_unlock, NULL, NULL };
+
+	memset(&tmpDriver, 0, sizeof(tmpDriver));
+
+	tmpCallbacks.Lock = NULL;
+	ksz8851_bus_init(&tmpBus, tmpCallbacks);
+	KSZ_TEST_CHECK(ksz8851_bus_attach(&tmpBus, &tmpDriver, KSZ_BUS_PRIORITY_LOWEST) == KSZ_ERROR);
+	KSZ_TEST_CHECK(tmpDriver.bus == NULL && tmpBus.count == 0);
+
+	tmpCallbacks.Lock = test_bus_lock;
+	tmpCallbacks.Unlock = NULL;
+	ksz8851_bus_init(&tmpBus, tmpCallbacks);
+	KSZ_TEST_CHECK(ksz8851_bus_attach(&tmpBus, &tmpDriver, KSZ_BUS_PRIORITY_LOWEST) == KSZ_ERROR);
+	KSZ_TEST_CHECK(tmpDriver.bus == NULL && tmpBus.count == 0);
+}
+
+/* Runs count instances on one bus, returns transmitted frames per second of all instances */
+static uint32_t test_scaling(uint8_t count)
+{
+	KSZ8851_Bus_t tmpBus;
+	KSZ8851_Bus_Callbacks_t tmpCallbacks = { test_bus_lock, test_bus_unlock, test_bus_yield, NULL };
+	KSZ8851_Sim_Statistics_t tmpStats;
+	pthread_t tmpThreads[KSZ_BUS_CONFIG_MAX_INSTANCES];
+	uint32_t tmpTotal = 0;
+	uint32_t tmpMin = UINT32_MAX;
+	KSZ8851_Status_t result = KSZ_OK;
+	uint8_t i;
+
+	ksz8851_bus_init(&tmpBus, tmpCallbacks);
+
+	for(i = 0; i < count; i++)
+	{
+		result |= ksz8851_test_chip_start(&test_chips[i], i, 0, KSZ_SIM_MIN_FRAME_SIZE, false, &tmpBus);
+		ksz8851_sim_posix_set_link_rate(&test_chips[i].sim, TEST_LINK_MBPS);
+	}
+
+	KSZ_TEST_CHECK(result == KSZ_OK);
+
+	if(result != KSZ_OK)
+		return 0;
+
+	for(i = 0; i < count; i++)
+		pthread_create(&tmpThreads[i], NULL, test_instance, &test_chips[i]);
+
+	for(i = 0; i < count; i++)
+		pthread_join(tmpThreads[i], NULL);
+
+	printf("%u instance(s):\n", count);
+
+	for(i = 0; i < count; i++)
+	{
+		ksz8851_test_chip_stop(&test_chips[i]);
+		ksz8851_sim_posix_statistics(&test_chips[i].sim, &tmpStats);
+
+		printf("  instance %u: %u frames/s, bus grants %u waits %u\n", i, test_chips[i].tx_done * 1000 / TEST_RUN_MS,
+			   tmpBus.grants[i], tmpBus.waits[i]);
+		KSZ_TEST_CHECK(tmpStats.tx_frames == test_chips[i].driver.Statistics.tx_frames);
+		KSZ_TEST_CHECK(test_chips[i].tx_done == tmpStats.tx_frames);
+		KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+
+		tmpTotal += test_chips[i].tx_done;
+		tmpMin = (test_chips[i].tx_done < tmpMin) ? test_chips[i].tx_done : tmpMin;
+	}
+
+	/* Round robin arbiter: no instance gets less than half of an equal share */
+	KSZ_TEST_CHECK(tmpMin > 0 && tmpMin * count * 2 >= tmpTotal);
+
+	printf("  total: %u frames/s\n", tmpTotal * 1000 / TEST_RUN_MS);
+
+	return tmpTotal * 1000 / TEST_RUN_MS;
+}
+
+/* Main ----------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t tmpSingle;
+	uint32_t tmpTotal;
+	uint8_t count;
+
+	test_attach_rejects_missing_lock();
+
+	/* Each chip is limited by its own wire, a transaction holds the bus only while it transfers. A single instance reaches its
+	 * wire rate and the bus adds instances nearly linearly: n chips reach at least 3/4 of n times single instance throughput */
+	tmpSingle = test_scaling(1);
+	KSZ_TEST_CHECK(tmpSingle * 10 >= TEST_WIRE_FPS * 9);
+
+	for(count = 2; count <= KSZ_BUS_CONFIG_MAX_INSTANCES; count++)
+	{
+		tmpTotal = test_scaling(count);
+		KSZ_TEST_CHECK(tmpTotal * 4 >= tmpSingle * count * 3);
+	}
+
+	return ksz8851_test_result("test_bus");
+}
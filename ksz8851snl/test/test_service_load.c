@@ -0,0 +1,142 @@
+ /******************************************************************************
+ * @filename	: 	test_service_load.c
+ * @description : 	This file loads ksz8851_service with concurrent sender tasks and an RX flood from KSZ8851SNL simulator.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include "ksz8851_test.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define TEST_SENDERS											3			//last sender uses ksz8851_service_enqueue, others ksz8851_service_send
+#define TEST_LOAD_MS											2000
+#define TEST_RX_FLOOD_FPS										1000		//RX load while senders keep TXQ full
+#define TEST_RX_MIN_DELIVERED_PERCENT							90			//share of generated frames delivered to user, rest may overrun RXQ
+#define TEST_RX_FRAME_LENGTH									256
+#define TEST_DRAIN_MS											2000		//time to read frames left in simulated RXQ and to send queued frames
+
+/* Private variables ---------------------------------------------------------*/
+static KSZ8851_Test_Chip_t test_chip;
+
+typedef struct
+{
+	bool					enqueue;								// ksz8851_service_enqueue, otherwise ksz8851_service_send
+	uint8_t					frame[KSZ_TEST_TX_FRAME_SIZE];			// enqueued frames refer to it until TX_BufferReleased, it never changes
+	uint32_t				accepted;
+
+}Test_Sender_t;
+
+static Test_Sender_t test_senders[TEST_SENDERS];
+
+/* Private functions ---------------------------------------------------------*/
+
+static void* test_sender(void *arg)
+{
+	Test_Sender_t *sender = (Test_Sender_t*)arg;
+	uint32_t tmpStart = ksz8851_test_ms();
+	KSZ8851_Status_t tmpStatus;
+
+	while(ksz8851_test_ms() - tmpStart < TEST_LOAD_MS)
+	{
+		if(sender->enqueue)
+			tmpStatus = ksz8851_service_enqueue(&test_chip.service, 0, sender->frame, sizeof(sender->frame));
+		else
+			tmpStatus = ksz8851_service_send(&test_chip.service, sender->frame, sizeof(sender->frame));
+
+		if(tmpStatus == KSZ_OK)
+			sender->accepted++;
+		else
+			ksz8851_test_sleep_ms(1);
+	}
+
+	return NULL;
+}
+
+/* Main ----------------------------------------------------------------------*/
+
+int main(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+	pthread_t tmpThreads[TEST_SENDERS];
+	uint32_t tmpAccepted = 0;
+	uint32_t tmpStart;
+	uint8_t i;
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&test_chip, 0, 0, TEST_RX_FRAME_LENGTH, true, NULL) == KSZ_OK);
+
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, TEST_RX_FLOOD_FPS);
+
+	for(i = 0; i < TEST_SENDERS; i++)
+	{
+		test_senders[i].enqueue = (i == TEST_SENDERS - 1);
+		ksz8851_test_tx_frame(test_senders[i].frame, test_chip.config.MAC_address);
+		pthread_create(&tmpThreads[i], NULL, test_sender, &test_senders[i]);
+	}
+
+	for(i = 0; i < TEST_SENDERS; i++)
+	{
+		pthread_join(tmpThreads[i], NULL);
+		tmpAccepted += test_senders[i].accepted;
+	}
+
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, 0);
+
+	/* Driver task sends queued frames and empties RXQ after the load */
+	tmpStart = ksz8851_test_ms();
+
+	while(ksz8851_test_ms() - tmpStart < TEST_DRAIN_MS)
+	{
+		ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+
+		if(test_chip.tx_done == tmpAccepted &&
+		   tmpStats.rx_delivered + tmpStats.rx_released + tmpStats.rx_overruns == tmpStats.rx_generated)
+			break;
+
+		ksz8851_test_sleep_ms(10);
+	}
+
+	ksz8851_test_chip_stop(&test_chip);
+	ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+
+	printf("senders: %u / %u / %u frames accepted (send, send, enqueue), %u frames/s transmitted\n", test_senders[0].accepted,
+		   test_senders[1].accepted, test_senders[2].accepted, tmpStats.tx_frames * 1000 / TEST_LOAD_MS);
+	printf("rx flood: %u frames/s offered, %u frames/s received, %u overruns\n", TEST_RX_FLOOD_FPS,
+		   test_chip.rx_frames * 1000 / TEST_LOAD_MS, tmpStats.rx_overruns);
+	printf("service: %u irq signals, %u services, %u timeouts\n", test_chip.service.irq_count, test_chip.service.service_count,
+		   test_chip.service.timeout_count);
+	ksz8851_test_print_sim("load", &tmpStats);
+
+	/* Every sender makes progress while the driver task is busy with RX */
+	for(i = 0; i < TEST_SENDERS; i++)
+		KSZ_TEST_CHECK(test_senders[i].accepted > 0);
+
+	/* Serialized driver calls: no race reaches the chip, no frame is lost or corrupted behind the simulator */
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+	KSZ_TEST_CHECK(tmpStats.tx_overflows == 0);
+	KSZ_TEST_CHECK(tmpStats.tx_frames == tmpAccepted);
+	KSZ_TEST_CHECK(test_chip.tx_done == tmpAccepted);
+	KSZ_TEST_CHECK(test_chip.rx_frames == tmpStats.rx_delivered);
+
+	/* Driver task keeps up with RX while serving senders, only a few frames may overrun RXQ under TX load */
+	KSZ_TEST_CHECK(tmpStats.rx_generated > 0 && tmpStats.rx_delivered * 100 >= tmpStats.rx_generated * TEST_RX_MIN_DELIVERED_PERCENT);
+	KSZ_TEST_CHECK(tmpStats.rx_delivered + tmpStats.rx_released + tmpStats.rx_overruns == tmpStats.rx_generated);
+	KSZ_TEST_CHECK(test_chip.rx_bad == 0);
+	KSZ_TEST_CHECK(test_chip.rx_gaps == 0);
+	KSZ_TEST_CHECK(test_chip.rx_overwrites == 0);
+
+	return ksz8851_test_result("test_service_load");
+}
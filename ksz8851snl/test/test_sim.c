@@ -0,0 +1,293 @@
+ /******************************************************************************
+ * @filename	: 	test_sim.c
+ * @description : 	This file runs the driver against KSZ8851SNL simulator: init, TX, RX and two contending threads.
+ * @author      : 	M.Okan BUĞDAYCI
+ * @copyright   : 	GNU licence.
+ * @date        : 	01.05.2020
+ * @revision	: 	v.1.0.0 - Driver files created
+
+ This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/
+
+ ******************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include "ksz8851_test.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define TEST_TX_FRAMES											20			//frames of TX test
+#define TEST_RX_RATE_FPS										50			//generated frames per second of RX test, below driver limit
+#define TEST_RX_FRAME_LENGTH									60			//dword aligned frame, its CRC and fifo padding end behind the frame
+#define TEST_RX_MS												1000
+#define TEST_CONTENTION_MS										1000
+#define TEST_CONTENTION_RX_FPS									100
+#define TEST_DRAIN_MS											500			//time to read frames left in simulated RXQ
+#define TEST_TIMEOUT_MS											2000
+#define TEST_WAKEUP_CRC_CHECK									0x9B63D02C	//CRC-32 check value 0xCBF43926 of "123456789", not inverted and bit reversed
+#define TEST_PEEK_FRAME_LENGTH									(KSZ_RX_CONFIG_PEEK_SIZE - 6)	//frame ends inside RX_PeekFrame header, it isn't dword aligned
+
+/* Private variables ---------------------------------------------------------*/
+static KSZ8851_Test_Chip_t test_chip;
+static KSZ8851_Test_Chip_t test_raw_chip;
+static KSZ8851_Test_Chip_t test_peek_chip;
+static KSZ8851_Test_Chip_t test_wakeup_chip;
+static uint32_t test_peeks;
+static uint32_t test_peeks_bad;											//headers which aren't the whole short frame
+
+typedef struct
+{
+	KSZ8851_Test_Chip_t		*chip;
+	bool					serialized;								// send through ksz8851_service_send, otherwise call driver directly
+	uint32_t				sent;
+
+}Test_Sender_t;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void* test_sender(void *arg)
+{
+	Test_Sender_t *sender = (Test_Sender_t*)arg;
+	uint8_t tmpFrame[KSZ_TEST_TX_FRAME_SIZE];
+	uint32_t tmpEnd = ksz8851_test_ms() + TEST_CONTENTION_MS;
+	KSZ8851_Status_t tmpStatus;
+
+	ksz8851_test_tx_frame(tmpFrame, sender->chip->config.MAC_address);
+
+	while((int32_t)(tmpEnd - ksz8851_test_ms()) > 0)
+	{
+		if(sender->serialized)
+			tmpStatus = ksz8851_service_send(&sender->chip->service, tmpFrame, sizeof(tmpFrame));
+		else
+			tmpStatus = ksz8851_send_frame(&sender->chip->driver, tmpFrame, sizeof(tmpFrame));
+
+		if(tmpStatus == KSZ_OK)
+			sender->sent++;
+		else
+			ksz8851_test_sleep_ms(1);
+	}
+
+	return NULL;
+}
+
+static void test_wait_tx(KSZ8851_Test_Chip_t *chip, uint32_t frames)
+{
+	uint32_t tmpStart = ksz8851_test_ms();
+
+	while(chip->tx_done < frames && ksz8851_test_ms() - tmpStart < TEST_TIMEOUT_MS)
+		ksz8851_test_sleep_ms(10);
+}
+
+static void test_init(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&test_chip, 0, 0, TEST_RX_FRAME_LENGTH, true, NULL) == KSZ_OK);
+
+	ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+}
+
+static void test_tx(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+	uint8_t tmpFrame[KSZ_TEST_TX_FRAME_SIZE];
+	uint32_t i;
+
+	ksz8851_test_tx_frame(tmpFrame, test_chip.config.MAC_address);
+
+	for(i = 0; i < TEST_TX_FRAMES; i++)
+	{
+		while(ksz8851_service_send(&test_chip.service, tmpFrame, sizeof(tmpFrame)) == KSZ_BUSY)
+			ksz8851_test_sleep_ms(1);
+	}
+
+	test_wait_tx(&test_chip, TEST_TX_FRAMES);
+
+	ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+	printf("tx: %u frames sent, %u done\n", TEST_TX_FRAMES, test_chip.tx_done);
+	KSZ_TEST_CHECK(tmpStats.tx_frames == TEST_TX_FRAMES);
+	KSZ_TEST_CHECK(tmpStats.tx_overflows == 0);
+	KSZ_TEST_CHECK(test_chip.tx_done == TEST_TX_FRAMES);
+	KSZ_TEST_CHECK(test_chip.driver.Statistics.tx_frames == TEST_TX_FRAMES);
+}
+
+static void test_rx(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, TEST_RX_RATE_FPS);
+	ksz8851_test_sleep_ms(TEST_RX_MS);
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, 0);
+	ksz8851_test_sleep_ms(TEST_DRAIN_MS);
+
+	ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+	printf("rx: %u frames generated, %u received\n", tmpStats.rx_generated, test_chip.rx_frames);
+	KSZ_TEST_CHECK(tmpStats.rx_generated >= TEST_RX_RATE_FPS * TEST_RX_MS / 1000 / 2);
+	KSZ_TEST_CHECK(tmpStats.rx_overruns == 0);
+	KSZ_TEST_CHECK(test_chip.rx_frames == tmpStats.rx_generated);
+	KSZ_TEST_CHECK(test_chip.rx_frames == tmpStats.rx_delivered);
+	KSZ_TEST_CHECK(test_chip.rx_bad == 0);
+	KSZ_TEST_CHECK(test_chip.rx_gaps == 0);
+	KSZ_TEST_CHECK(test_chip.rx_overwrites == 0);
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+}
+
+/* Application thread sends while driver task serves RX: every driver call is serialized by service lock */
+static void test_contention(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+	Test_Sender_t tmpSender = { &test_chip, true, 0 };
+	uint32_t tmpTxDone = test_chip.tx_done;
+	uint32_t tmpRxFrames = test_chip.rx_frames;
+	pthread_t tmpThread;
+
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, TEST_CONTENTION_RX_FPS);
+	pthread_create(&tmpThread, NULL, test_sender, &tmpSender);
+	pthread_join(tmpThread, NULL);
+	ksz8851_sim_posix_set_rx_rate(&test_chip.sim, 0);
+	ksz8851_test_sleep_ms(TEST_DRAIN_MS);
+	test_wait_tx(&test_chip, tmpTxDone + tmpSender.sent);
+
+	ksz8851_sim_posix_statistics(&test_chip.sim, &tmpStats);
+	printf("contention: %u frames sent, %u done, %u received\n", tmpSender.sent, test_chip.tx_done - tmpTxDone,
+		   test_chip.rx_frames - tmpRxFrames);
+	ksz8851_test_print_sim("serialized", &tmpStats);
+	KSZ_TEST_CHECK(tmpSender.sent > 0);
+	KSZ_TEST_CHECK(test_chip.rx_frames > tmpRxFrames);
+	KSZ_TEST_CHECK(test_chip.tx_done == tmpTxDone + tmpSender.sent);
+	KSZ_TEST_CHECK(tmpStats.tx_frames == test_chip.tx_done);
+	KSZ_TEST_CHECK(test_chip.rx_frames == tmpStats.rx_delivered);
+	KSZ_TEST_CHECK(test_chip.rx_bad == 0);
+	KSZ_TEST_CHECK(test_chip.rx_gaps == 0);
+	KSZ_TEST_CHECK(test_chip.rx_overwrites == 0);
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+
+	ksz8851_test_chip_stop(&test_chip);
+}
+
+/* Same load with application thread calling driver directly, simulator must see the races service lock prevents */
+static void test_contention_unserialized(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+	Test_Sender_t tmpSender = { &test_raw_chip, false, 0 };
+	pthread_t tmpThread;
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&test_raw_chip, 1, TEST_CONTENTION_RX_FPS, TEST_RX_FRAME_LENGTH, true, NULL) == KSZ_OK);
+
+	pthread_create(&tmpThread, NULL, test_sender, &tmpSender);
+	pthread_join(tmpThread, NULL);
+
+	ksz8851_test_chip_stop(&test_raw_chip);
+
+	ksz8851_sim_posix_statistics(&test_raw_chip.sim, &tmpStats);
+	ksz8851_test_print_sim("unserialized", &tmpStats);
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) > 0);
+}
+
+/* RX_PeekFrame of test_rx_short_peek: header of a frame shorter than KSZ_RX_CONFIG_PEEK_SIZE is the whole frame */
+static bool test_peek_frame(void *user, const uint8_t *pHeader, uint16_t headerLength, uint16_t frameLength)
+{
+	(void)user;
+
+	test_peeks++;
+
+	if(headerLength != frameLength || ((pHeader[KSZ_ETH_TYPE_OFFSET] << 8) | pHeader[KSZ_ETH_TYPE_OFFSET + 1]) != KSZ_SIM_ETHERTYPE)
+		test_peeks_bad++;
+
+	return true;
+}
+
+/* Frames shorter than peek header: peek stops at the end of frame stream and the rest of frame is empty, nothing is read behind it */
+static void test_rx_short_peek(void)
+{
+	KSZ8851_Sim_Statistics_t tmpStats;
+	uint32_t tmpStart;
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&test_peek_chip, 2, 0, TEST_PEEK_FRAME_LENGTH, false, NULL) == KSZ_OK);
+
+	/* Driver refers to the config, so peek is enabled for the following frames */
+	test_peek_chip.config.functions.RX_PeekFrame = test_peek_frame;
+
+	ksz8851_sim_posix_set_rx_rate(&test_peek_chip.sim, TEST_RX_RATE_FPS);
+	tmpStart = ksz8851_test_ms();
+
+	while(ksz8851_test_ms() - tmpStart < TEST_RX_MS)
+		ksz8851_test_chip_irq(&test_peek_chip, 10);
+
+	ksz8851_sim_posix_set_rx_rate(&test_peek_chip.sim, 0);
+	tmpStart = ksz8851_test_ms();
+
+	while(ksz8851_test_ms() - tmpStart < TEST_DRAIN_MS)
+		ksz8851_test_chip_irq(&test_peek_chip, 10);
+
+	ksz8851_test_chip_stop(&test_peek_chip);
+	ksz8851_sim_posix_statistics(&test_peek_chip.sim, &tmpStats);
+
+	printf("short peek: %u byte frames, %u generated, %u peeked, %u received\n", TEST_PEEK_FRAME_LENGTH, tmpStats.rx_generated,
+		   test_peeks, test_peek_chip.rx_frames);
+	KSZ_TEST_CHECK(tmpStats.rx_generated > 0);
+	KSZ_TEST_CHECK(test_peek_chip.rx_frames == tmpStats.rx_generated);
+	KSZ_TEST_CHECK(test_peek_chip.rx_frames == tmpStats.rx_delivered);
+	KSZ_TEST_CHECK(test_peeks == tmpStats.rx_generated && test_peeks_bad == 0);
+	KSZ_TEST_CHECK(test_peek_chip.driver.Statistics.rx_bytes ==
+				   test_peek_chip.rx_frames * (KSZ_RX_FIFO_PREAMBLE_SIZE + KSZ_RX_BUFFER_SIZE(TEST_PEEK_FRAME_LENGTH)));
+	KSZ_TEST_CHECK(test_peek_chip.rx_bad == 0);
+	KSZ_TEST_CHECK(test_peek_chip.rx_gaps == 0);
+	KSZ_TEST_CHECK(test_peek_chip.rx_overwrites == 0);
+	KSZ_TEST_CHECK(ksz8851_test_violations(&tmpStats) == 0);
+}
+
+/* Wake-up frame CRC of ksz8851_wakeup_set_filter against a known vector, masked out bytes don't take part in it */
+static void test_wakeup_crc(void)
+{
+	static const uint8_t tmpCheck[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	static const uint8_t tmpInterleaved[] = { '1', 0, '2', 0, '3', 0, '4', 0, '5', 0, '6', 0, '7', 0, '8', 0, '9' };
+	static const uint8_t tmpMask[] = { 0x55, 0x55, 0x01 };
+	KSZ8851_WakeUp_Pattern_t tmpPattern = { 0, sizeof(tmpCheck), tmpCheck, NULL };
+	uint16_t *regs = test_wakeup_chip.sim.regs;
+	uint8_t tmpFilter[2];
+
+	KSZ_TEST_CHECK(ksz8851_test_chip_start(&test_wakeup_chip, 3, 0, TEST_RX_FRAME_LENGTH, false, NULL) == KSZ_OK);
+
+	KSZ_TEST_CHECK(ksz8851_wakeup_set_filter(&test_wakeup_chip.driver, &tmpPattern, &tmpFilter[0]) == KSZ_OK);
+
+	tmpPattern.offset = KSZ_ETH_HEADER_SIZE;
+	tmpPattern.length = sizeof(tmpInterleaved);
+	tmpPattern.bytes = tmpInterleaved;
+	tmpPattern.mask = tmpMask;
+	KSZ_TEST_CHECK(ksz8851_wakeup_set_filter(&test_wakeup_chip.driver, &tmpPattern, &tmpFilter[1]) == KSZ_OK);
+
+	ksz8851_test_chip_stop(&test_wakeup_chip);
+
+	KSZ_TEST_CHECK(tmpFilter[0] == 0 && tmpFilter[1] == 1);
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0CRC0_0)] == (uint16_t)TEST_WAKEUP_CRC_CHECK);
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0CRC1_0)] == (uint16_t)(TEST_WAKEUP_CRC_CHECK >> 16));
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0CRC0_0 + KSZ_WAKEUP_FRAME_REG_SPACING)] == (uint16_t)TEST_WAKEUP_CRC_CHECK);
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0CRC1_0 + KSZ_WAKEUP_FRAME_REG_SPACING)] == (uint16_t)(TEST_WAKEUP_CRC_CHECK >> 16));
+
+	/* Byte mask of the second filter selects the digits at frame bytes 14, 16 .. 30 */
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0BM0_0 + KSZ_WAKEUP_FRAME_REG_SPACING)] == 0x4000);
+	KSZ_TEST_CHECK(regs[KSZ_REG_DESCRIPTOR_INDEX(KSZ_REG_ADDR_WF0BM1_0 + KSZ_WAKEUP_FRAME_REG_SPACING)] == 0x5555);
+}
+
+/* Main ----------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_init();
+	test_tx();
+	test_rx();
+	test_contention();
+	test_contention_unserialized();
+	test_rx_short_peek();
+	test_wakeup_crc();
+
+	return ksz8851_test_result("test_sim");
+}